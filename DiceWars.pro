@@ -3,4 +3,7 @@ TEMPLATE = subdirs
 CONFIG += ordered
 
 SUBDIRS = app \
-    tests
+    tests \
+    tests/engine \
+    benchmarks \
+    tools
@@ -2,7 +2,10 @@ TEMPLATE = app
 
 TARGET = DiceWars
 
-QT += qml quick
+QT += qml quick network concurrent
+
+# QML files are compiled when building, so starting the game does not parse nor compile them
+CONFIG += qtquickcompiler
 
 # Additional import path used to resolve QML modules in Qt Creator's code model
 QML_IMPORT_PATH =
@@ -11,9 +14,13 @@ SOURCES += \
     src/main.cpp \
     src/hexgrid.cpp \
     src/hex.cpp \
+    src/hexlayer.cpp \
     src/territory.cpp \
     src/player.cpp \
-    src/diceroll.cpp
+    src/diceroll.cpp \
+    src/lockstepsession.cpp \
+    src/gameengine.cpp \
+    src/resourcecache.cpp
 
 RESOURCES += \
     qml/qml.qrc \
@@ -23,10 +30,15 @@ RESOURCES += \
 HEADERS += \
     src/hexgrid.h \
     src/hex.h \
+    src/hexlayer.h \
     src/territory.h \
     src/player.h \
-    src/diceroll.h
+    src/diceroll.h \
+    src/lockstepsession.h \
+    src/gameengine.h \
+    src/resourcecache.h
 
+include(../engine/engine.pri)
 
 # Default rules for deployment.
 include(deployment.pri)
@@ -16,6 +16,24 @@ Rectangle {
     property int numPlayers: 8;
     property var humanList: [true, false, false, false, false, false, false, false];
 
+    /// Board presets. The board can be much larger than the screen, as it can be zoomed and panned
+    property int gridWidth: 60;
+    property int gridHeight: 40;
+    property real cellRadius: 10;
+    property int numTerritories: 80;
+    property int territorySize: 25;
+
+    /// How the boards are generated: "growth", "grid", "voronoi" or "flood"
+    property string mapGenerator: "growth";
+
+    /// Starts the first game with the given players. It is called by the Loader once this item is created, as
+    /// a Loader cannot pass initial properties to a preloaded component
+    function start(players, humans) {
+        numPlayers = players;
+        humanList = humans;
+        hexGrid.restartGame();
+    }
+
     color: "white";
 
     /// The board of the game itself
@@ -26,19 +44,20 @@ Rectangle {
         anchors.topMargin: 50;
         anchors.leftMargin: 50;
 
-        gridWidth: 60;
-        gridHeight: 40;
-        radius: 10;
+        gridWidth: parent.gridWidth;
+        gridHeight: parent.gridHeight;
+        radius: parent.cellRadius;
 
         numPlayers: parent.numPlayers;
         humanList: parent.humanList;
 
-        numTerritories: 80;
-        territorySize: 25;
+        numTerritories: parent.numTerritories;
+        territorySize: parent.territorySize;
+        generator: parent.mapGenerator;
 
-        Component.onCompleted: {
-            restartGame();
-        }
+        mapLibrary: mapLibraryPath;
+        telemetryFile: telemetryPath;
+        session: lockstep;
 
         onShowAttackResult: {
             statusMessage.text = attack + " vs " + defense + ((attack > defense) ? " - VICTORY!" : " - Defeat...");
@@ -76,6 +95,10 @@ Rectangle {
             gameContents.victory(player, human);
         }
 
+        onDesync: {
+            statusMessage.text = "Out of sync with the other player at turn " + turn;
+        }
+
         function restartGame() {
             initializeGrid();
             for (var i = 0; i < hexGrid.numPlayers; i++)
@@ -83,14 +106,46 @@ Rectangle {
         }
     }
 
+    /// Shown while the map of a new game is generated in the background
+    ProgressBar {
+        anchors.centerIn: hexGrid;
+        width: 300;
+
+        visible: hexGrid.generating;
+        value: hexGrid.generationProgress;
+    }
+
     /// Simple MouseArea covering the game board to detect all clicks and pass
-    /// them through the board itself
+    /// them through the board itself. Dragging pans the board and the wheel zooms it
     MouseArea {
         anchors.fill: hexGrid;
 
+        property point lastPosition;
+        property bool dragging: false;
+
+        onPressed: {
+            lastPosition = Qt.point(mouse.x, mouse.y);
+            dragging = false;
+        }
+
+        onPositionChanged: {
+            var dx = mouse.x - lastPosition.x;
+            var dy = mouse.y - lastPosition.y;
+            // Small movements while clicking should not be considered as a drag
+            if (!dragging && Math.abs(dx) + Math.abs(dy) < 8) return;
+            dragging = true;
+            hexGrid.panBy(dx, dy);
+            lastPosition = Qt.point(mouse.x, mouse.y);
+        }
+
         onClicked: {
+            if (dragging) return;
             hexGrid.processClick(mouse.x, mouse.y);
         }
+
+        onWheel: {
+            hexGrid.zoomAt(wheel.x, wheel.y, Math.pow(1.002, wheel.angleDelta.y));
+        }
     }
 
     /// Text block containing useful tips and messages depending on the game status
@@ -412,7 +467,7 @@ Rectangle {
     }
 
     /// This controls the game speed. If too fast, it becomes clear that CPU
-    /// struggles to keep up
+    /// struggles to keep up. At the very end, the AI plays without any delay
     Slider {
         id: sldSpeed;
 
@@ -428,7 +483,10 @@ Rectangle {
 
         value: 0;
 
-        onValueChanged: hexGrid.gameSpeed = Math.pow(10, value);
+        onValueChanged: {
+            hexGrid.gameSpeed = Math.pow(10, value);
+            hexGrid.instant = value >= maximumValue;
+        }
     }
 
     /// Label showing the game speed next to the control above
@@ -25,12 +25,6 @@ Rectangle {
         fillMode: Image.PreserveAspectCrop;
     }
 
-    FontLoader {
-        id: titleFont;
-        source: "qrc:///fonts/unlearn2.ttf"
-        onStatusChanged: console.log(status);
-    }
-
     Text {
         id: txtTitle;
 
@@ -49,7 +43,9 @@ Rectangle {
         font.pointSize: 140;
         color: "black";
 
-        font.family: titleFont.name;
+        // The font is registered by the resource cache once decoded, which is usually before the first frame
+        font.family: resources.titleFont;
+        visible: resources.titleFont !== "";
     }
 
     Text {
@@ -66,7 +62,8 @@ Rectangle {
 
         font.pointSize: 30;
         font.bold: false;
-        font.family: titleFont.name;
+        font.family: resources.titleFont;
+        visible: txtTitle.visible;
     }
 
     Text {
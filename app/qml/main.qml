@@ -18,11 +18,45 @@ Window {
     property int numPlayers : 8;
     property var humanList: [true, false, false, false, false, false, false, false];
 
+    /// Game.qml is compiled in the background while the menu is shown, so starting a game only has to
+    /// instantiate it
+    property var gameComponent: null;
+
+    /// Whether a game was started before its component finished compiling
+    property bool gameRequested: false;
+
     Loader {
         id: contentLoader;
 
         anchors.fill: parent;
         source: "qrc:/Menu.qml";
+
+        onLoaded: {
+            if (sourceComponent === gameComponent) item.start(mainWindow.numPlayers, mainWindow.humanList);
+        }
+    }
+
+    /// Shows the game with the preloaded component, or as soon as it is ready if it is still compiling
+    function loadGame() {
+        gameRequested = gameComponent.status === Component.Loading;
+        if (gameRequested) return;
+
+        if (gameComponent.status === Component.Error) console.warn(gameComponent.errorString());
+        contentLoader.sourceComponent = gameComponent;
+    }
+
+    Connections {
+        target: mainWindow.gameComponent;
+
+        onStatusChanged: {
+            if (mainWindow.gameRequested) mainWindow.loadGame();
+        }
+    }
+
+    Component.onCompleted: {
+        // The menu is loaded synchronously so that it is in the first frame; anything after it is not
+        contentLoader.asynchronous = true;
+        gameComponent = Qt.createComponent("qrc:/Game.qml", Component.Asynchronous);
     }
 
     /// This holds different actions that the main menu or the game need to pass
@@ -36,12 +70,7 @@ Window {
         onStart: {
             mainWindow.numPlayers = numPlayers;
             mainWindow.humanList = humanList;
-            contentLoader.setSource(
-                        "qrc:/Game.qml",
-                        {
-                            "numPlayers": numPlayers,
-                            "humanList": humanList
-                        });
+            mainWindow.loadGame();
         }
 
         onRestart: {
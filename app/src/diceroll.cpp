@@ -1,97 +1,275 @@
 #include "diceroll.h"
 
 #include "player.h"
+#include "resourcecache.h"
+#include "rules.h"
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QPainter>
+#include <QQuickWindow>
+#include <QSGSimpleTextureNode>
+#include <QtMath>
 
-DiceRoll::DiceRoll(QQuickItem* parent) : QQuickPaintedItem(parent)
+namespace
 {
+    /// Plays the animation of the rolls on the render thread. The item only copies a new roll into it while the
+    /// GUI thread is blocked for the synchronisation; from then on, every frame is requested from preprocess()
+    /// until the dice settle
+    class DiceRollNode final : public QSGNode
+    {
+        QQuickWindow *window_;
+        std::shared_ptr<std::atomic<int>> settled_;
+
+        /// The faces of the dice of every player, created the first time they are rolled
+        QHash<int, QSGTexture *> textures_;
+
+        DiceRoll::Side sides_[2];
+        QVector<QSGSimpleTextureNode *> dice_[2];
+        QSGSimpleTextureNode *scores_[2] = {};
+
+        /// Where the dice rest on each side, as laid out by the item
+        QVector<QRectF> rects_[2];
+        QRectF scoreRects_[2];
+
+        int roll_ = 0;
+        int duration_ = 0;
+        bool animating_ = false;
+        QElapsedTimer clock_;
+
+        /// Number of times the faces change during a roll, more and more slowly
+        static constexpr int TUMBLES = 9;
+
+        /// Times each die bounces and how high the first bounce goes, in pixels
+        static constexpr int BOUNCES = 3;
+        static constexpr qreal BOUNCE_HEIGHT = 12;
+
+        QSGTexture *texture(const DiceRoll::Side &side, int face)
+        {
+            const auto key = side.player * StandardRules::DICE_SIDES + face - 1;
+            auto texture = textures_.value(key);
+            if (!texture)
+            {
+                texture = window_->createTextureFromImage(side.faces.value(face - 1));
+                textures_.insert(key, texture);
+            }
+            return texture;
+        }
+
+        /// A face that looks random, but is the same in every frame of the same step of the roll
+        static int tumblingFace(int roll, int die, int step)
+        {
+            auto hash = static_cast<quint32>(roll) * 0x9e3779b9u ^ static_cast<quint32>(die) * 0x85ebca6bu ^ static_cast<quint32>(step) * 0xc2b2ae35u;
+            hash ^= hash >> 15;
+            hash *= 0x2c1b3c6du;
+            hash ^= hash >> 12;
+            return 1 + static_cast<int>(hash % StandardRules::DICE_SIDES);
+        }
+
+        /// Shows the roll at the given fraction of its duration, 1 being the dice settled
+        void show(qreal progress)
+        {
+            // The faces change quickly at first and slow down as the dice settle
+            const auto eased = 1 - (1 - progress) * (1 - progress);
+            const auto step = static_cast<int>(eased * TUMBLES);
+            const auto bounce = BOUNCE_HEIGHT * (1 - progress) * qAbs(qSin(progress * M_PI * BOUNCES));
+
+            for (auto side = 0; side < 2; side++)
+            {
+                const auto &dice = sides_[side].dice;
+                for (auto i = 0; i < dice.size(); i++)
+                {
+                    const auto face = progress < 1 ? tumblingFace(roll_, side * 64 + i, step) : dice.at(i);
+                    const auto node = dice_[side].at(i);
+                    const auto faceTexture = texture(sides_[side], face);
+                    if (node->texture() != faceTexture) node->setTexture(faceTexture);
+
+                    // Neighbouring dice bounce slightly out of phase
+                    const auto offset = progress < 1 ? bounce * (1 - 0.15 * (i % 3)) : 0;
+                    node->setRect(rects_[side].at(i).translated(0, -offset));
+                }
+
+                if (scores_[side]) scores_[side]->setRect(progress < 1 ? QRectF() : scoreRects_[side]);
+            }
+        }
+
+        void clear()
+        {
+            for (auto side = 0; side < 2; side++)
+            {
+                qDeleteAll(dice_[side]);
+                dice_[side].clear();
+                delete scores_[side];
+                scores_[side] = nullptr;
+            }
+            removeAllChildNodes();
+        }
+
+    public:
+        DiceRollNode(QQuickWindow *window, std::shared_ptr<std::atomic<int>> settled)
+            : window_(window), settled_(std::move(settled))
+        {
+            setFlag(UsePreprocess);
+        }
+
+        ~DiceRollNode() override
+        {
+            clear();
+            qDeleteAll(textures_);
+        }
+
+        int roll() const { return roll_; }
+
+        void start(int roll, int duration, const DiceRoll::Side *sides, const QRectF &bounds)
+        {
+            clear();
+            roll_ = roll;
+            duration_ = duration;
+
+            const auto centerX = bounds.center().x();
+            const auto top = bounds.center().y() - 0.5 * DiceRoll::DICE_SIZE;
+            const auto step = DiceRoll::DICE_SIZE + DiceRoll::DICE_SPACING;
+            for (auto side = 0; side < 2; side++)
+            {
+                sides_[side] = sides[side];
+                rects_[side].clear();
+                if (sides_[side].player < 0) continue;
+
+                // The left dice go leftwards from the center, the right ones rightwards
+                const auto count = sides_[side].dice.size();
+                for (auto i = 0; i < count; i++)
+                {
+                    const auto x = side == 0 ? centerX - DiceRoll::FIRST_SPACING - step * (i + 1) : centerX + DiceRoll::FIRST_SPACING + step * i;
+                    rects_[side].append(QRectF(x, top, DiceRoll::DICE_SIZE, DiceRoll::DICE_SIZE));
+
+                    auto node = new QSGSimpleTextureNode();
+                    node->setFiltering(QSGTexture::Linear);
+                    node->setFlag(OwnedByParent, false);
+                    dice_[side].append(node);
+                    appendChildNode(node);
+                }
+
+                const auto scoreX = side == 0 ? centerX - DiceRoll::FIRST_SPACING - step * count - DiceRoll::DICE_SPACING - DiceRoll::SCORE_WIDTH
+                                              : centerX + DiceRoll::FIRST_SPACING + step * count;
+                scoreRects_[side] = QRectF(scoreX, bounds.center().y() - 0.5 * DiceRoll::SCORE_HEIGHT, DiceRoll::SCORE_WIDTH, DiceRoll::SCORE_HEIGHT);
+                if (!sides_[side].score.isNull())
+                {
+                    scores_[side] = new QSGSimpleTextureNode();
+                    scores_[side]->setTexture(window_->createTextureFromImage(sides_[side].score));
+                    scores_[side]->setOwnsTexture(true);
+                    scores_[side]->setFlag(OwnedByParent, false);
+                    appendChildNode(scores_[side]);
+                }
+            }
+
+            animating_ = duration_ >= DiceRoll::MIN_ANIMATION;
+            clock_.start();
+            show(animating_ ? 0 : 1);
+            if (!animating_) settled_->store(roll_);
+        }
+
+        void preprocess() override
+        {
+            if (!animating_) return;
+
+            const auto progress = qMin<qreal>(1, static_cast<qreal>(clock_.elapsed()) / duration_);
+            show(progress);
+            if (progress < 1)
+            {
+                // Called from the render thread, this renders another frame without synchronising with the GUI thread
+                window_->update();
+                return;
+            }
+
+            animating_ = false;
+            settled_->store(roll_);
+        }
+    };
 }
 
-void DiceRoll::paint(QPainter *painter)
+DiceRoll::DiceRoll(QQuickItem* parent)
+    : QQuickItem(parent), settled_(std::make_shared<std::atomic<int>>(0))
 {
-    const auto centerX = 0.5 * width();
-    const auto centerY = 0.5 * height();
+    setFlag(ItemHasContents);
+}
 
-    /// Size of each dice in pixels
-    static constexpr auto DICE_SIZE = 30;
+void DiceRoll::reset()
+{
+    sides_[0] = Side();
+    sides_[1] = Side();
 
-    /// Spacing between dice in pixels
-    static constexpr auto DICE_SPACING = 5;
+    // A roll still being animated will not be reported
+    roll_++;
+    disconnect(frameConnection_);
+    update();
+}
 
-    /// Spacing to add in the separation of the rolls for each player; total
-    /// amount = 2*(FIRST_SPACING + DICE_SPACING)
-    static constexpr auto FIRST_SPACING = 10;
+void DiceRoll::setGameSpeed(qreal gameSpeed)
+{
+    if (gameSpeed <= 0) return;
+    duration_ = static_cast<int>(ROLL_DURATION / gameSpeed);
+}
 
-    painter->setPen(QPen(Qt::black, 2));
-    painter->setFont(QFont("Bavaria", 30, 5));
+DiceRoll::Side DiceRoll::makeSide(Player *player, const QVector<int> &dice, Qt::Alignment alignment)
+{
+    Side side;
+    if (!player || dice.empty()) return side;
 
-    // TODO: Refactor the code for left and right into a single block of code
+    side.dice = dice;
+    side.player = player->playerNumber();
 
-    // Left part
-    if (!leftDice_.empty() && leftOwner_ != nullptr)
+    const auto cache = ResourceCache::instance();
+    for (auto i = 1; i <= StandardRules::DICE_SIDES; i++)
     {
-        //Draw each dice
-        for (auto i = 0; i < leftDice_.size(); i++)
-            painter->drawPixmap(
-                        static_cast<int>(centerX) - FIRST_SPACING - (DICE_SIZE + DICE_SPACING)*(i+1),
-                        static_cast<int>(centerY - 0.5 * DICE_SIZE),
-                        DICE_SIZE,
-                        DICE_SIZE,
-                        *leftOwner_->dicePixmap(leftDice_.at(i))
-            );
-
-        //Draw final score
-        auto leftScore = 0;
-        for (auto n : leftDice_) leftScore += n;
-        painter->drawText(
-                    static_cast<int>(centerX) - FIRST_SPACING - (DICE_SIZE + DICE_SPACING) * (leftDice_.size() + 1) - (leftScore > 9 ? 20 : 0),
-                    static_cast<int>(centerY + 0.5 * DICE_SIZE),
-                    QString("%1").arg(leftScore)
-        );
+        side.faces.append(cache ? cache->diceImage(side.player, i)
+                                : QImage(QString(":/pixmaps/Player%1_Dice%2.png").arg(side.player).arg(i)));
     }
 
-    // Right part
-    if (!rightDice_.empty() && rightOwner_ != nullptr)
+    for (auto n : dice) side.total += n;
+
+    // The score is drawn once here, so the render thread only has to show it
+    side.score = QImage(SCORE_WIDTH, SCORE_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+    side.score.fill(Qt::transparent);
+    QPainter painter(&side.score);
+    painter.setPen(QPen(Qt::black, 2));
+    painter.setFont(QFont("Bavaria", 30, 5));
+    painter.drawText(side.score.rect(), static_cast<int>(alignment | Qt::AlignVCenter), QString::number(side.total));
+
+    return side;
+}
+
+void DiceRoll::showRoll(Player *leftPlayer, const QVector<int> &leftDice, Player *rightPlayer, const QVector<int> &rightDice)
+{
+    sides_[0] = makeSide(leftPlayer, leftDice, Qt::AlignRight);
+    sides_[1] = makeSide(rightPlayer, rightDice, Qt::AlignLeft);
+    roll_++;
+    disconnect(frameConnection_);
+    update();
+
+    // Too fast to be seen: the dice are shown settled in the next frame, and the result is known already
+    if (duration_ < MIN_ANIMATION || !window())
     {
-        // Draw each dice
-        for (auto i = 0; i < rightDice_.size(); i++)
-            painter->drawPixmap(
-                        static_cast<int>(centerX) + FIRST_SPACING + (DICE_SIZE + DICE_SPACING)*i,
-                        static_cast<int>(centerY - 0.5 * DICE_SIZE),
-                        DICE_SIZE,
-                        DICE_SIZE,
-                        *rightOwner_->dicePixmap(rightDice_.at(i))
-            );
-
-        // Draw final score
-        auto rightScore = 0;
-        for (auto n : rightDice_) rightScore += n;
-        painter->drawText(
-                    static_cast<int>(centerX) + FIRST_SPACING + (DICE_SIZE + DICE_SPACING) * rightDice_.size() + 4,
-                    static_cast<int>(centerY + 0.5 * DICE_SIZE),
-                    QString("%1").arg(rightScore)
-        );
+        emit rollFinished(sides_[0].total, sides_[1].total);
+        return;
     }
+
+    // frameSwapped is emitted from the render thread, so this only runs once the GUI thread is free
+    frameConnection_ = connect(window(), &QQuickWindow::frameSwapped, this, &DiceRoll::checkSettled, Qt::QueuedConnection);
 }
 
-void DiceRoll::startRoll(Player *leftPlayer, int leftDiceCount, Player *rightPlayer, int rightDiceCount)
+void DiceRoll::checkSettled()
 {
-    leftOwner_ = leftPlayer;
-    rightOwner_ = rightPlayer;
-    leftDice_.clear();
-    rightDice_.clear();
+    if (settled_->load() != roll_) return;
 
-    if (leftDiceCount < 1) leftDiceCount = 1;
-    if (rightDiceCount < 1) rightDiceCount = 1;
+    disconnect(frameConnection_);
+    emit rollFinished(sides_[0].total, sides_[1].total);
+}
 
-    for (auto i = 0; i < leftDiceCount; i++) leftDice_.append(qrand() % 6 + 1);
-    for (auto i = 0; i < rightDiceCount; i++) rightDice_.append(qrand() % 6 + 1);
+QSGNode *DiceRoll::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+{
+    auto node = static_cast<DiceRollNode *>(oldNode);
+    if (!node) node = new DiceRollNode(window(), settled_);
 
-    //TODO: This should be shown after an animation
-    auto leftScore = 0, rightScore = 0;
-    for (auto n : leftDice_) leftScore += n;
-    for (auto n : rightDice_) rightScore += n;
-    update();
-    emit rollFinished(leftScore, rightScore);
+    if (node->roll() != roll_) node->start(roll_, duration_, sides_, boundingRect());
+    return node;
 }
@@ -1,31 +1,100 @@
 #ifndef DICEROLL_H
 #define DICEROLL_H
 
-#include <QtQuick/QQuickPaintedItem>
+#include <QImage>
+#include <QtQuick/QQuickItem>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
 
 class Player;
 
-/// This class controls the display of a group of dice representing a score in the game. It
-/// controls such roll for both the left and the right player simultaneously
-class DiceRoll final : public QQuickPaintedItem
+/// This class shows the dice rolled in an attack, for both the attacking (left) and the defending (right)
+/// player at the same time. The dice tumble for a moment and then settle on the faces rolled by the engine.
+///
+/// The animation is played by the node of the item on the render thread of the scene graph: the roll is
+/// handed over once, and every other frame is rendered without waiting for the GUI thread, so the dice keep
+/// moving smoothly while it is busy. Only the end of the roll comes back, with rollFinished
+class DiceRoll final : public QQuickItem
 {
     Q_OBJECT
-    
-    QVector<int> leftDice_;
-    QVector<int> rightDice_;
-    Player *leftOwner_ = nullptr;
-    Player *rightOwner_ = nullptr;
 
 public:
-    explicit DiceRoll(QQuickItem* parent = nullptr);
+    explicit DiceRoll(QQuickItem *parent = nullptr);
+
+    /// Clears the last roll, so that the item can be reused in another game
+    void reset();
+
+    /// Rolls last ROLL_DURATION divided by the game speed. When that is shorter than MIN_ANIMATION, the dice
+    /// are shown settled at once, without rendering any frame for the animation
+    void setGameSpeed(qreal gameSpeed);
+
+    /// In milliseconds, at normal speed
+    static constexpr int ROLL_DURATION = 400;
+
+    static constexpr int MIN_ANIMATION = 50;
+
+    /// Size of each dice in pixels
+    static constexpr int DICE_SIZE = 30;
+
+    /// Spacing between dice in pixels
+    static constexpr int DICE_SPACING = 5;
+
+    /// Spacing to add in the separation of the rolls for each player; total amount = 2*(FIRST_SPACING + DICE_SPACING)
+    static constexpr int FIRST_SPACING = 10;
+
+    /// Size of the pictures of the scores, next to the dice
+    static constexpr int SCORE_WIDTH = 60;
+    static constexpr int SCORE_HEIGHT = 40;
+
+    /// Everything the node needs to show one side of a roll, copied to it when a new roll starts
+    struct Side
+    {
+        QVector<int> dice;
+
+        /// The number of the player, or -1 if this side shows nothing
+        int player = -1;
 
-    void paint(QPainter *painter) override;
+        /// The picture of each face of the dice of the player, from 1
+        QVector<QImage> faces;
+
+        /// The total of the dice, shown once they have settled
+        QImage score;
+        int total = 0;
+    };
+
+public slots:
+    /// Shows the dice rolled by both players. The rolls themselves are made by the engine
+    void showRoll(Player *leftPlayer, const QVector<int> &leftDice, Player *rightPlayer, const QVector<int> &rightDice);
 
 signals:
+    /// The dice of the last roll have settled, with the total of each side
     void rollFinished(int leftScore, int rightScore);
 
-public slots:
-    void startRoll(Player *leftPlayer, int leftDiceCount, Player *rightPlayer, int rightDiceCount);
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+
+private:
+    Side sides_[2];
+
+    /// Increased with every roll, so that the node knows when to start a new animation and the end of an old
+    /// one is not taken for the end of the current one
+    int roll_ = 0;
+
+    int duration_ = ROLL_DURATION;
+
+    /// The last roll the node has finished animating. It is written from the render thread
+    std::shared_ptr<std::atomic<int>> settled_;
+
+    /// Checks settled_ after every frame while a roll is being animated
+    QMetaObject::Connection frameConnection_;
+
+    static Side makeSide(Player *player, const QVector<int> &dice, Qt::Alignment alignment);
+
+private slots:
+    /// Reports the end of the roll if the node has finished animating it
+    void checkSettled();
 };
 
 #endif // DICEROLL_H
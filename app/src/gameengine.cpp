@@ -0,0 +1,405 @@
+#include "gameengine.h"
+
+#include <QDebug>
+
+#include <limits>
+
+GameEngine::GameEngine(QObject *parent)
+    : QObject(parent), events_(QUEUE_CAPACITY), timer_(this), retryTimer_(this)
+{
+    qRegisterMetaType<GameEngine::Setup>();
+
+    timer_.setSingleShot(true);
+    connect(&timer_, &QTimer::timeout, this, &GameEngine::runTimeline);
+    retryTimer_.setSingleShot(true);
+    connect(&retryTimer_, &QTimer::timeout, this, &GameEngine::retryBlocked);
+}
+
+bool GameEngine::takeEvent(GameEvent &event)
+{
+    return events_.pop(event);
+}
+
+void GameEngine::publish(const GameEvent &event)
+{
+    if (!backlog_.empty() || !events_.push(event))
+    {
+        backlog_.push_back(event);
+        return;
+    }
+
+    if (events_.needsWakeUp()) emit eventsPublished();
+}
+
+bool GameEngine::flushBacklog()
+{
+    auto pushed = false;
+    while (!backlog_.empty() && events_.push(backlog_.front()))
+    {
+        backlog_.pop_front();
+        pushed = true;
+    }
+
+    if (pushed && events_.needsWakeUp()) emit eventsPublished();
+    return backlog_.empty();
+}
+
+template <void (GameEngine::*Step)()>
+void GameEngine::schedule(int interval)
+{
+    timeline_.schedule(interval, [](void *engine) { (static_cast<GameEngine *>(engine)->*Step)(); }, this);
+    armTimer();
+}
+
+void GameEngine::waitForBoard(void (GameEngine::*step)())
+{
+    blocked_ = step;
+    retryTimer_.start(BACKLOG_RETRY_INTERVAL);
+}
+
+void GameEngine::armTimer()
+{
+    const auto next = timeline_.timeUntilNext();
+    if (next < 0) timer_.stop();
+    else timer_.start(static_cast<int>(qMin<qint64>(next, std::numeric_limits<int>::max())));
+}
+
+void GameEngine::runTimeline()
+{
+    // Steps due at the same time, or any step of an instant game, run here one after another
+    timeline_.advance();
+    armTimer();
+}
+
+void GameEngine::retryBlocked()
+{
+    const auto step = blocked_;
+    blocked_ = nullptr;
+    if (step) (this->*step)();
+}
+
+GameEvent GameEngine::makeEvent(GameEvent::Type type, int player, int territory, int value) const
+{
+    GameEvent event;
+    event.game = game_;
+    event.type = type;
+    event.player = static_cast<qint8>(player);
+    event.territory = static_cast<qint16>(territory);
+    event.value = value;
+    return event;
+}
+
+void GameEngine::start(const GameEngine::Setup &setup)
+{
+    timeline_.clear();
+    timer_.stop();
+    retryTimer_.stop();
+    blocked_ = nullptr;
+    backlog_.clear();
+
+    game_ = setup.game;
+    humans_ = setup.humans;
+    cheatMode_ = setup.cheatMode;
+    timeline_.setSpeed(setup.gameSpeed > 0 ? setup.gameSpeed : 1);
+    turnCount_ = 0;
+    gameTelemetry_.clear();
+    turnCaptures_ = 0;
+    waitingInput_ = false;
+    autoMode_ = false;
+
+    // The arena only holds the state of the game, so it is only reallocated when the board changes
+    if (!setup.map || setup.owners.size() != setup.map->territoryCount() || humans_.empty()) return;
+    if (setup.map != map_)
+    {
+        map_ = setup.map;
+        arena_.reset(new StateArena(map_, 1));
+        state_ = arena_->allocate();
+        candidates_.reset(new AttackCandidates(map_));
+    }
+
+    state_.setup(humans_.size(), setup.owners.constData(), setup.seed);
+    candidates_->reset(state_);
+    // Both peers of a network game must make the same decisions, so the solver is only bounded by nodes
+    EndgameSolver::Limits limits;
+    limits.maxNodes = ENDGAME_MAX_NODES;
+    limits.maxMilliseconds = 0;
+    policy_.reset(new EndgamePolicy(map_, std::unique_ptr<Policy>(new GreedyPolicy(state_.random().next())), limits));
+    autoPolicy_.reset(new EndgamePolicy(map_, std::unique_ptr<Policy>(new GreedyPolicy(setup.autoSeed)), limits));
+    policy_->setCandidates(candidates_.get());
+    autoPolicy_->setCandidates(candidates_.get());
+
+    for (auto terr = 0; terr < state_.territoryCount(); terr++)
+    {
+        if (state_.owner(terr) != GameState::NO_OWNER) publish(makeEvent(GameEvent::DiceChanged, -1, terr, state_.numDice(terr)));
+    }
+    for (auto player = 0; player < state_.playerCount(); player++)
+    {
+        publish(makeEvent(GameEvent::ConnectedChanged, player, -1, state_.connectedTerritories(player)));
+    }
+
+    auto event = makeEvent(GameEvent::TurnStarted, state_.playerTurn(), -1, turnCount_);
+    event.hash = stateHash();
+    publish(event);
+
+    startTurn();
+}
+
+void GameEngine::startTurn()
+{
+    if (humans_.value(state_.playerTurn()) && !autoMode_)
+    {
+        waitingInput_ = true;
+        publish(makeEvent(GameEvent::WaitingInput, state_.playerTurn()));
+        return;
+    }
+
+    schedule<&GameEngine::nextAIStep>(AI_STEP_INTERVAL);
+}
+
+void GameEngine::attack(int from, int to)
+{
+    if (!waitingInput_) return;
+
+    // The board checks the same rules, so this only happens if it has not shown the last events yet
+    if (!state_.canAttack(from, to))
+    {
+        publish(makeEvent(GameEvent::WaitingInput, state_.playerTurn()));
+        return;
+    }
+
+    waitingInput_ = false;
+    if (cheatMode_) resolveAttack<CheatRules>(from, to);
+    else resolveAttack<StandardRules>(from, to);
+}
+
+void GameEngine::endTurn()
+{
+    if (!waitingInput_) return;
+
+    waitingInput_ = false;
+    startGrowth();
+}
+
+void GameEngine::playForHuman()
+{
+    if (!waitingInput_) return;
+
+    waitingInput_ = false;
+    autoMode_ = true;
+    schedule<&GameEngine::nextAIStep>(AI_STEP_INTERVAL);
+}
+
+void GameEngine::setHuman(int player, bool human)
+{
+    if (player < 0 || player >= humans_.size()) return;
+    humans_[player] = human;
+
+    if (human || !waitingInput_ || state_.playerTurn() != player) return;
+    waitingInput_ = false;
+    schedule<&GameEngine::nextAIStep>(AI_STEP_INTERVAL);
+}
+
+void GameEngine::setCheatMode(bool cheatMode)
+{
+    cheatMode_ = cheatMode;
+}
+
+void GameEngine::setGameSpeed(qreal gameSpeed)
+{
+    // The steps already scheduled keep their game time, so only the timer needs to change
+    timeline_.setSpeed(gameSpeed);
+    armTimer();
+}
+
+void GameEngine::setPaused(bool paused)
+{
+    timeline_.setPaused(paused);
+    armTimer();
+}
+
+void GameEngine::setInstant(bool instant)
+{
+    timeline_.setInstant(instant);
+    armTimer();
+}
+
+void GameEngine::setTelemetryFile(const QString &fileName)
+{
+    telemetryFile_ = fileName;
+}
+
+void GameEngine::nextAIStep()
+{
+    if (!flushBacklog())
+    {
+        waitForBoard(&GameEngine::nextAIStep);
+        return;
+    }
+
+    // When the policy finds nothing worth attacking, the turn is over
+    auto &policy = autoMode_ ? autoPolicy_ : policy_;
+    if (!policy->chooseAttack(state_, from_, to_) || !state_.canAttack(from_, to_))
+    {
+        startGrowth();
+        return;
+    }
+
+    // No delay needed for selecting the attacking territory, as we have already waited for AI_STEP_INTERVAL
+    publish(makeEvent(GameEvent::Selected, state_.playerTurn(), from_));
+    schedule<&GameEngine::selectTarget>(AI_SELECT_INTERVAL);
+}
+
+void GameEngine::selectTarget()
+{
+    publish(makeEvent(GameEvent::Selected, state_.playerTurn(), to_));
+    schedule<&GameEngine::processAttack>(AI_ATTACK_INTERVAL);
+}
+
+void GameEngine::processAttack()
+{
+    if (!flushBacklog())
+    {
+        waitForBoard(&GameEngine::processAttack);
+        return;
+    }
+
+    if (cheatMode_) resolveAttack<CheatRules>(from_, to_);
+    else resolveAttack<StandardRules>(from_, to_);
+}
+
+template <class R>
+void GameEngine::resolveAttack(int from, int to)
+{
+    const auto attacker = state_.owner(from);
+    const auto defender = state_.owner(to);
+
+    auto event = makeEvent(GameEvent::Attack, attacker, from);
+    event.other = static_cast<qint16>(to);
+
+    // Cheater! Without cheat mode, this is always the number of dice of the territory
+    int attackCount, defenseCount;
+    if constexpr (R::CHEAT_MODE)
+    {
+        attackCount = R::rollCount(state_.numDice(from), humans_.value(attacker));
+        defenseCount = R::rollCount(state_.numDice(to), humans_.value(defender));
+    }
+    else
+    {
+        attackCount = state_.numDice(from);
+        defenseCount = state_.numDice(to);
+    }
+
+    // Same order as GameState::makeAttack, so that every peer of a network game rolls the same values
+    int faces[R::MAX_ROLL];
+    const auto attack = state_.random().template roll<R::DICE_SIDES>(attackCount, faces);
+    for (auto i = 0; i < attackCount; i++) event.attackDice[i] = static_cast<quint8>(faces[i]);
+    const auto defense = state_.random().template roll<R::DICE_SIDES>(defenseCount, faces);
+    for (auto i = 0; i < defenseCount; i++) event.defenseDice[i] = static_cast<quint8>(faces[i]);
+    event.attackCount = static_cast<quint8>(attackCount);
+    event.defenseCount = static_cast<quint8>(defenseCount);
+    publish(event);
+
+    const auto attackDice = state_.numDice(from);
+    const auto defenseDice = state_.numDice(to);
+    AttackUndo undo;
+    state_.makeAttackOutcome(from, to, attack > defense, undo);
+    candidates_->update(state_, undo);
+
+    if (!telemetryFile_.isEmpty())
+    {
+        turnCaptures_ += undo.captured;
+        gameTelemetry_.recordAttack(attackDice, defenseDice, undo.captured);
+        if (undo.captured && state_.ownedTerritories(defender) == 0) gameTelemetry_.recordElimination(turnCount_);
+    }
+
+    if (undo.captured)
+    {
+        publish(makeEvent(GameEvent::OwnerChanged, attacker, to));
+        publish(makeEvent(GameEvent::DiceChanged, attacker, to, state_.numDice(to)));
+        publish(makeEvent(GameEvent::ConnectedChanged, attacker, -1, state_.connectedTerritories(attacker)));
+        publish(makeEvent(GameEvent::ConnectedChanged, defender, -1, state_.connectedTerritories(defender)));
+    }
+    publish(makeEvent(GameEvent::DiceChanged, attacker, from, state_.numDice(from)));
+
+    if (state_.playersLeft() == 1)
+    {
+        publish(makeEvent(GameEvent::Victory, attacker));
+        if (telemetryFile_.isEmpty()) return;
+
+        // The winning turn never ends, so it gives no dice
+        gameTelemetry_.recordTurn(turnCaptures_, 0, 0, 0);
+        gameTelemetry_.recordGame(turnCount_, true);
+        telemetry_.merge(gameTelemetry_);
+        gameTelemetry_.clear();
+        if (!telemetry_.save(telemetryFile_.toStdString())) qWarning() << "Could not write the telemetry to" << telemetryFile_;
+        return;
+    }
+
+    startTurn();
+}
+
+void GameEngine::startGrowth()
+{
+    const auto player = state_.playerTurn();
+    publish(makeEvent(GameEvent::TurnEnded, player));
+
+    autoMode_ = false;
+    turnRemaining_ = state_.remainingDice(player);
+    turnIncome_ = state_.connectedTerritories(player);
+    state_.addDice(player, turnIncome_, false);
+    schedule<&GameEngine::growPlayer>(GROWTH_INTERVAL);
+}
+
+void GameEngine::growPlayer()
+{
+    if (!flushBacklog())
+    {
+        waitForBoard(&GameEngine::growPlayer);
+        return;
+    }
+
+    const auto player = state_.playerTurn();
+
+    //If the dice could be correctly inserted with no problems and there are dice remaining, keep going; otherwise, stop the timer and finish the turn
+    const auto remaining = state_.remainingDice(player);
+    std::uint16_t placed = 0;
+    const auto distributed = state_.distributeDice(player, 1, &placed);
+    if (state_.remainingDice(player) < remaining)
+    {
+        candidates_->update(state_, placed);
+        publish(makeEvent(GameEvent::DiceChanged, player, placed, state_.numDice(placed)));
+    }
+    if (distributed && state_.remainingDice(player) > 0)
+    {
+        schedule<&GameEngine::growPlayer>(GROWTH_INTERVAL);
+        return;
+    }
+
+    if (!telemetryFile_.isEmpty()) gameTelemetry_.recordTurn(turnCaptures_, turnRemaining_, turnIncome_, state_.remainingDice(player));
+    turnCaptures_ = 0;
+
+    auto turn = player;
+    do
+    {
+        turn = (turn + 1) % state_.playerCount();
+    } while (state_.ownedTerritories(turn) == 0);
+    state_.setPlayerTurn(turn);
+    turnCount_++;
+
+    auto event = makeEvent(GameEvent::TurnStarted, turn, -1, turnCount_);
+    event.hash = stateHash();
+    publish(event);
+
+    startTurn();
+}
+
+quint64 GameEngine::stateHash() const
+{
+    // The Zobrist hash of the state does not cover the generator nor the dice waiting to be placed
+    auto hash = state_.hash() ^ (state_.random().state() * Q_UINT64_C(0x9e3779b97f4a7c15));
+    for (auto player = 0; player < state_.playerCount(); player++)
+    {
+        hash = (hash ^ static_cast<quint64>(state_.remainingDice(player))) * Q_UINT64_C(1099511628211);
+    }
+    return hash;
+}
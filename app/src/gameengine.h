@@ -0,0 +1,282 @@
+#ifndef GAMEENGINE_H
+#define GAMEENGINE_H
+
+#include <QMetaType>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include "gamestate.h"
+#include "gametelemetry.h"
+#include "policy.h"
+#include "spscqueue.h"
+#include "timeline.h"
+
+#include <deque>
+#include <memory>
+
+/// A change of the game published by GameEngine for the board to show. Only the fields used by its type are set
+struct GameEvent
+{
+    enum Type : quint8
+    {
+        /// The AI has selected territory, either to attack from it or to attack it
+        Selected,
+
+        /// The current player has attacked other from territory. The dice rolled are in attackDice and defenseDice
+        Attack,
+
+        /// Territory now belongs to player
+        OwnerChanged,
+
+        /// Territory has now value dice
+        DiceChanged,
+
+        /// Player has now value connected territories
+        ConnectedChanged,
+
+        /// Player has finished their turn. The dice they receive are placed next
+        TurnEnded,
+
+        /// It is the turn of player. Value is the number of turns finished and hash identifies the state of the game
+        TurnStarted,
+
+        /// The current turn is played by a human, and the engine waits for their next input
+        WaitingInput,
+
+        /// Player has won the game
+        Victory
+    };
+
+    /// With cheat mode, a territory with 8 dice rolls 13 of them
+    static constexpr int MAX_ROLL = CheatRules::MAX_ROLL;
+
+    /// The game the event belongs to, so that events of a previous game can be told apart
+    quint32 game = 0;
+
+    quint8 type = Selected;
+    qint8 player = -1;
+    qint16 territory = -1;
+    qint16 other = -1;
+    quint8 attackCount = 0;
+    quint8 defenseCount = 0;
+    qint32 value = 0;
+    quint64 hash = 0;
+    quint8 attackDice[MAX_ROLL];
+    quint8 defenseDice[MAX_ROLL];
+};
+
+/// This class plays the game shown by HexGrid on a thread of its own. It owns the GameState, runs the AI and
+/// paces every step with its own timer. The board only sends it the inputs of the humans, and shows the events
+/// published here once per frame. Events go through a lock-free queue, so neither side ever waits for the other:
+/// a slow frame only delays when the events are shown, and a slow step only delays the next event
+class GameEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Everything needed to start a game on a board already generated
+    struct Setup
+    {
+        std::shared_ptr<const MapTopology> map;
+
+        /// The owner of each territory of the map, or GameState::NO_OWNER for the ones removed
+        QVector<qint8> owners;
+
+        /// Whether each player is a human, either in this process or in the other peer of a network game
+        QVector<bool> humans;
+
+        /// Determines the initial dice, every roll and every decision of the AI
+        quint64 seed = 0;
+
+        /// Only for the decisions of the AI when it plays for a human, which the other peer of a network game
+        /// receives as inputs
+        quint64 autoSeed = 0;
+
+        /// Stamped on every event of the game
+        quint32 game = 0;
+
+        bool cheatMode = false;
+        qreal gameSpeed = 1;
+    };
+
+    explicit GameEngine(QObject *parent = nullptr);
+
+    /// Takes the next event published, if any. This must only be called from the thread showing the game. Once
+    /// it returns false, eventsPublished will be emitted again as soon as there are new events
+    bool takeEvent(GameEvent &event);
+
+private:
+    /// Events waiting for the board to take them. eventsPublished is only emitted when the board has to be woken up
+    WakeUpQueue<GameEvent> events_;
+
+    /// Events that did not fit in the queue because the board is lagging behind. The game does not go on until
+    /// they are all in the queue, so this never grows beyond the events of a single step
+    std::deque<GameEvent> backlog_;
+
+    std::shared_ptr<const MapTopology> map_;
+    std::unique_ptr<StateArena> arena_;
+    GameState state_;
+
+    /// The legal attacks of every player, updated after each attack and each die placed. The policies take
+    /// their attacks from here instead of scanning the board at every AI step
+    std::unique_ptr<AttackCandidates> candidates_;
+
+    /// Plays for the AI players: greedy attacks, and the endgame solver once the game is almost decided
+    std::unique_ptr<Policy> policy_;
+
+    /// Plays for the humans in auto mode
+    std::unique_ptr<Policy> autoPolicy_;
+
+    QVector<bool> humans_;
+    quint32 game_ = 0;
+
+    /// Turns finished since the game started
+    int turnCount_ = 0;
+
+    /// Where the telemetry of the finished games is written, or empty to not collect it
+    QString telemetryFile_;
+
+    /// The counters of the game in progress, which are only added to the ones of the session when it is won,
+    /// so the games dropped halfway through do not count
+    GameTelemetry gameTelemetry_;
+    GameTelemetry telemetry_;
+
+    /// Captures of the current turn, and the dice of the player right before they got the ones of the end of it
+    int turnCaptures_ = 0;
+    int turnRemaining_ = 0;
+    int turnIncome_ = 0;
+
+    /// The engine waits for a human, and nothing happens until an input arrives
+    bool waitingInput_ = false;
+
+    /// Play automatically for a human player as if it was an AI player, until the turn ends
+    bool autoMode_ = false;
+
+    /// A little bit of cheating
+    bool cheatMode_ = false;
+
+    /// The attack the AI is preparing
+    int from_ = -1;
+    int to_ = -1;
+
+    /// Paces every step of the game. All the delays below are in game time, so the game speed, pausing and
+    /// instant games are all handled there
+    Timeline timeline_;
+
+    /// Fires when the next step of the timeline is due. It is only ever restarted, never reconnected
+    QTimer timer_;
+
+    /// The step waiting for the board to take the events of the previous ones, and the timer trying it again.
+    /// This waits for the board in real time, so instant games do not spin while it lags behind
+    void (GameEngine::*blocked_)() = nullptr;
+    QTimer retryTimer_;
+
+    /// The interval between increasing the amount of dice by one, in milliseconds
+    static constexpr int GROWTH_INTERVAL = 30;
+
+    /// The interval to start an AI turn
+    static constexpr int AI_STEP_INTERVAL = 500;
+
+    /// The interval to select territories for the AI
+    static constexpr int AI_SELECT_INTERVAL = 300;
+
+    /// The interval to process the attack
+    static constexpr int AI_ATTACK_INTERVAL = 300;
+
+    /// The interval to try again a step that was stopped because the board is lagging behind
+    static constexpr int BACKLOG_RETRY_INTERVAL = 1;
+
+    /// Keeps every decision of the endgame solver within a fraction of AI_STEP_INTERVAL
+    static constexpr int ENDGAME_MAX_NODES = 20000;
+
+    /// Enough for the events of hundreds of steps, i.e. many frames at the highest game speed
+    static constexpr int QUEUE_CAPACITY = 1024;
+
+    void publish(const GameEvent &event);
+
+    /// Moves the backlog to the queue. Returns false if some events are still waiting for room
+    bool flushBacklog();
+
+    /// Calls the given step once the interval of game time has passed. The step is a template argument, so the
+    /// timeline only has to store a plain function and this engine
+    template <void (GameEngine::*Step)()>
+    void schedule(int interval);
+
+    /// Tries the step again once the board has had time to take some events
+    void waitForBoard(void (GameEngine::*step)());
+
+    /// Starts the timer for the next step of the timeline, if there is any
+    void armTimer();
+
+    /// Either waits for the human playing the current turn or starts the AI
+    void startTurn();
+
+    /// Rolls the dice of the attack, which must be legal, and applies the result. The rules are chosen once
+    /// per attack, so the rolls of a game without cheat mode do not check for it
+    template <class R>
+    void resolveAttack(int from, int to);
+
+    /// Gives the dice of the end of the turn to the current player
+    void startGrowth();
+
+    /// Hash of the owners and dice of every territory, whose turn it is and the state of the random generator
+    quint64 stateHash() const;
+
+    GameEvent makeEvent(GameEvent::Type type, int player = -1, int territory = -1, int value = 0) const;
+
+private slots:
+    /// Runs the steps of the timeline that are due
+    void runTimeline();
+
+    void retryBlocked();
+
+    //Starts the next step for AI players
+    void nextAIStep();
+
+    //Selects the territory to attack, once the attacking one has been shown for a while
+    void selectTarget();
+
+    //Performs the attack prepared by nextAIStep
+    void processAttack();
+
+    //Places the dice of the end of a turn one by one, then starts the next turn
+    void growPlayer();
+
+public slots:
+    /// Starts a new game, dropping the one in progress
+    void start(const GameEngine::Setup &setup);
+
+    /// Attacks for the human playing the current turn. Illegal attacks are ignored
+    void attack(int from, int to);
+
+    /// Ends the turn of the human playing the current turn
+    void endTurn();
+
+    /// Lets the AI finish the turn of the human playing it
+    void playForHuman();
+
+    /// Changes who controls the player. If the engine was waiting for them, the AI plays at once
+    void setHuman(int player, bool human);
+
+    void setCheatMode(bool cheatMode);
+    void setGameSpeed(qreal gameSpeed);
+
+    /// Stops the game clock, e.g. while a menu is shown. The inputs of the humans are still taken
+    void setPaused(bool paused);
+
+    /// Plays every step right after the previous one, without any of the delays
+    void setInstant(bool instant);
+
+    /// Collects the telemetry of the games from now on and rewrites the file with the totals every time one
+    /// of them is won. An empty name stops collecting it
+    void setTelemetryFile(const QString &fileName);
+
+signals:
+    /// There are new events to take. This is emitted from the thread of the engine
+    void eventsPublished();
+};
+
+Q_DECLARE_METATYPE(GameEngine::Setup)
+
+#endif // GAMEENGINE_H
@@ -1,53 +1,34 @@
 #ifndef HEX_H
 #define HEX_H
 
-#include <QtQuick/QQuickPaintedItem>
+#include <QPointF>
+
+#include "hexcoord.h"
 
 class Territory;
 
-/// This class represents a single hexagon in the grid
-class Hex : public QQuickPaintedItem
+/// This class represents a single hexagon in the grid. It is a plain value rather than an item:
+/// the HexGrid stores all the cells contiguously and only paints the ones inside the viewport
+class Hex
 {
-    Q_OBJECT
-    Q_PROPERTY(QPointF center READ center WRITE setCenter)
-    Q_PROPERTY(qreal radius READ radius WRITE setRadius)
-
-    /// The center of the Hex, in pixel coordinates
+    /// The center of the Hex, in board coordinates (i.e. pixel coordinates when not zoomed)
     QPointF center_;
 
-    /// The radius of the Hex, in pixel coordinates
-    qreal radius_ = 10;
-
     /// The Territory this Hex belongs to
-    Territory *territory_;
+    Territory *territory_ = nullptr;
 
-    /// The posiiton inside the HexGrid, in axial coordinates
-    QPair<int, int> gridPosition_;
-
-    void resize();
+    /// The position inside the HexGrid, in axial coordinates
+    HexCoord gridPosition_;
 
 public:
-    explicit Hex(QQuickItem *parent = nullptr);
-
-    void paint(QPainter *painter) override;
-
     QPointF center() const;
     void setCenter(const QPointF &center);
 
-    qreal radius() const;
-    void setRadius(const qreal &radius);
-
     Territory *territory() const;
     void setTerritory(Territory *territory);
 
-    const QPair<int, int>& gridPosition() const;
-    void setGridPosition(const QPair<int, int> &gridPosition);
-
-    /// Returns whether this Hex is not part of a Territory which contains other Hex instances
-    bool isIsolated();
-
-signals:
-    void sizeChanged();
+    HexCoord gridPosition() const;
+    void setGridPosition(HexCoord gridPosition);
 };
 
 #endif // HEX_H
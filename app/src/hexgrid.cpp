@@ -1,132 +1,270 @@
 #include "hexgrid.h"
 
 #include "hex.h"
+#include "hexlayer.h"
 #include "player.h"
 #include "territory.h"
 #include "diceroll.h"
+#include "gameengine.h"
+#include "lockstepsession.h"
+#include "mapgenerator.h"
 
+#include <QDebug>
 #include <QtMath>
-#include <QTime>
-#include <QElapsedTimer>
+#include <QDateTime>
+#include <QtConcurrent>
 
 HexGrid::HexGrid(QQuickItem *parent)
     : QQuickItem(parent)
 {
+    layer_ = new HexLayer(this);
+
+    board_ = new QQuickItem(this);
+    board_->setTransformOrigin(QQuickItem::TopLeft);
+
+    // The engine is deleted by its own thread once it finishes
+    engine_ = new GameEngine();
+    engine_->moveToThread(&engineThread_);
+    connect(&engineThread_, &QThread::finished, engine_, &QObject::deleteLater);
+    connect(engine_, &GameEngine::eventsPublished, this, &QQuickItem::polish);
+    engineThread_.start();
+
+    connect(&generation_, &QFutureWatcher<std::shared_ptr<const MapTopology>>::finished, this, &HexGrid::generationFinished);
 }
 
 HexGrid::~HexGrid()
 {
-    for (auto hex : map_) delete hex;
+    // The worker thread reports its progress to the grid, so it must finish first
+    generation_.waitForFinished();
+
+    engineThread_.quit();
+    engineThread_.wait();
 
     for (auto player : players_) delete player;
 
     for (auto territory : territories_) delete territory;
 
-    if (timer_.isActive()) timer_.stop();
+    for (auto territory : territoryPool_) delete territory;
 
     delete diceRoll_;
 }
 
 void HexGrid::initializeGrid()
 {
-    QElapsedTimer timer;
-    timer.start();
+    // Seeded from the clock, so every local game is different
+    const auto seed = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch());
+
+    if (session_ && session_->isActive())
+    {
+        // In network games only the host starts games, once the guest is connected. Both peers then set up
+        // the same game from the settings and seed chosen here
+        if (!session_->isHost() || !session_->connected()) return;
+
+        LockstepSession::Settings settings;
+        settings.seed = seed;
+        settings.gridWidth = gridWidth_;
+        settings.gridHeight = gridHeight_;
+        settings.numTerritories = numTerritories_;
+        settings.territorySize = territorySize_;
+        settings.generator = generator_;
+
+        // The human seats are shared alternately between the host and the guest
+        auto humans = 0;
+        for (auto i = 0; i < numPlayers_; i++)
+        {
+            auto owner = LockstepSession::AI;
+            if (humanList_.value(i)) owner = humans++ % 2 == 0 ? LockstepSession::HostPlayer : LockstepSession::GuestPlayer;
+            settings.seatOwners.append(static_cast<qint8>(owner));
+        }
+
+        if (!settings.isValid())
+        {
+            qWarning() << "The settings of the board cannot be used for a network game";
+            return;
+        }
+
+        session_->sendStart(settings);
+        startSessionGame();
+        return;
+    }
+
+    remoteList_.clear();
+    setupGame(seed);
+}
+
+void HexGrid::startSessionGame()
+{
+    const auto &settings = session_->settings();
+    gridWidth_ = settings.gridWidth;
+    gridHeight_ = settings.gridHeight;
+    numTerritories_ = settings.numTerritories;
+    territorySize_ = settings.territorySize;
+    setGenerator(settings.generator);
+
+    numPlayers_ = settings.seatOwners.size();
+    humanList_.resize(numPlayers_);
+    remoteList_.resize(numPlayers_);
+    for (auto i = 0; i < numPlayers_; i++)
+    {
+        humanList_[i] = settings.seatOwners.at(i) != LockstepSession::AI;
+        remoteList_[i] = session_->isRemoteSeat(i);
+    }
+    emit numPlayersChanged();
+
+    setupGame(settings.seed);
+}
+
+void HexGrid::setupGame(quint64 seed)
+{
     if (numPlayers_ <= 0) return;
 
-    qsrand(static_cast<uint>(QTime::currentTime().msec()));
+    random_.setState(seed);
 
-    players_.clear();
-    for (auto terr : territories_) delete terr;
+    // The items of the previous game are reset and kept for createTerritory instead of being deleted
+    for (auto terr : territories_)
+    {
+        terr->reset();
+        territoryPool_.append(terr);
+    }
     territories_.clear();
-    for (auto hex : map_) delete hex;
-    map_.clear();
     selectedTerritory_ = nullptr;
-    otherTerritory_ = nullptr;
-
-    playingAnimation_ = false;
-    autoMode_ = false;
-    if (timer_.isActive()) timer_.stop();
-    // ReSharper disable once CppExpressionWithoutSideEffects
-    timer_.disconnect();
 
-    humansLeft_ = 0;
+    // Whatever the engine publishes from now on belongs to the previous game until it receives the new one
+    game_++;
+    waitingInput_ = false;
+    rolling_ = false;
+    heldEvents_.clear();
 
-    delete diceRoll_;
-    diceRoll_ = new DiceRoll(qobject_cast<QQuickItem*>(parent()));
+    if (!diceRoll_)
+    {
+        diceRoll_ = new DiceRoll(qobject_cast<QQuickItem*>(parent()));
+        connect(diceRoll_, &DiceRoll::rollFinished, this, &HexGrid::attackFinished);
+    }
+    diceRoll_->reset();
+    diceRoll_->setGameSpeed(gameSpeed_);
     diceRoll_->setX(x());
     diceRoll_->setY(y() + height() - 190);
     diceRoll_->setWidth(width());
     diceRoll_->setHeight(120);
-    connect(diceRoll_, &DiceRoll::rollFinished, this, &HexGrid::attackFinished);
 
+    // Players are reused too; only the ones not taking part anymore are deleted
+    while (players_.size() > numPlayers_) delete players_.takeLast();
     for (auto i = 0; i < numPlayers_; i++)
     {
-        auto player = new Player();
-        player->setPlayerNumber(i);
+        if (i == players_.size()) players_.append(new Player());
 
-        if (humanList_.at(i))
-        {
-            player->setHuman(true);
-            humansLeft_++;
-        }
-        players_.append(player);
+        auto player = players_.at(i);
+        player->reset();
+        player->setPlayerNumber(i);
+        player->setHuman(humanList_.at(i));
     }
 
-    playersLeft_ = numPlayers_;
+    // The cells and the pool of territories are only resized when the grid dimensions change
+    const QSize gridSize(gridWidth_, gridHeight_);
+    if (gridSize != poolGridSize_)
+    {
+        const auto shrinking = cells_.size() > gridWidth_ * gridHeight_;
+        cells_.resize(gridWidth_ * gridHeight_);
+        if (shrinking) cells_.squeeze();
+
+        while (territoryPool_.size() > numTerritories_) delete territoryPool_.takeLast();
 
-    const auto height = radius_ * 2;
-    const auto vert = height * 3/4;
-    const auto width = qSqrt(3)/2 * height;
-    const auto horz = width;
+        poolGridSize_ = gridSize;
+    }
 
-    for (auto x = 0; x < gridWidth_; x++)
+    for (auto y = 0; y < gridHeight_; y++)
     {
-        for (auto y = 0; y < gridHeight_; y++)
+        for (auto x = 0; x < gridWidth_; x++)
         {
-            QPointF pos(horz*x + (y % 2 != 0 ? width/2 : 0), vert*y);
-            auto hex = new Hex(this);
-            hex->setCenter(pos);
-            hex->setRadius(radius_);
-
-            QPair<int, int> pair;
-            pair.first = x - (y - (y&1)) / 2;
-            pair.second = y;
-            hex->setGridPosition(pair);
-            map_.insert(pair, hex);
+            const auto position = HexCoord::fromOffset(x, y);
+            auto hex = cellAt(x, y);
+            hex->setCenter(QPointF(position.centerX(radius_), position.centerY(radius_)));
+            hex->setTerritory(nullptr);
+            hex->setGridPosition(position);
         }
     }
 
-    // Until this point, the players have been regenerated, the hex grid too,
-    // but and it only needs to create the tertitoreis and asign hex cells to them
-
-    initMethodGrowth();
+    // The previous board disappears while the new one is generated
+    layer_->updateAll();
+    pan_ = -boardRect().topLeft() * zoom_;
+    updateViewport();
 
-    // Remove small territories
-    /*for (Hex *hex : *map_)
-    {
-        if (hex->isIsolated() && hex->territory() != 0) hex->territory()->removeCell(hex);
-    }*/
-    for (auto terr : territories_)
+    auto map = libraryMap();
+    if (map)
     {
-        if (terr->cellCount() < 6) terr->owner()->removeTerritory(terr);
+        // A map still being generated for a previous game is discarded when it finishes
+        setGenerating(false);
+        startGame(std::move(map));
+        return;
     }
 
-    // Adding initial dice for the players' territories
-    for (auto player : players_) player->addDice(territories_.size() * 15 / 10 / players_.size());
-
-    // Emit signal that initializes the connected territories for each player
-    for (auto i = 0; i < players_.size(); i++)
+    // Growing the territories only works on plain data, so it runs on a worker thread. The items are
+    // created afterwards by startGame, all at once
+    MapSettings settings;
+    settings.width = gridWidth_;
+    settings.height = gridHeight_;
+    settings.numTerritories = numTerritories_;
+    settings.territorySize = territorySize_;
+    const auto mapSeed = random_.next();
+    const auto game = game_;
+    const auto generator = generator_.toStdString();
+
+    setGenerating(true);
+    setGenerationProgress(0);
+
+    generation_.setFuture(QtConcurrent::run([this, settings, mapSeed, game, generator]()
     {
-        emit connTerrChanged(i, players_.at(i)->connectedTerritories());
-    }
+        // The generator keeps scratch space, so every map gets its own instead of sharing one between threads
+        auto mapGenerator = createMapGenerator(generator);
+        if (!mapGenerator) return std::shared_ptr<const MapTopology>();
 
-    // Using set function instead of assigning the value to playerTurn_ directly
-    // because this will emit the corresponding signal too
-    setPlayerTurn(qrand() % players_.size());
+        auto reported = 0;
+        return mapGenerator->generate(settings, mapSeed, [this, game, &reported](int done, int total)
+        {
+            // Only whole percents are reported, so that large boards do not flood the event loop
+            const auto percent = done * 100 / total;
+            if (percent == reported) return;
+            reported = percent;
+            QMetaObject::invokeMethod(this, [this, game, percent]()
+            {
+                if (game == game_) setGenerationProgress(percent / 100.0);
+            }, Qt::QueuedConnection);
+        });
+    }));
+}
 
-    //qDebug() << "Elapsed time for initialization: " << timer.elapsed();
+void HexGrid::generationFinished()
+{
+    if (!generating_) return;
+    setGenerating(false);
+    setGenerationProgress(1);
 
-    if (!players_.at(playerTurn_)->human()) startAITurn();
+    startGame(generation_.result());
+}
+
+void HexGrid::startGame(std::shared_ptr<const MapTopology> map)
+{
+    if (!map) return;
+
+    createTerritories(*map);
+
+    layer_->updateAll();
+    updateViewport();
+
+    // From here on, the game is played by the engine on its own thread, on the same topology the items were
+    // created from
+    GameEngine::Setup setup;
+    for (auto terr : territories_) setup.owners.append(static_cast<qint8>(players_.indexOf(terr->owner())));
+
+    setup.map = std::move(map);
+    setup.humans = humanList_;
+    setup.seed = random_.next();
+    setup.autoSeed = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch());
+    setup.game = game_;
+    setup.cheatMode = cheatMode_ && remoteList_.empty();
+    setup.gameSpeed = gameSpeed_;
+
+    QMetaObject::invokeMethod(engine_, "start", Qt::QueuedConnection, Q_ARG(GameEngine::Setup, setup));
 }
 
 int HexGrid::territorySize() const
@@ -150,87 +288,77 @@ void HexGrid::setNumTerritories(int numTerritories)
 }
 
 
-//The territories are uniformly created, however the boundary hexagons may be swapped to the adjacent territories
-void HexGrid::initMethodGrid()
+std::shared_ptr<const MapTopology> HexGrid::libraryMap()
 {
-    constexpr auto size = 5;
+    if (!mapLibrary_.isValid() || mapLibrary_.mapCount() == 0) return nullptr;
 
-    for (auto x = 0; x < gridWidth_; x++)
-    {
-        for (auto y = 0; y < gridHeight_; y++)
-        {
-            QPair<int, int> pair;
-            pair.first = x - (y - (y&1)) / 2;
-            pair.second = y;
+    // The other peer of a network game might not have the same library
+    if (session_ && session_->isActive()) return nullptr;
 
-            const auto hex = map_.value(pair);
+    // The maplibrary tool generates the maps with the growth generator
+    if (generator_ != "growth") return nullptr;
 
-            auto index = ((x / size) * (gridHeight_/size + 1) + y / size);
-            if (x % size == size - 1) //At the limit of a terrain
-                index += (qrand() % 2) * (gridHeight_/size + 1);
-            else if (y % size == size - 1)
-                index += (qrand() % 2);
+    const auto settings = mapLibrary_.settings();
+    if (settings.width != gridWidth_ || settings.height != gridHeight_
+            || settings.numTerritories != numTerritories_ || settings.territorySize != territorySize_) return nullptr;
 
-            if (index >= territories_.size()) //Adding territories
-            {
-                for (auto i = territories_.size(); i <= index; i++)
-                {
-                    auto terr = new Territory(this);
-                    players_.at(qrand() % numPlayers_)->appendTerritory(terr); //The owner will be set internally
-                    territories_.append(terr);
-                }
-            }
-            territories_.at(index)->appendCell(hex);
-        }
-    }
+    return mapLibrary_.topology(random_.bounded(mapLibrary_.mapCount()));
 }
 
-void HexGrid::initMethodGrowth()
+void HexGrid::createTerritories(const MapTopology &map)
 {
-    QPair<int, int> pair;
-    const auto x = qrand() % gridWidth_;
-    const auto y = qrand() % gridHeight_;
-    pair.first = x - (y - (y&1)) / 2;
-    pair.second = y;
-    auto hex = map_.value(pair);
-
-    //Creating a first territory for that hex cell
-    auto terr = new Territory(this);
-    players_.at(0)->appendTerritory(terr); //The owner will be set internally
-    terr->appendCell(hex);
-    terr->grow(territorySize_);
-    territories_.append(terr);
+    const auto count = map.territoryCount();
+    for (auto i = 0; i < count; i++) territories_.append(createTerritory());
 
-    for (auto terrCount = 1; terrCount < numTerritories_; terrCount++)
+    QVector<QVector<Hex *>> cells(count);
+    for (auto i = 0; i < count; i++) cells[i].reserve(map.cellCount(i));
+    for (auto y = 0; y < gridHeight_; y++)
     {
-        // First attempt: selecting and adjacent hex from the previous territory
-        hex = terr->findEmptyAdjacent();
-
-        // IF that does not work, then select an adjacent hex from a random territory
-        while (!hex)
+        for (auto x = 0; x < gridWidth_; x++)
         {
-            hex = territories_.at(qrand() % terrCount)->findEmptyAdjacent();
+            const auto terr = map.cellTerritory(x, y);
+            if (terr >= 0) cells[terr].append(cellAt(x, y));
         }
+    }
+
+    // The adjacency is already known, so there is no need to look at the neighbours of every cell, and the
+    // geometry of every item is only set once
+    QVector<Territory *> neighbours;
+    for (auto i = 0; i < count; i++)
+    {
+        neighbours.clear();
+        for (auto neighbour : map.neighbours(i)) neighbours.append(territories_.at(neighbour));
 
-        terr = new Territory(this);
-        players_.at(terrCount % numPlayers_)->appendTerritory(terr); //The owner will be set internally
-        terr->appendCell(hex);
-        territories_.append(terr);
+        const auto terr = territories_.at(i);
+        terr->assignCells(cells.at(i), neighbours);
+        players_.at(i % numPlayers_)->appendTerritory(terr); //The owner will be set internally
+    }
+}
 
-        //Now: make the territories grow randomly to the number of hex cells desired
-        terr->grow(territorySize_);
+Territory *HexGrid::createTerritory()
+{
+    if (!territoryPool_.empty())
+    {
+        auto terr = territoryPool_.takeLast();
+        terr->setVisible(true);
+        return terr;
     }
 
+    // The QObject parent is still the grid, which is what the territories rely on to find their neighbours
+    auto terr = new Territory(this);
+    terr->setParentItem(board_);
+    return terr;
 }
 
 void HexGrid::processClick(qreal x, qreal y)
 {
-    if (playingAnimation_) return;
+    if (!waitingInput_ || isRemoteTurn()) return;
+
+    // From item to board coordinates
+    x = (x - pan_.x()) / zoom_;
+    y = (y - pan_.y()) / zoom_;
 
-    const auto cubeX = (x * sqrt(3)/3 - y / 3) / radius_;
-    const auto cubeZ = y * 2 / 3 / radius_;
-    const auto cubeY = -cubeX -cubeZ;
-    const auto hex = cubeRound(cubeX, cubeY, cubeZ);
+    const auto hex = hexAt(HexCoord::fromPixel(x, y, radius_));
 
     if (!hex || !hex->territory() || !hex->territory()->owner()) return;
 
@@ -245,15 +373,13 @@ void HexGrid::processClick(qreal x, qreal y)
     }
 
     // The selected territory is from a different player and adjacent to the one already selected -> ATTACK!
+    // Both stay selected until the engine rolls the dice
     if (selectedTerritory_ != nullptr && selectedTerritory_->owner() != terr->owner() && terr->neighbours().contains(selectedTerritory_))
     {
-        otherTerritory_ = terr;
-        processAttack();
-
-        //TODO: before deselecting the originally selected territory, there should be a battle animation with both selected, and then they will both be deselected
-        selectedTerritory_->setSelected(false);
-        selectedTerritory_ = nullptr;
-
+        terr->setSelected(true);
+        waitingInput_ = false;
+        QMetaObject::invokeMethod(engine_, "attack", Qt::QueuedConnection,
+                                  Q_ARG(int, territories_.indexOf(selectedTerritory_)), Q_ARG(int, territories_.indexOf(terr)));
         return;
     }
 
@@ -265,52 +391,100 @@ void HexGrid::processClick(qreal x, qreal y)
     selectedTerritory_ = terr;
 }
 
-void HexGrid::processAttack() const
+void HexGrid::updatePolish()
 {
-    const auto attacker = selectedTerritory_->owner();
-    const auto defender = otherTerritory_->owner();
-
-    auto attack = selectedTerritory_->numDice(), defense = otherTerritory_->numDice();
-    if (cheatMode_ && attacker->human()) attack = 1 + static_cast<int>(attack * 1.5); //Cheater!
-    if (cheatMode_ && defender->human()) defense = 1 + static_cast<int>(defense * 1.5); //Cheater!
-
-    diceRoll_->startRoll(attacker, attack, defender, defense);
+    GameEvent event;
+    while (engine_->takeEvent(event))
+    {
+        if (event.game != game_) continue;
+        if (rolling_) heldEvents_.push_back(event);
+        else applyEvent(event);
+    }
 }
 
-void HexGrid::attackFinished(int attack, int defense)
+void HexGrid::applyHeldEvents()
 {
-    emit showAttackResult(attack, defense);
+    while (!rolling_ && !heldEvents_.empty())
+    {
+        const auto event = heldEvents_.front();
+        heldEvents_.erase(heldEvents_.begin());
+        applyEvent(event);
+    }
+}
 
-    auto attacker = selectedTerritory_->owner(), defender = otherTerritory_->owner();
+void HexGrid::applyEvent(const GameEvent &event)
+{
+    const auto terr = territories_.value(event.territory);
+    const auto player = players_.value(event.player);
 
-    if (attack > defense)
+    switch (event.type)
     {
-        attacker->appendTerritory(otherTerritory_);
-        otherTerritory_->setNumDice(selectedTerritory_->numDice() - 1);
-        emit connTerrChanged(players_.indexOf(attacker), attacker->connectedTerritories());
-        emit connTerrChanged(players_.indexOf(defender), defender->connectedTerritories());
-        otherTerritory_->updateAll();
+        case GameEvent::Selected:
+            if (terr) terr->setSelected(true);
+            break;
 
-        if (defender->connectedTerritories() == 0) playersLeft_--;
+        case GameEvent::Attack:
+        {
+            const auto other = territories_.value(event.other);
+            if (!terr || !other) break;
+
+            if (sendsInputs()) session_->sendAttack(event.territory, event.other);
+
+            terr->setSelected(false);
+            other->setSelected(false);
+            selectedTerritory_ = nullptr;
+
+            // The result is shown once the dice have settled, see attackFinished. A roll too fast to be animated
+            // finishes right away, within showRoll
+            QVector<int> attackDice, defenseDice;
+            for (auto i = 0; i < event.attackCount; i++) attackDice.append(event.attackDice[i]);
+            for (auto i = 0; i < event.defenseCount; i++) defenseDice.append(event.defenseDice[i]);
+            rolling_ = true;
+            diceRoll_->showRoll(terr->owner(), attackDice, other->owner(), defenseDice);
+            break;
+        }
 
-        if (defender->human() && defender->territories().empty()) humansLeft_--;
-    }
+        case GameEvent::OwnerChanged:
+            if (!terr || !player) break;
+            player->appendTerritory(terr);
+            terr->updateAll();
+            break;
 
-    selectedTerritory_->setNumDice(1);
-    selectedTerritory_->setSelected(false);
+        case GameEvent::DiceChanged:
+            if (!terr) break;
+            terr->setNumDice(event.value);
+            terr->update();
+            break;
 
-    if (playersLeft_ == 1)
-    {
-        emit victory(players_.indexOf(attacker), attacker->human());
-        return;
-    }
+        case GameEvent::ConnectedChanged:
+            emit connTerrChanged(event.player, event.value);
+            break;
 
-    if (autoMode_ || !attacker->human()) //start next AI turn
-    {
-        otherTerritory_->setSelected(false);
-        timer_.disconnect();
-        connect(&timer_, &QTimer::timeout, this, &HexGrid::nextAIStep);
-        timer_.start(static_cast<int>(AI_STEP_INTERVAL / gameSpeed_));
+        case GameEvent::TurnEnded:
+            if (sendsInputs()) session_->sendEndTurn();
+            break;
+
+        case GameEvent::TurnStarted:
+            if (selectedTerritory_)
+            {
+                selectedTerritory_->setSelected(false);
+                selectedTerritory_->updateAll();
+                selectedTerritory_ = nullptr;
+            }
+            turnCount_ = event.value;
+            setPlayerTurn(event.player);
+            if (session_ && !remoteList_.empty()) session_->checkHash(event.value, event.hash);
+            break;
+
+        case GameEvent::WaitingInput:
+            waitingInput_ = true;
+            if (isRemoteTurn()) processRemoteActions();
+            break;
+
+        case GameEvent::Victory:
+            waitingInput_ = false;
+            if (player) emit victory(event.player, player->human());
+            break;
     }
 }
 
@@ -325,38 +499,17 @@ void HexGrid::setPlayerTurn(int playerTurn)
     emit playerTurnChanged();
 }
 
-Hex *HexGrid::cubeRound(qreal x, qreal y, qreal z) const
-{
-    auto rx = qRound(x);
-    auto ry = qRound(y);
-    auto rz = qRound(z);
-
-    const auto xDiff = qAbs(rx-x);
-    const auto yDiff = qAbs(ry-y);
-    const auto zDiff = qAbs(rz-z);
-
-    if (xDiff > yDiff && xDiff > zDiff)
-        rx = -ry-rz;
-    else if (yDiff > zDiff)
-        ry = -rx-rz;
-    else
-        rz = -rx-ry;
-
-    QPair<int, int> pair;
-    pair.first = rx;
-    pair.second = rz;
-
-    return map_.value(pair);
-}
-
 void HexGrid::startAITurn()
 {
-    if (players_.at(playerTurn_)->human()) autoMode_ = true;
-    playingAnimation_ = true;
-    timer_.disconnect();
-    connect(&timer_, &QTimer::timeout, this, &HexGrid::nextAIStep);
-    timer_.setSingleShot(true);
-    timer_.start(static_cast<int>(AI_STEP_INTERVAL  / gameSpeed_));
+    if (!waitingInput_ || isRemoteTurn()) return;
+
+    waitingInput_ = false;
+    if (selectedTerritory_)
+    {
+        selectedTerritory_->setSelected(false);
+        selectedTerritory_ = nullptr;
+    }
+    QMetaObject::invokeMethod(engine_, "playForHuman", Qt::QueuedConnection);
 }
 
 QVector<bool> HexGrid::humanList() const
@@ -377,8 +530,31 @@ qreal HexGrid::gameSpeed() const
 void HexGrid::setGameSpeed(const qreal &gameSpeed)
 {
     if (gameSpeed <= 0) return;
-    if (timer_.isActive()) timer_.start(static_cast<int>(timer_.remainingTime() * gameSpeed_ / gameSpeed));
     gameSpeed_ = gameSpeed;
+    if (diceRoll_) diceRoll_->setGameSpeed(gameSpeed);
+    QMetaObject::invokeMethod(engine_, "setGameSpeed", Qt::QueuedConnection, Q_ARG(qreal, gameSpeed));
+}
+
+bool HexGrid::paused() const
+{
+    return paused_;
+}
+
+void HexGrid::setPaused(bool paused)
+{
+    paused_ = paused;
+    QMetaObject::invokeMethod(engine_, "setPaused", Qt::QueuedConnection, Q_ARG(bool, paused));
+}
+
+bool HexGrid::instant() const
+{
+    return instant_;
+}
+
+void HexGrid::setInstant(bool instant)
+{
+    instant_ = instant;
+    QMetaObject::invokeMethod(engine_, "setInstant", Qt::QueuedConnection, Q_ARG(bool, instant));
 }
 
 bool HexGrid::cheatMode() const
@@ -389,129 +565,314 @@ bool HexGrid::cheatMode() const
 void HexGrid::setCheatMode(bool cheatMode)
 {
     cheatMode_ = cheatMode;
+
+    // Cheating is not possible in network games, as the other peer would roll different dice
+    QMetaObject::invokeMethod(engine_, "setCheatMode", Qt::QueuedConnection, Q_ARG(bool, cheatMode_ && remoteList_.empty()));
 }
 
-void HexGrid::nextAIStep()
+void HexGrid::endTurn()
 {
-    // Select an enemy territory randomly, under certain rules. When those rules
-    // determine that no enemy territory can be selected, finish the turn
-
-    const auto player = players_.at(playerTurn_);
-
-    const auto terrCount = player->territories().size();
-    const auto terrBase = qrand() % terrCount;
-
-    for (auto terrOffset = 0; terrOffset < terrCount; terrOffset++)
-    {
-        const auto terr = player->territories().at((terrBase + terrOffset) % terrCount);
-        if (terr->numDice() < 2) continue;
+    if (!waitingInput_ || isRemoteTurn()) return;
 
-        const auto nTerrCount = terr->neighbours().size();
-        const auto nTerrBase = qrand() % nTerrCount;
+    waitingInput_ = false;
+    QMetaObject::invokeMethod(engine_, "endTurn", Qt::QueuedConnection);
+}
 
-        for (auto nTerrOffset = 0; nTerrOffset < nTerrCount; nTerrOffset++)
-        {
-            auto neigh = terr->neighbours().at((nTerrBase + nTerrOffset) % nTerrCount);
-            if (neigh->owner() == nullptr || neigh->owner() == player) continue;
+bool HexGrid::isPlayerHuman(int index) const
+{
+    const auto player = players_.value(index);
+    if (!player) return false;
+    return player->human() && !remoteList_.value(index);
+}
 
-            // When no humans are left, the AI players may attack territories with
-            // one more dice. This avoids stalemates
-            // int maxDice = humansLeft_ == 0 ? terr->numDice() + 1 : neigh->owner()->human() ? terr->numDice() : terr->numDice() - 1;
-            auto maxDice = terr->numDice();
-            if (maxDice != Territory::MAX_DICE) maxDice--; //Territories with 8 dice can attack other territories with 8 dice
+void HexGrid::processRemoteActions()
+{
+    // Inputs are only applied while the board is waiting for the other peer, so they never interrupt an
+    // animation. The rest stay queued until this is called again
+    if (!session_ || !isRemoteTurn() || !waitingInput_ || !session_->hasAction()) return;
 
-            if (neigh->numDice() <= maxDice)
-            {
-                selectedTerritory_ = terr;
-                otherTerritory_ = neigh;
-                timer_.disconnect();
-                connect(&timer_, &QTimer::timeout, this, &HexGrid::selectTerritories);
-                timer_.start(0); //No delay needed for selecting the attacking territory, as we have already waited for AI_STEP_INTERVAL
-                return;
-            }
-        }
+    const auto action = session_->takeAction();
+    if (action.type == LockstepSession::Action::EndTurn)
+    {
+        waitingInput_ = false;
+        QMetaObject::invokeMethod(engine_, "endTurn", Qt::QueuedConnection);
+        return;
+    }
 
+    // Same rules as processClick, which only fail if the boards have diverged
+    const auto from = territories_.value(action.from);
+    const auto to = territories_.value(action.to);
+    const auto player = players_.at(playerTurn_);
+    if (!from || !to || from->owner() != player || from->numDice() < 2 || !to->owner() || to->owner() == player
+            || !from->neighbours().contains(to))
+    {
+        emit desync(turnCount_);
+        return;
     }
 
-    // If no territory was attacked, finish the turn
-    playingAnimation_ = false;
-    timer_.disconnect();
-    endTurn();
+    from->setSelected(true);
+    to->setSelected(true);
+    waitingInput_ = false;
+    QMetaObject::invokeMethod(engine_, "attack", Qt::QueuedConnection, Q_ARG(int, action.from), Q_ARG(int, action.to));
 }
 
-void HexGrid::selectTerritories()
+void HexGrid::sessionConnectionChanged()
 {
-    if (!selectedTerritory_->selected()) //First step
+    if (session_->connected())
     {
-        selectedTerritory_->setSelected(true);
-        timer_.start(static_cast<int>(AI_SELECT_INTERVAL / gameSpeed_));
+        // The host starts the first game as soon as the guest arrives
+        if (session_->isHost()) initializeGrid();
+        return;
     }
-    else //Second step
+
+    if (remoteList_.empty()) return;
+
+    // If the engine was waiting for them, it starts the AI at once
+    if (isRemoteTurn()) waitingInput_ = false;
+    for (auto i = 0; i < remoteList_.size() && i < players_.size(); i++)
     {
-        otherTerritory_->setSelected(true);
-        timer_.disconnect();
-        connect(&timer_, &QTimer::timeout, this, &HexGrid::processAttack);
-        timer_.start(static_cast<int>(AI_ATTACK_INTERVAL / gameSpeed_));
+        if (!remoteList_.at(i)) continue;
+        players_.at(i)->setHuman(false);
+        QMetaObject::invokeMethod(engine_, "setHuman", Qt::QueuedConnection, Q_ARG(int, i), Q_ARG(bool, false));
     }
+    remoteList_.clear();
+}
 
+void HexGrid::attackFinished(int attack, int defense)
+{
+    rolling_ = false;
+    emit showAttackResult(attack, defense);
+    applyHeldEvents();
 }
 
-void HexGrid::endTurn()
+bool HexGrid::isRemoteTurn() const
 {
-    if (playingAnimation_) return;
+    return remoteList_.value(playerTurn_);
+}
 
-    autoMode_ = false;
-    playingAnimation_ = true;
+bool HexGrid::sendsInputs() const
+{
+    return session_ && !remoteList_.empty() && session_->isLocalSeat(playerTurn_);
+}
 
-    players_.at(playerTurn_)->addDice(players_.at(playerTurn_)->connectedTerritories(), false);
+const Hex *HexGrid::neighbour(const Hex *hex, int direction) const
+{
+    return hexAt(hex->gridPosition().neighbour(direction % HexCoord::DIRECTION_COUNT));
+}
 
-    connect(&timer_, &QTimer::timeout, this, &HexGrid::growPlayer);
-    timer_.setSingleShot(false);
-    timer_.start(static_cast<int>(GROWTH_INTERVAL / gameSpeed_));
+const Hex *HexGrid::hexAt(HexCoord gridPosition) const
+{
+    if (!gridPosition.isInside(gridWidth_, gridHeight_)) return nullptr;
+    return cellAt(gridPosition.column(), gridPosition.row());
 }
 
-bool HexGrid::isPlayerHuman(int index) const
+bool HexGrid::hasCells() const
 {
-    const auto player = players_.at(index);
-    if (!player) return false;
-    return player->human();
+    return !cells_.empty() && cells_.size() == gridWidth_ * gridHeight_;
+}
+
+QRectF HexGrid::boardRect() const
+{
+    const auto horz = HexCoord(1, 0).centerX(radius_);
+    const auto vert = HexCoord(0, 1).centerY(radius_);
+
+    // Odd rows are shifted half a cell to the right
+    return QRectF(-horz/2, -radius_, horz * (gridWidth_ + 0.5), vert * (gridHeight_ - 1) + radius_ * 2);
+}
+
+QRectF HexGrid::visibleArea() const
+{
+    return QRectF(-pan_ / zoom_, size() / zoom_);
+}
+
+QRect HexGrid::cellRange(const QRectF &area) const
+{
+    const auto horz = HexCoord(1, 0).centerX(radius_);
+    const auto vert = HexCoord(0, 1).centerY(radius_);
+
+    // One extra cell on each side, as cells stick out of their row and column
+    const auto left = qMax(0, qFloor(area.left() / horz) - 1);
+    const auto right = qMin(gridWidth_ - 1, qCeil(area.right() / horz) + 1);
+    const auto top = qMax(0, qFloor(area.top() / vert) - 1);
+    const auto bottom = qMin(gridHeight_ - 1, qCeil(area.bottom() / vert) + 1);
+
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+void HexGrid::updateTerritory(const Territory *territory)
+{
+    layer_->updateTerritory(territory);
+}
+
+qreal HexGrid::zoom() const
+{
+    return zoom_;
+}
+
+void HexGrid::setZoom(qreal zoom)
+{
+    zoomAt(width() / 2, height() / 2, zoom / zoom_);
+}
+
+LockstepSession *HexGrid::session() const
+{
+    return session_;
+}
+
+void HexGrid::setSession(LockstepSession *session)
+{
+    if (session_) session_->disconnect(this);
+    session_ = session;
+    if (!session_) return;
+
+    connect(session_, &LockstepSession::started, this, &HexGrid::startSessionGame);
+    connect(session_, &LockstepSession::actionReceived, this, &HexGrid::processRemoteActions);
+    connect(session_, &LockstepSession::connectedChanged, this, &HexGrid::sessionConnectionChanged);
+    connect(session_, &LockstepSession::desync, this, &HexGrid::desync);
 }
 
-void HexGrid::growPlayer()
+bool HexGrid::generating() const
 {
-    auto player = players_.at(playerTurn_);
+    return generating_;
+}
+
+qreal HexGrid::generationProgress() const
+{
+    return generationProgress_;
+}
 
-    //If the dice could be correctly inserted with no problems and there are dice remaining, keep going; otherwise, stop the timer and finish the turn
-    if (player->distributeDice(1) && player->remainingDice() > 0) return;
+void HexGrid::setGenerating(bool generating)
+{
+    if (generating == generating_) return;
+    generating_ = generating;
+    emit generatingChanged();
+}
 
-    playingAnimation_ = false;
-    if (timer_.isActive()) timer_.stop();
-    timer_.disconnect();
+void HexGrid::setGenerationProgress(qreal progress)
+{
+    if (qFuzzyCompare(progress, generationProgress_)) return;
+    generationProgress_ = progress;
+    emit generationProgressChanged();
+}
 
-    do
+QString HexGrid::generator() const
+{
+    return generator_;
+}
+
+void HexGrid::setGenerator(const QString &generator)
+{
+    if (!createMapGenerator(generator.toStdString()))
     {
-        playerTurn_ = (playerTurn_ + 1) % numPlayers_;
-    } while (players_.at(playerTurn_)->territories().empty());
+        qWarning() << "Unknown map generator:" << generator;
+        return;
+    }
+    generator_ = generator;
+}
 
-    if (selectedTerritory_)
+QString HexGrid::mapLibrary() const
+{
+    return mapLibraryFile_.fileName();
+}
+
+void HexGrid::setMapLibrary(const QString &mapLibrary)
+{
+    if (mapLibrary == mapLibraryFile_.fileName()) return;
+
+    // Closing the file also unmaps it
+    mapLibrary_ = MapLibrary();
+    mapLibraryFile_.close();
+    mapLibraryFile_.setFileName(mapLibrary);
+    if (mapLibrary.isEmpty() || !mapLibraryFile_.open(QIODevice::ReadOnly)) return;
+
+    // The file is mapped instead of read, so only the pages of the maps actually played are loaded from disk
+    const auto size = mapLibraryFile_.size();
+    const auto data = mapLibraryFile_.map(0, size);
+    if (data) mapLibrary_ = MapLibrary(data, static_cast<std::size_t>(size));
+
+    if (!mapLibrary_.isValid())
     {
-        selectedTerritory_->setSelected(false);
-        selectedTerritory_->updateAll();
-        selectedTerritory_ = nullptr;
+        qWarning() << "Invalid map library:" << mapLibrary;
+        mapLibraryFile_.close();
     }
+}
 
-    emit playerTurnChanged();
+QString HexGrid::telemetryFile() const
+{
+    return telemetryFile_;
+}
+
+void HexGrid::setTelemetryFile(const QString &telemetryFile)
+{
+    telemetryFile_ = telemetryFile;
+    QMetaObject::invokeMethod(engine_, "setTelemetryFile", Qt::QueuedConnection, Q_ARG(QString, telemetryFile));
+}
+
+QPointF HexGrid::pan() const
+{
+    return pan_;
+}
+
+qreal HexGrid::minZoom() const
+{
+    const auto rect = boardRect();
+    if (rect.isEmpty() || width() <= 0 || height() <= 0) return 1;
+    return qMin(1.0, qMin(width() / rect.width(), height() / rect.height()));
+}
+
+void HexGrid::zoomAt(qreal x, qreal y, qreal factor)
+{
+    const auto zoom = qBound(minZoom(), zoom_ * factor, MAX_ZOOM);
+
+    // The board point under x,y must stay there after zooming
+    const QPointF point(x, y);
+    pan_ = point - (point - pan_) * (zoom / zoom_);
+    zoom_ = zoom;
+
+    updateViewport();
+}
+
+void HexGrid::panBy(qreal dx, qreal dy)
+{
+    pan_ += QPointF(dx, dy);
+    updateViewport();
+}
+
+void HexGrid::updateViewport()
+{
+    if (zoom_ < minZoom()) zoom_ = minZoom();
+
+    // When the board is larger than the viewport, it cannot leave any gap at the sides; otherwise, it
+    // cannot go beyond any of them
+    const auto rect = boardRect();
+    const auto clampAxis = [](qreal pan, qreal start, qreal end, qreal viewSize)
+    {
+        if (end - start <= viewSize) return qBound(-start, pan, viewSize - end);
+        return qBound(viewSize - end, pan, -start);
+    };
+    pan_.setX(clampAxis(pan_.x(), rect.left() * zoom_, rect.right() * zoom_, width()));
+    pan_.setY(clampAxis(pan_.y(), rect.top() * zoom_, rect.bottom() * zoom_, height()));
+
+    board_->setScale(zoom_);
+    board_->setPosition(pan_);
+
+    // Territories outside the viewport, or all of them when zoomed out too much, are not drawn at all
+    const auto showDice = radius_ * zoom_ >= DICE_MIN_RADIUS;
+    const auto visible = visibleArea();
+    for (auto terr : territories_)
+    {
+        terr->setVisible(showDice && terr->cellCount() > 0 && visible.intersects(QRectF(terr->position(), terr->size())));
+    }
 
-    if (!players_.at(playerTurn_)->human()) startAITurn();
+    layer_->update();
+    emit viewChanged();
 }
 
-Hex *HexGrid::neighbour(Hex *hex, int direction) const
+void HexGrid::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
 {
-    if (!map_.contains(hex->gridPosition())) return nullptr;
-    QPair<int, int> pair;
-    pair.first = hex->gridPosition().first + DIRECTIONS[direction % 6][0];
-    pair.second = hex->gridPosition().second + DIRECTIONS[direction % 6][1];
-    return map_.value(pair, nullptr);
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    layer_->setSize(newGeometry.size());
+    updateViewport();
 }
 
 int HexGrid::numPlayers() const
@@ -521,7 +882,9 @@ int HexGrid::numPlayers() const
 
 void HexGrid::setNumPlayers(int numPlayers)
 {
+    if (numPlayers_ == numPlayers) return;
     numPlayers_ = numPlayers;
+    emit numPlayersChanged();
 }
 
 int HexGrid::gridWidth() const
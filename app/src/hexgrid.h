@@ -1,17 +1,28 @@
 #ifndef HEXGRID_H
 #define HEXGRID_H
 
+#include <QFile>
+#include <QFutureWatcher>
 #include <QQuickItem>
 #include <QtMath>
-#include <QTimer>
-#include <QHash>
+#include <QThread>
 #include <QList>
-#include <QPair>
+
+#include "hex.h"
+#include "maplibrary.h"
+#include "maptopology.h"
+#include "random.h"
+
+#include <memory>
+#include <vector>
 
 class DiceRoll;
-class Hex;
+class GameEngine;
+class HexLayer;
+class LockstepSession;
 class Territory;
 class Player;
+struct GameEvent;
 
 /// This class represents the full grid of hexagons that constitute the board of the game
 class HexGrid : public QQuickItem
@@ -26,12 +37,21 @@ class HexGrid : public QQuickItem
     Q_PROPERTY(int playerTurn READ playerTurn WRITE setPlayerTurn NOTIFY playerTurnChanged)
     Q_PROPERTY(bool cheatMode READ cheatMode WRITE setCheatMode)
     Q_PROPERTY(qreal gameSpeed READ gameSpeed WRITE setGameSpeed)
+    Q_PROPERTY(bool paused READ paused WRITE setPaused)
+    Q_PROPERTY(bool instant READ instant WRITE setInstant)
+    Q_PROPERTY(qreal zoom READ zoom WRITE setZoom NOTIFY viewChanged)
+    Q_PROPERTY(QString mapLibrary READ mapLibrary WRITE setMapLibrary)
+    Q_PROPERTY(QString generator READ generator WRITE setGenerator)
+    Q_PROPERTY(QString telemetryFile READ telemetryFile WRITE setTelemetryFile)
+    Q_PROPERTY(LockstepSession *session READ session WRITE setSession)
+    Q_PROPERTY(bool generating READ generating NOTIFY generatingChanged)
+    Q_PROPERTY(qreal generationProgress READ generationProgress NOTIFY generationProgressChanged)
 
     Q_PROPERTY(QVector<bool> humanList READ humanList WRITE setHumanList)
 
     int gridWidth_ = 60;
     int gridHeight_ = 40;
-    qreal radius_;
+    qreal radius_ = 10;
     int numTerritories_ = 1;
     int territorySize_ = 20;
 
@@ -41,59 +61,148 @@ class HexGrid : public QQuickItem
     /// Index indicating whose's turn is now
     int playerTurn_;
 
-    /// Number of user-controlled players still playing the game
-    int humansLeft_;
-
-    /// Number of both AI- and user-controlled players still playing the game
-    int playersLeft_;
-
-    Territory *selectedTerritory_, *otherTerritory_;
+    /// The territory selected by the human playing the current turn
+    Territory *selectedTerritory_ = nullptr;
 
     /// The list of players
     QVector<Player *> players_;
 
     QVector<Territory *> territories_;
 
-    QHash<QPair<int, int>, Hex *> map_;
+    /// Territory items from previous games, which are reused instead of allocating new ones
+    QVector<Territory *> territoryPool_;
+
+    /// The grid dimensions the cells and the pools were last prepared for
+    QSize poolGridSize_;
+
+    /// All the hex cells of the board, row by row (i.e. indexed by offset coordinates, not axial ones)
+    QVector<Hex> cells_;
+
+    /// Paints the cells inside the viewport
+    HexLayer *layer_ = nullptr;
+
+    /// Holds the territories, and hence the dice. It is scaled and moved around to zoom and pan the board
+    QQuickItem *board_ = nullptr;
+
+    /// Scale factor between board and item coordinates
+    qreal zoom_ = 1;
+
+    /// Position of the board origin (i.e. the center of the first cell) in item coordinates
+    QPointF pan_;
+
+    /// Maximum zoom allowed when zooming in
+    static constexpr qreal MAX_ZOOM = 4;
+
+    /// Below this radius (in screen pixels), the dice of the territories are not shown
+    static constexpr qreal DICE_MIN_RADIUS = 6;
+
+    /// Takes a random map from the map library. Returns nullptr if there is no library or its maps were
+    /// generated for a different board, in which case a new map must be generated instead
+    std::shared_ptr<const MapTopology> libraryMap();
+
+    /// Generates the map of the next game on a worker thread, without touching any item, so that the GUI
+    /// stays responsive while large boards are generated
+    QFutureWatcher<std::shared_ptr<const MapTopology>> generation_;
+
+    /// Name of the MapGenerator of new games, as accepted by createMapGenerator
+    QString generator_ = "growth";
 
-    static constexpr int DIRECTIONS[][2] = {{1,0},{0,1},{-1,1},{-1,0},{0,-1},{+1,-1}};
+    bool generating_ = false;
 
-    void initMethodGrid();
-    void initMethodGrowth();
+    void setGenerating(bool generating);
 
-    Hex *cubeRound(qreal x, qreal y, qreal z) const; //Returns the nearest hex cell from the given fractional x,y,z cube coordinates
+    /// Share of the territories of the map being generated that have been grown, from 0 to 1
+    qreal generationProgress_ = 0;
 
-    /// If this is true, the grid will stop responding to click events
-    bool playingAnimation_ = false;
+    void setGenerationProgress(qreal progress);
 
-    /// Timer for general purpose in the game
-    QTimer timer_;
+    /// Creates the territory items of the generated map at once, with every cell and neighbour already known
+    void createTerritories(const MapTopology &map);
 
-    /// The interval between increasing the amount of dice by one, in milliseconds
-    static constexpr int GROWTH_INTERVAL = 30;
+    /// The file of the map library, which stays open and memory mapped while the library is in use
+    QFile mapLibraryFile_;
 
-    /// The interval to start an AI turn
-    static constexpr int AI_STEP_INTERVAL = 500;
+    /// Maps pregenerated by the maplibrary tool
+    MapLibrary mapLibrary_;
 
-    /// The interval to select territories for the AI
-    static constexpr int AI_SELECT_INTERVAL = 300;
+    /// Where the engine writes the telemetry of the games won, or empty for none
+    QString telemetryFile_;
 
-    /// The interval to process the attack
-    static constexpr int AI_ATTACK_INTERVAL = 300;
+    /// Creates a new territory item (or takes one from the pool), placed inside the board so that it follows the zoom and pan
+    Territory *createTerritory();
+
+    /// Minimum zoom allowed, i.e. the one where the whole board fits the viewport
+    qreal minZoom() const;
+
+    /// Keeps the board inside the viewport, then hides the dice of the territories that are not visible
+    void updateViewport();
+
+    /// Plays the game on engineThread_. The grid only shows the events it publishes and sends it the inputs
+    /// of the humans
+    GameEngine *engine_ = nullptr;
+
+    QThread engineThread_;
+
+    /// Identifies the game in progress, so that the events left from the previous one are ignored
+    quint32 game_ = 0;
+
+    /// The engine waits for the human playing the current turn. Until then, the grid will not respond to
+    /// click events
+    bool waitingInput_ = false;
 
     /// Factor to multiply all the intervals to speed up / slow the processes
     qreal gameSpeed_ = 1;
 
+    /// The clock of the engine is stopped, or every step is played without waiting at all
+    bool paused_ = false;
+    bool instant_ = false;
+
     /// A little bit of cheating
     bool cheatMode_ = false;
 
-    /// Play automatically for a human player as if it was an AI player. It is disconnected after the turn ends
-    bool autoMode_ = false;
-
     QVector<bool> humanList_;
 
     DiceRoll *diceRoll_ = nullptr;
 
+    /// The dice of the last attack are still rolling. The events published after it, including its own outcome
+    /// and the engine waiting for input again, are held until the roll finishes, so the board never shows the
+    /// result before the dice and the human cannot attack again in the meantime
+    bool rolling_ = false;
+    std::vector<GameEvent> heldEvents_;
+
+    /// Source of every random decision of the game. The board is generated with it, and the engine is seeded
+    /// from it for the rolls, the dice distribution and the AI. Two games started with the same seed and
+    /// receiving the same inputs are identical
+    Random random_;
+
+    /// Connection to the other peer of a network game, or nullptr for local games
+    LockstepSession *session_ = nullptr;
+
+    /// The seats played by the human in the other peer of a network game. Empty for local games
+    QVector<bool> remoteList_;
+
+    /// Turns finished since the game started, as published by the engine
+    int turnCount_ = 0;
+
+    /// Sets up a new game from the given seed, which determines everything that happens in it. The map
+    /// might still be generating when this returns
+    void setupGame(quint64 seed);
+
+    /// Creates the items of the board from the map of the new game and hands the game to the engine
+    void startGame(std::shared_ptr<const MapTopology> map);
+
+    /// Whether the current turn belongs to the human of the other peer, whose inputs come from the session
+    bool isRemoteTurn() const;
+
+    /// Whether the inputs of the current turn must be sent to the other peer
+    bool sendsInputs() const;
+
+    /// Shows an event published by the engine
+    void applyEvent(const GameEvent &event);
+
+    /// Applies the events held while the dice were rolling, up to the next attack if there is one
+    void applyHeldEvents();
+
 public:
     explicit HexGrid(QQuickItem *parent = nullptr);
     ~HexGrid();
@@ -110,10 +219,58 @@ public:
     int numPlayers() const;
     void setNumPlayers(int numPlayers);
 
-    // This getter is defined here to ensure auto works
-    auto map() const { return map_; }
+    qreal zoom() const;
+    void setZoom(qreal zoom);
+
+    LockstepSession *session() const;
+    void setSession(LockstepSession *session);
+
+    /// Whether the map of the new game is being generated. The board stays empty until it finishes
+    bool generating() const;
+    qreal generationProgress() const;
+
+    QString generator() const;
+
+    /// Chooses the generator of the next maps by name (see createMapGenerator). Unknown names are ignored
+    void setGenerator(const QString &generator);
+
+    QString mapLibrary() const;
+
+    /// Loads the map library from the given file. If it does not exist or is not valid, the maps will be
+    /// generated at the start of every game as usual
+    void setMapLibrary(const QString &mapLibrary);
+
+    QString telemetryFile() const;
+
+    /// Lets the engine count attacks, captures, dice and turns of every game, and write the totals to the
+    /// given file as JSON whenever a game is won (see GameTelemetry)
+    void setTelemetryFile(const QString &telemetryFile);
+
+    QPointF pan() const;
+
+    /// Returns the hex cell at the given axial coordinates, or nullptr if it is outside the grid
+    const Hex *hexAt(HexCoord gridPosition) const;
+
+    /// Returns the hex cell at the given offset coordinates (i.e. column and row), which must be inside the grid
+    Hex *cellAt(int x, int y) { return &cells_[y * gridWidth_ + x]; }
+    const Hex *cellAt(int x, int y) const { return &cells_.at(y * gridWidth_ + x); }
 
-    Hex *neighbour(Hex *hex, int direction) const;
+    const Hex *neighbour(const Hex *hex, int direction) const;
+
+    /// Whether the cells have been generated for the current grid size
+    bool hasCells() const;
+
+    /// The bounding rectangle of all the cells, in board coordinates
+    QRectF boardRect() const;
+
+    /// The part of the board currently shown, in board coordinates
+    QRectF visibleArea() const;
+
+    /// The range of cells, in offset coordinates, which covers the given area of the board
+    QRect cellRange(const QRectF &area) const;
+
+    /// Repaints the cells of the territory after its owner or selection has changed
+    void updateTerritory(const Territory *territory);
 
     int numTerritories() const;
     void setNumTerritories(int numTerritories);
@@ -130,6 +287,13 @@ public:
     qreal gameSpeed() const;
     void setGameSpeed(const qreal &gameSpeed);
 
+    bool paused() const;
+    void setPaused(bool paused);
+
+    /// Plays the turns of the AI without any delay, e.g. to skip to the end of a game
+    bool instant() const;
+    void setInstant(bool instant);
+
     QVector<bool> humanList() const;
     void setHumanList(const QVector<bool> &humanList);
 
@@ -139,33 +303,52 @@ signals:
     void numPlayersChanged();
     void playerTurnChanged();
     void victory(int player, bool human);
+    void viewChanged();
+    void generatingChanged();
+    void generationProgressChanged();
+
+    /// The boards of both peers of a network game were different after the given turn
+    void desync(int turn);
 
 public slots:
     void initializeGrid();
     void processClick(qreal x, qreal y);
+
+    /// Multiplies the zoom by the given factor, keeping the point x,y (in item coordinates) where it was
+    void zoomAt(qreal x, qreal y, qreal factor);
+
+    /// Moves the board by the given amount of pixels
+    void panBy(qreal dx, qreal dy);
     void endTurn();
 
+    /// Whether the player is controlled by a human in this process (i.e. not by the AI nor by the other peer
+    /// of a network game). Seats that do not exist yet, e.g. before the host of a network game started it, are not
     bool isPlayerHuman(int index) const;
 
-    //Mainly handles the timer when an AI turn starts. If it is called for a human player, autoMode_ will be set to true until the turn ends
+    /// Lets the AI play the rest of the turn of the human
     void startAITurn();
 
+protected:
+    void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+    /// Takes the events published by the engine since the last frame
+    void updatePolish() override;
+
 private slots:
-    //Starts the next step for AI players
-    void nextAIStep();
+    /// Shows the result of the last attack once its dice have settled
+    void attackFinished(int attack, int defense);
 
-    //Handles the "animation" when dice are being added to a player at the end of a turn
-    void growPlayer();
+    /// Takes the map generated by the worker thread
+    void generationFinished();
 
-    //Selects the territories before starting an attack. This will be called twice, for the own and the neighbour territories. Then, it will start the timer for processAttack
-    void selectTerritories();
+    /// Sets up the game the host of the session has started
+    void startSessionGame();
 
-    //Performs the attack, the aftermath, and starts again the timer for nextAIStep
-    //TODO: Include an intermediate animation for this
-    void processAttack() const;
+    /// Applies the next input of the other peer, if the game is waiting for it
+    void processRemoteActions();
 
-    //Determines the conclusions of the attack once the dice have been rolled
-    void attackFinished(int attack, int defense);
+    /// When the other peer leaves, the AI takes over their seats
+    void sessionConnectionChanged();
 };
 
 #endif // HEXGRID_H
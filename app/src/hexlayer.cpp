@@ -0,0 +1,160 @@
+#include "hexlayer.h"
+
+#include "hex.h"
+#include "hexgrid.h"
+#include "player.h"
+#include "territory.h"
+
+#include <QPainter>
+#include <QtMath>
+
+HexLayer::HexLayer(HexGrid *grid) : QQuickPaintedItem(grid), grid_(grid)
+{
+    setZ(-1); // Territories, which hold the dice, are always shown above the cells
+}
+
+void HexLayer::paint(QPainter *painter)
+{
+    if (!grid_->hasCells()) return;
+
+    const auto zoom = grid_->zoom();
+    const auto radius = grid_->radius() * zoom;
+
+    painter->translate(grid_->pan());
+    painter->scale(zoom, zoom);
+
+    if (radius < CELL_MIN_RADIUS)
+    {
+        paintOverview(painter);
+        return;
+    }
+
+    // When only part of the layer has been marked as dirty, there is no need to go through all the visible cells
+    auto area = grid_->visibleArea();
+    if (painter->hasClipping()) area = area.intersected(painter->clipBoundingRect());
+
+    paintCells(painter, grid_->cellRange(area), radius >= BORDER_MIN_RADIUS);
+}
+
+void HexLayer::paintCells(QPainter *painter, const QRect &range, bool borders)
+{
+    const auto radius = grid_->radius();
+
+    // The vertices of a hexagon centered at the origin; 7 because the hexagon must be closed
+    QPointF corners[7];
+    for (auto i = 0; i < 7; i++)
+    {
+        const auto angle = (60.0*i - 30)*M_PI/180;
+        corners[i] = QPointF(radius * qCos(angle), radius * qSin(angle));
+    }
+
+    painter->setRenderHints(QPainter::Antialiasing, borders);
+
+    QPointF vertices[7];
+    for (auto y = range.top(); y <= range.bottom(); y++)
+    {
+        for (auto x = range.left(); x <= range.right(); x++)
+        {
+            const auto hex = grid_->cellAt(x, y);
+            const auto terr = hex->territory();
+            if (!terr || !terr->owner()) continue;
+
+            const auto color = terr->selected() ? QColor(Qt::black) : terr->owner()->lightColor();
+            painter->setPen(QPen(color, 2)); // With this trick, no gaps are shown; otherwise, set color as Qt::transparent
+            painter->setBrush(color);
+
+            for (auto i = 0; i < 7; i++) vertices[i] = hex->center() + corners[i];
+            painter->drawPolygon(vertices, 7);
+        }
+    }
+
+    if (!borders) return;
+
+    // Borders go in a second pass so that the cells painted afterwards do not cover them, and the ones
+    // of the selected territories go last so that they are always shown above the rest
+    painter->setBrush(Qt::transparent);
+    for (auto selected : {false, true})
+    {
+        painter->setPen(QPen(selected ? Qt::red : Qt::black, 2));
+
+        for (auto y = range.top(); y <= range.bottom(); y++)
+        {
+            for (auto x = range.left(); x <= range.right(); x++)
+            {
+                const auto hex = grid_->cellAt(x, y);
+                const auto terr = hex->territory();
+                if (!terr || !terr->owner() || terr->selected() != selected) continue;
+
+                // TODO: possibly duplicated edges for two adjacent cells from different territories
+                for (auto i = 0; i < 6; i++)
+                {
+                    const auto neighbour = grid_->neighbour(hex, i);
+                    if (neighbour == nullptr || neighbour->territory() != terr)
+                    {
+                        painter->drawLine(hex->center() + corners[i], hex->center() + corners[i+1]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void HexLayer::paintOverview(QPainter *painter)
+{
+    if (overviewDirty_)
+    {
+        overview_ = QImage(grid_->gridWidth() * 2 + 1, grid_->gridHeight(), QImage::Format_ARGB32_Premultiplied);
+        overview_.fill(Qt::transparent);
+        for (auto y = 0; y < grid_->gridHeight(); y++)
+        {
+            for (auto x = 0; x < grid_->gridWidth(); x++) updateOverviewCell(x, y);
+        }
+        overviewDirty_ = false;
+    }
+
+    const auto horz = HexCoord(1, 0).centerX(grid_->radius());
+    const auto vert = HexCoord(0, 1).centerY(grid_->radius());
+
+    // Each pixel covers half a cell horizontally and a full row vertically
+    painter->drawImage(QRectF(-horz / 2, -vert / 2, overview_.width() * horz / 2, overview_.height() * vert), overview_);
+}
+
+void HexLayer::updateOverviewCell(int x, int y)
+{
+    const auto terr = grid_->cellAt(x, y)->territory();
+
+    QRgb color = 0;
+    if (terr && terr->owner()) color = terr->selected() ? qRgb(0, 0, 0) : terr->owner()->lightColor().rgb();
+
+    const auto line = reinterpret_cast<QRgb *>(overview_.scanLine(y));
+    const auto pixel = x * 2 + (y & 1);
+    line[pixel] = color;
+    line[pixel + 1] = color;
+}
+
+void HexLayer::updateTerritory(const Territory *territory)
+{
+    if (territory->cellCount() == 0 || !grid_->hasCells()) return;
+
+    const auto radius = grid_->radius();
+    QRectF area;
+    for (auto hex : territory->cells())
+    {
+        area |= QRectF(hex->center() - QPointF(radius, radius), QSizeF(radius * 2, radius * 2));
+
+        if (overviewDirty_) continue;
+        const auto position = hex->gridPosition();
+        updateOverviewCell(position.column(), position.row());
+    }
+
+    // Only the part of the layer covered by the territory needs to be repainted (borders included)
+    const auto zoom = grid_->zoom();
+    const QRectF rect(area.topLeft() * zoom + grid_->pan(), area.size() * zoom);
+    update(rect.adjusted(-2, -2, 2, 2).toAlignedRect());
+}
+
+void HexLayer::updateAll()
+{
+    overviewDirty_ = true;
+    update();
+}
@@ -0,0 +1,48 @@
+#ifndef HEXLAYER_H
+#define HEXLAYER_H
+
+#include <QtQuick/QQuickPaintedItem>
+#include <QImage>
+
+class HexGrid;
+class Territory;
+
+/// This class paints the hex cells of a HexGrid. It always has the size of the viewport, so only
+/// the cells that are currently visible are painted, with less detail the more zoomed out the board is
+class HexLayer final : public QQuickPaintedItem
+{
+    Q_OBJECT
+
+    HexGrid *grid_;
+
+    /// Low resolution picture of the whole board used when the cells are too small to be painted one
+    /// by one. Each cell takes two horizontal pixels so that odd rows can be shifted by half a cell
+    QImage overview_;
+
+    /// Whether overview_ needs to be regenerated before painting it
+    bool overviewDirty_ = true;
+
+    void paintCells(QPainter *painter, const QRect &range, bool borders);
+    void paintOverview(QPainter *painter);
+
+    void updateOverviewCell(int x, int y);
+
+public:
+    explicit HexLayer(HexGrid *grid);
+
+    void paint(QPainter *painter) override;
+
+    /// Schedules a repaint after the owner or the selection of the territory has changed
+    void updateTerritory(const Territory *territory);
+
+    /// Schedules a repaint of the whole board, e.g. after it has been regenerated
+    void updateAll();
+
+    /// Below this radius (in screen pixels), the borders between territories are not painted
+    static constexpr qreal BORDER_MIN_RADIUS = 6;
+
+    /// Below this radius (in screen pixels), the board is painted from the overview image
+    static constexpr qreal CELL_MIN_RADIUS = 3;
+};
+
+#endif // HEXLAYER_H
@@ -0,0 +1,262 @@
+#include "lockstepsession.h"
+
+#include "gamestate.h"
+#include "mapgenerator.h"
+
+#include <QDataStream>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+bool LockstepSession::Settings::isValid() const
+{
+    MapSettings map;
+    map.width = gridWidth;
+    map.height = gridHeight;
+    map.numTerritories = numTerritories;
+    map.territorySize = territorySize;
+    if (!map.isValid() || !createMapGenerator(generator.toStdString())) return false;
+
+    if (seatOwners.size() < 2 || seatOwners.size() > GameState::MAX_PLAYERS) return false;
+    for (auto owner : seatOwners)
+    {
+        if (owner != AI && owner != HostPlayer && owner != GuestPlayer) return false;
+    }
+    return true;
+}
+
+LockstepSession::LockstepSession(QObject *parent) : QObject(parent)
+{
+}
+
+bool LockstepSession::listen(quint16 port)
+{
+    host_ = true;
+    server_ = new QTcpServer(this);
+    connect(server_, &QTcpServer::newConnection, this, &LockstepSession::acceptConnection);
+    return server_->listen(QHostAddress::Any, port);
+}
+
+void LockstepSession::connectToHost(const QString &address, quint16 port)
+{
+    host_ = false;
+    auto socket = new QTcpSocket(this);
+    connect(socket, &QTcpSocket::connected, this, &LockstepSession::connectedChanged);
+    setSocket(socket);
+    socket->connectToHost(address, port);
+}
+
+bool LockstepSession::isActive() const
+{
+    return server_ || socket_;
+}
+
+bool LockstepSession::isHost() const
+{
+    return host_;
+}
+
+bool LockstepSession::connected() const
+{
+    return socket_ && socket_->state() == QAbstractSocket::ConnectedState;
+}
+
+const LockstepSession::Settings &LockstepSession::settings() const
+{
+    return settings_;
+}
+
+bool LockstepSession::isLocalSeat(int seat) const
+{
+    return settings_.seatOwners.value(seat, AI) == (host_ ? HostPlayer : GuestPlayer);
+}
+
+bool LockstepSession::isRemoteSeat(int seat) const
+{
+    return settings_.seatOwners.value(seat, AI) == (host_ ? GuestPlayer : HostPlayer);
+}
+
+void LockstepSession::sendStart(const Settings &settings)
+{
+    if (!host_ || !connected() || !settings.isValid()) return;
+
+    settings_ = settings;
+    resetGame();
+
+    QDataStream out(socket_);
+    out << static_cast<quint8>(StartMessage) << PROTOCOL_VERSION << settings.seed
+        << settings.gridWidth << settings.gridHeight << settings.numTerritories << settings.territorySize
+        << settings.generator << static_cast<quint8>(settings.seatOwners.size());
+    for (auto owner : settings.seatOwners) out << owner;
+}
+
+void LockstepSession::sendAttack(int from, int to)
+{
+    if (!connected()) return;
+
+    // 5 bytes per attack
+    QDataStream out(socket_);
+    out << static_cast<quint8>(AttackMessage) << static_cast<quint16>(from) << static_cast<quint16>(to);
+}
+
+void LockstepSession::sendEndTurn()
+{
+    if (!connected()) return;
+
+    QDataStream out(socket_);
+    out << static_cast<quint8>(EndTurnMessage);
+}
+
+void LockstepSession::checkHash(int turn, quint64 hash)
+{
+    if (!connected()) return;
+
+    QDataStream out(socket_);
+    out << static_cast<quint8>(HashMessage) << static_cast<qint32>(turn) << hash;
+
+    localHashes_.insert(turn, hash);
+    compareHashes(turn);
+}
+
+bool LockstepSession::hasAction() const
+{
+    return !actions_.empty();
+}
+
+LockstepSession::Action LockstepSession::takeAction()
+{
+    return actions_.dequeue();
+}
+
+void LockstepSession::acceptConnection()
+{
+    while (server_->hasPendingConnections())
+    {
+        auto socket = server_->nextPendingConnection();
+
+        // Only one guest can play at a time
+        if (connected())
+        {
+            socket->close();
+            socket->deleteLater();
+            continue;
+        }
+
+        setSocket(socket);
+        emit connectedChanged();
+    }
+}
+
+void LockstepSession::setSocket(QTcpSocket *socket)
+{
+    if (socket_) socket_->deleteLater();
+    socket_ = socket;
+
+    // Messages are tiny and every one of them is waited for, so they must not be delayed to be batched
+    socket_->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    connect(socket_, &QTcpSocket::readyRead, this, &LockstepSession::readMessages);
+    connect(socket_, &QTcpSocket::disconnected, this, &LockstepSession::disconnected);
+}
+
+void LockstepSession::readMessages()
+{
+    QDataStream in(socket_);
+
+    // Every message is read in a transaction, so an incomplete one is read again when the rest arrives
+    while (socket_ && socket_->bytesAvailable() > 0)
+    {
+        in.startTransaction();
+
+        quint8 type;
+        in >> type;
+
+        Action action;
+        qint32 turn = 0;
+        quint64 hash = 0;
+        Settings settings;
+        quint8 version = 0;
+
+        switch (type)
+        {
+        case StartMessage:
+        {
+            quint8 seatCount = 0;
+            in >> version >> settings.seed >> settings.gridWidth >> settings.gridHeight
+               >> settings.numTerritories >> settings.territorySize >> settings.generator >> seatCount;
+            settings.seatOwners.resize(seatCount);
+            for (auto &owner : settings.seatOwners) in >> owner;
+            break;
+        }
+        case AttackMessage:
+        {
+            quint16 from = 0, to = 0;
+            in >> from >> to;
+            action.type = Action::Attack;
+            action.from = from;
+            action.to = to;
+            break;
+        }
+        case EndTurnMessage:
+            action.type = Action::EndTurn;
+            break;
+        case HashMessage:
+            in >> turn >> hash;
+            break;
+        default:
+            // Not a message of this protocol, so nothing else can be trusted either
+            in.abortTransaction();
+            socket_->abort();
+            return;
+        }
+
+        if (!in.commitTransaction()) return;
+
+        switch (type)
+        {
+        case StartMessage:
+            if (version != PROTOCOL_VERSION || host_) break;
+            if (!settings.isValid())
+            {
+                // The host is not playing the same game, or not playing fair, so nothing else can be trusted either
+                socket_->abort();
+                return;
+            }
+            settings_ = settings;
+            resetGame();
+            emit started();
+            break;
+        case AttackMessage:
+        case EndTurnMessage:
+            actions_.enqueue(action);
+            emit actionReceived();
+            break;
+        case HashMessage:
+            remoteHashes_.insert(turn, hash);
+            compareHashes(turn);
+            break;
+        }
+    }
+}
+
+void LockstepSession::disconnected()
+{
+    socket_->deleteLater();
+    socket_ = nullptr;
+    emit connectedChanged();
+}
+
+void LockstepSession::resetGame()
+{
+    actions_.clear();
+    localHashes_.clear();
+    remoteHashes_.clear();
+}
+
+void LockstepSession::compareHashes(int turn)
+{
+    if (!localHashes_.contains(turn) || !remoteHashes_.contains(turn)) return;
+
+    const auto local = localHashes_.take(turn);
+    const auto remote = remoteHashes_.take(turn);
+    if (local != remote) emit desync(turn);
+}
@@ -0,0 +1,146 @@
+#ifndef LOCKSTEPSESSION_H
+#define LOCKSTEPSESSION_H
+
+#include <QHash>
+#include <QObject>
+#include <QQueue>
+#include <QVector>
+
+class QTcpServer;
+class QTcpSocket;
+
+/// This class connects two game processes over TCP so that their human players can play the same game.
+/// The board is never sent: the host sends the settings and the seed of the game once, and from then on
+/// only the inputs of the human players (attacks and turn ends) are exchanged. Both peers resolve every
+/// roll and dice distribution from the same random generator, so they stay in sync as long as they apply
+/// the same inputs in the same order. A hash of the board is exchanged after every turn to detect it if
+/// they ever diverge
+class LockstepSession : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool connected READ connected NOTIFY connectedChanged)
+    Q_PROPERTY(bool host READ isHost CONSTANT)
+
+public:
+    /// Who controls each seat of the game
+    enum SeatOwner
+    {
+        AI = 0,
+        HostPlayer = 1,
+        GuestPlayer = 2
+    };
+
+    /// Everything the guest needs to set up exactly the same game as the host
+    struct Settings
+    {
+        quint64 seed = 0;
+        qint32 gridWidth = 0;
+        qint32 gridHeight = 0;
+        qint32 numTerritories = 0;
+        qint32 territorySize = 0;
+
+        /// Name of the MapGenerator of the board
+        QString generator;
+
+        QVector<qint8> seatOwners;
+
+        /// Whether a game can be set up from the settings: the board fits the limits of MapSettings with a known
+        /// generator, and there are between 2 and GameState::MAX_PLAYERS seats. The settings received from the host
+        /// are rejected otherwise, as nothing else checks them before allocating the board
+        bool isValid() const;
+    };
+
+    struct Action
+    {
+        enum Type
+        {
+            Attack,
+            EndTurn
+        };
+
+        Type type = EndTurn;
+        int from = -1;
+        int to = -1;
+    };
+
+    explicit LockstepSession(QObject *parent = nullptr);
+
+    /// Waits for a guest on the given port. Returns false if the port cannot be used
+    bool listen(quint16 port);
+
+    /// Connects to a host
+    void connectToHost(const QString &address, quint16 port);
+
+    /// Whether this process is hosting or joining a game at all
+    bool isActive() const;
+
+    bool isHost() const;
+    bool connected() const;
+
+    /// The settings of the current game, as sent by the host
+    const Settings &settings() const;
+
+    /// Whether the seat is played by a human in this process or in the other one
+    bool isLocalSeat(int seat) const;
+    bool isRemoteSeat(int seat) const;
+
+    /// Sends the settings of a new game to the guest (only for the host, and only if they are valid)
+    void sendStart(const Settings &settings);
+
+    void sendAttack(int from, int to);
+    void sendEndTurn();
+
+    /// Sends the hash of the board after the given turn, and compares it with the one of the other peer
+    /// once both are known
+    void checkHash(int turn, quint64 hash);
+
+    /// Inputs received from the other peer and not applied yet, in the order they were performed
+    bool hasAction() const;
+    Action takeAction();
+
+    /// Version of the messages, sent with every game start
+    static constexpr quint8 PROTOCOL_VERSION = 2;
+
+signals:
+    void connectedChanged();
+
+    /// A new game has been started by the host; settings() has its parameters
+    void started();
+
+    void actionReceived();
+
+    /// The boards of both peers were different after the given turn
+    void desync(int turn);
+
+private slots:
+    void acceptConnection();
+    void readMessages();
+    void disconnected();
+
+private:
+    /// First byte of every message
+    enum MessageType : quint8
+    {
+        StartMessage = 'S',
+        AttackMessage = 'A',
+        EndTurnMessage = 'E',
+        HashMessage = 'H'
+    };
+
+    void setSocket(QTcpSocket *socket);
+    void resetGame();
+    void compareHashes(int turn);
+
+    QTcpServer *server_ = nullptr;
+    QTcpSocket *socket_ = nullptr;
+    bool host_ = false;
+
+    Settings settings_;
+    QQueue<Action> actions_;
+
+    /// Hashes of the turns still waiting for the hash of the other peer
+    QHash<int, quint64> localHashes_;
+    QHash<int, quint64> remoteHashes_;
+};
+
+#endif // LOCKSTEPSESSION_H
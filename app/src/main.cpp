@@ -1,19 +1,86 @@
 #include "hexgrid.h"
-#include "hex.h"
+#include "lockstepsession.h"
+#include "resourcecache.h"
 
+#include <QDebug>
+#include <QElapsedTimer>
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
+#include <QQmlContext>
+#include <QQuickWindow>
+#include <QSharedPointer>
 #include <QIcon>
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startup;
+    startup.start();
+
     QGuiApplication app(argc, argv);
 
+    // The pictures and fonts are decoded while the QML is loaded and the menu is shown
+    ResourceCache resources;
+    resources.preload();
+
     qmlRegisterType<HexGrid>("Hex", 1, 0, "HexGrid");
-    qmlRegisterType<Hex>("Hex", 1, 0, "Hex");
+    qmlRegisterUncreatableType<LockstepSession>("Hex", 1, 0, "LockstepSession", "Created from the command line");
+
+    // Network games: "--host <port>" waits for another player, "--join <address>:<port>" connects to them.
+    // "--telemetry <file>" writes the counters of the games won to the file as JSON
+    LockstepSession session;
+    QString telemetryPath;
+    const auto arguments = QCoreApplication::arguments();
+    for (auto i = 1; i + 1 < arguments.size(); i++)
+    {
+        if (arguments.at(i) == "--host")
+        {
+            if (!session.listen(static_cast<quint16>(arguments.at(i + 1).toUInt()))) qWarning() << "Cannot listen on port" << arguments.at(i + 1);
+        }
+        else if (arguments.at(i) == "--join")
+        {
+            const auto address = arguments.at(i + 1);
+            const auto separator = address.lastIndexOf(':');
+            session.connectToHost(address.left(separator), static_cast<quint16>(address.mid(separator + 1).toUInt()));
+        }
+        else if (arguments.at(i) == "--telemetry")
+        {
+            telemetryPath = arguments.at(i + 1);
+        }
+    }
 
     QQmlApplicationEngine engine;
+
+    engine.rootContext()->setContextProperty("lockstep", session.isActive() ? &session : nullptr);
+
+    // Maps generated with the maplibrary tool are used when the file is next to the executable
+    engine.rootContext()->setContextProperty("mapLibraryPath", QCoreApplication::applicationDirPath() + "/maps.dwl");
+
+    engine.rootContext()->setContextProperty("telemetryPath", telemetryPath);
+
+    engine.rootContext()->setContextProperty("resources", &resources);
+
     engine.load(QUrl(QStringLiteral("qrc:/main.qml")));
 
+    // "--timing" prints how long it takes to get from main() to the menu on screen
+    if (arguments.contains("--timing"))
+    {
+        qInfo() << "QML loaded after" << startup.elapsed() << "ms";
+        QObject::connect(&resources, &ResourceCache::titleFontChanged, [&startup]()
+        {
+            qInfo() << "Resources decoded after" << startup.elapsed() << "ms";
+        });
+
+        const auto window = engine.rootObjects().empty() ? nullptr : qobject_cast<QQuickWindow *>(engine.rootObjects().first());
+        if (window)
+        {
+            auto connection = QSharedPointer<QMetaObject::Connection>::create();
+            *connection = QObject::connect(window, &QQuickWindow::frameSwapped, [&startup, connection]()
+            {
+                qInfo() << "First frame after" << startup.elapsed() << "ms";
+                QObject::disconnect(*connection);
+            });
+        }
+    }
+
     return app.exec();
 }
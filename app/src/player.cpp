@@ -1,36 +1,31 @@
 #include "player.h"
 
+#include "resourcecache.h"
 #include "territory.h"
 
-#include <functional>
+void Player::reset()
+{
+    territories_.clear();
+    human_ = false;
+}
 
 QColor Player::color() const
 {
     return color_;
 }
 
+QColor Player::lightColor() const
+{
+    return lightColor_;
+}
+
 void Player::appendTerritory(Territory *territory)
 {
     if (territory == nullptr) return;
     auto tOwner = territory->owner();
     territory->setOwner(this);
-    if (tOwner != nullptr)
-    {
-        tOwner->territories_.removeAll(territory);
-        tOwner->calculateConnTerr();
-    }
+    if (tOwner != nullptr) tOwner->territories_.removeAll(territory);
     territories_.append(territory);
-    calculateConnTerr();
-}
-
-void Player::removeTerritory(Territory *territory)
-{
-    if (territory == nullptr) return;
-    // The removeAll() method might be a bit slow when using a QVector, but otherwise
-    // the at() method in distributeDice() would be even slower
-    territories_.removeAll(territory);
-    territory->setOwner(nullptr);
-    calculateConnTerr();
 }
 
 QSharedPointer<QPixmap> Player::dicePixmap(int diceValue) const
@@ -50,8 +45,11 @@ int Player::playerNumber() const
 
 void Player::setPlayerNumber(int playerNumber)
 {
-    if (playerNumber > 7) playerNumber = 7;
+    if (playerNumber >= StandardRules::MAX_PLAYERS) playerNumber = StandardRules::MAX_PLAYERS - 1;
     if (playerNumber < 0) playerNumber = 0;
+
+    // Reused players keep their colors and pictures
+    if (playerNumber == playerNumber_ && !pixmaps_.empty()) return;
     playerNumber_ = playerNumber;
 
     // Pre-defined player colors for players 0 to 7
@@ -85,47 +83,21 @@ void Player::setPlayerNumber(int playerNumber)
             color_ = Qt::black;
     }
 
-    pixmaps_.clear();
+    lightColor_ = color_.lighter();
 
-    for (auto i = 1; i <= 6; i++)
-    {
-        auto path = QString(":/pixmaps/Player%1_Dice%2.png").arg(playerNumber).arg(i);
-        pixmaps_.append(QSharedPointer<QPixmap>::create(path));
-    }
-}
+    pixmaps_.clear();
 
-void Player::calculateConnTerr()
-{
-    // This is a list that contains the territories that have already been scanned
-    // when detecting the max contiguous number
-    QList<Territory *> scanned;
-
-    // Capturing everything by reference is not usually a good idea; however, in this
-    // case the lambda function never leaves this method, so there is no chance for
-    // it to outlive this class
-    std::function<int (Territory *)> scanTerr = [&](Territory *tScan)
+    // The pictures are normally decoded in the background while the menu is shown
+    const auto cache = ResourceCache::instance();
+    for (auto i = 1; i <= StandardRules::DICE_SIDES; i++)
     {
-        auto result = 1; //There will be at least one contiguous territory: itself
-        for (auto neighbour : tScan->neighbours())
+        if (cache)
         {
-            if (neighbour->owner() == this && !scanned.contains(neighbour))
-            {
-                scanned.append(neighbour);
-                result += scanTerr(neighbour);
-            }
+            pixmaps_.append(cache->dicePixmap(playerNumber, i));
+            continue;
         }
-        return result;
-    };
-
-    connectedTerritories_ = 0;
-
-    for (auto terr : territories_)
-    {
-        if (scanned.contains(terr)) continue;
-        scanned.append(terr);
-
-        const auto numConn = scanTerr(terr);
-        if (numConn > connectedTerritories_) connectedTerritories_ = numConn;
+        auto path = QString(":/pixmaps/Player%1_Dice%2.png").arg(playerNumber).arg(i);
+        pixmaps_.append(QSharedPointer<QPixmap>::create(path));
     }
 }
 
@@ -138,55 +110,3 @@ void Player::setHuman(bool human)
 {
     human_ = human;
 }
-
-int Player::remainingDice() const
-{
-    return remainingDice_;
-}
-
-void Player::addDice(int numDice, bool distributeThem)
-{
-    remainingDice_ += numDice;
-    if (remainingDice_ > MAX_REMAINING_DICE) remainingDice_ = MAX_REMAINING_DICE;
-
-    if (distributeThem) distributeDice(remainingDice_);
-}
-
-bool Player::distributeDice(int numDice)
-{
-    if (numDice > remainingDice_) numDice = remainingDice_;
-
-    //For each remaining dice, a random territory is chosen. If that territory has
-    // already 8 dice, it is skipped, otherwise a dice is added. If all the
-    // territories have been skipped because they are all full, the process stops
-    const auto size = territories_.size();
-
-    for (auto diceCount = 0; diceCount < numDice; diceCount++)
-    {
-        auto added = false;
-        const auto startIndex = qrand() % size;
-        for (auto offsetIndex = 0; offsetIndex < size; offsetIndex++)
-        {
-            auto terr = territories_.at((startIndex + offsetIndex) % size);
-            if (terr->numDice() < Territory::MAX_DICE)
-            {
-                terr->addDice(1);
-                remainingDice_--;
-                terr->update();
-                added = true;
-                break;
-            }
-        }
-        if (!added) return false;
-    }
-
-    return true;
-}
-
-int Player::connectedTerritories() const
-{
-    return connectedTerritories_;
-}
-
-
-
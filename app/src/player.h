@@ -4,6 +4,8 @@
 #include <QColor>
 #include <QPixmap>
 
+#include "rules.h"
+
 class Territory;
 
 /// This class controls all statistics and actions that a player sees / can perform
@@ -14,37 +16,27 @@ class Player
 
     /// The color associated to this player. It will determine the dice pictures to use
     QColor color_;
-    
+
+    /// A lighter version of color_, used to paint the territories of this player
+    QColor lightColor_;
+
     /// The number of territories that this player controls
     QVector<Territory *> territories_;
 
     /// The 6 images of the dice used by this player with each possible side up
     QVector<QSharedPointer<QPixmap>> pixmaps_;
 
-    /// Calculates the maximum number of contiguous territories that this player has. This will be used
-    /// to determine the amount of dice that will be given to him after each turn
-    void calculateConnTerr();
-
-    /// The maximum number of territories that are both controlled by this player and
-    /// contiguous respect to each other. This will determine how many dice the player
-    /// receives at the end of his turn
-    int connectedTerritories_ = 1;
-
-    /// After assigning the corresponding dice when a turn ends, the ones that could not be allocated to
-    /// any territory because they were already full
-    int remainingDice_ = 0;
-
-    /// The maximum number of remaining dice
-    static const int MAX_REMAINING_DICE = 100;
-
     /// Determines whether the player is AI-controlled or not
     bool human_ = false;
 
 public:
+    /// Clears the territories of the player, so that it can be reused in another game
+    void reset();
+
     QColor color() const;
+    QColor lightColor() const;
 
     void appendTerritory(Territory *territory);
-    void removeTerritory(Territory *territory);
 
     QSharedPointer<QPixmap> dicePixmap(int diceValue) const;
     QSharedPointer<QPixmap> dicePixmap() const;
@@ -52,17 +44,6 @@ public:
     int playerNumber() const;
     void setPlayerNumber(int playerNumber);
 
-    int connectedTerritories() const;
-
-    int remainingDice() const;
-
-    /// Adds the specified number of dice to the stack
-    void addDice(int numDice, bool distributeThem = true);
-
-    /// Distributes the dice in the stack randomly to the territories. If all the dice
-    /// could not be distributed, it will return false
-    bool distributeDice(int numDice);
-
     bool human() const;
     void setHuman(bool human);
 
@@ -0,0 +1,98 @@
+#include "resourcecache.h"
+
+#include "rules.h"
+
+#include <QFile>
+#include <QFontDatabase>
+#include <QtConcurrent>
+
+ResourceCache *ResourceCache::instance_ = nullptr;
+
+ResourceCache::ResourceCache(QObject *parent)
+    : QObject(parent)
+{
+    instance_ = this;
+    connect(&watcher_, &QFutureWatcher<Resources>::finished, this, &ResourceCache::collect);
+}
+
+ResourceCache::~ResourceCache()
+{
+    watcher_.waitForFinished();
+    if (instance_ == this) instance_ = nullptr;
+}
+
+ResourceCache *ResourceCache::instance()
+{
+    return instance_;
+}
+
+void ResourceCache::preload()
+{
+    if (started_) return;
+    started_ = true;
+    watcher_.setFuture(QtConcurrent::run(&ResourceCache::load));
+}
+
+ResourceCache::Resources ResourceCache::load()
+{
+    Resources resources;
+    for (auto player = 0; player < StandardRules::MAX_PLAYERS; player++)
+    {
+        for (auto i = 1; i <= StandardRules::DICE_SIDES; i++)
+        {
+            resources.dice.append(QImage(QString(":/pixmaps/Player%1_Dice%2.png").arg(player).arg(i)));
+        }
+    }
+
+    QFile font(":/fonts/unlearn2.ttf");
+    if (font.open(QIODevice::ReadOnly)) resources.titleFont = font.readAll();
+
+    return resources;
+}
+
+void ResourceCache::collect()
+{
+    if (collected_) return;
+
+    // Called either when the background thread finishes, or earlier by someone who cannot wait
+    preload();
+    watcher_.waitForFinished();
+    collected_ = true;
+
+    auto resources = watcher_.result();
+    dice_ = resources.dice;
+    pixmaps_.resize(dice_.size());
+
+    // Registering the font is quick, but must be done from the GUI thread
+    const auto id = QFontDatabase::addApplicationFontFromData(resources.titleFont);
+    const auto families = QFontDatabase::applicationFontFamilies(id);
+    if (!families.empty())
+    {
+        titleFont_ = families.first();
+        emit titleFontChanged();
+    }
+}
+
+QSharedPointer<QPixmap> ResourceCache::dicePixmap(int player, int diceValue)
+{
+    collect();
+
+    const auto index = player * StandardRules::DICE_SIDES + diceValue - 1;
+    if (index < 0 || index >= pixmaps_.size()) return QSharedPointer<QPixmap>::create();
+
+    if (!pixmaps_.at(index)) pixmaps_[index] = QSharedPointer<QPixmap>::create(QPixmap::fromImage(dice_.at(index)));
+    return pixmaps_.at(index);
+}
+
+QImage ResourceCache::diceImage(int player, int diceValue)
+{
+    collect();
+
+    const auto index = player * StandardRules::DICE_SIDES + diceValue - 1;
+    return index >= 0 && index < dice_.size() ? dice_.at(index) : QImage();
+}
+
+QString ResourceCache::titleFont() const
+{
+    return titleFont_;
+}
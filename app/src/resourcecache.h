@@ -0,0 +1,70 @@
+#ifndef RESOURCECACHE_H
+#define RESOURCECACHE_H
+
+#include <QFutureWatcher>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSharedPointer>
+#include <QVector>
+
+/// This class decodes the pictures and fonts of the game on a background thread as soon as the process
+/// starts, so that nothing is decoded on the GUI thread while the menu is shown or when the first game
+/// starts. Only QImage can be used outside of the GUI thread, so the pixmaps are made from the decoded
+/// images the first time they are requested
+class ResourceCache : public QObject
+{
+    Q_OBJECT
+
+    /// The family of the font of the titles, or an empty string until it has been loaded
+    Q_PROPERTY(QString titleFont READ titleFont NOTIFY titleFontChanged)
+
+public:
+    explicit ResourceCache(QObject *parent = nullptr);
+    ~ResourceCache();
+
+    /// The cache created by main(), or nullptr if there is none
+    static ResourceCache *instance();
+
+    /// Starts decoding everything in the background. Does nothing if it was already started
+    void preload();
+
+    /// The picture of a die of the player with the given side up (from 1). This must only be called from the
+    /// GUI thread, and waits for the background thread if it has not finished yet
+    QSharedPointer<QPixmap> dicePixmap(int player, int diceValue);
+
+    /// Same as above as an image, e.g. for making textures of the scene graph. Same threading rules
+    QImage diceImage(int player, int diceValue);
+
+    QString titleFont() const;
+
+signals:
+    void titleFontChanged();
+
+private:
+    /// Everything decoded by the background thread
+    struct Resources
+    {
+        /// The dice of each player one after another, with each possible side up
+        QVector<QImage> dice;
+
+        QByteArray titleFont;
+    };
+
+    static Resources load();
+
+    /// Takes the result of the background thread, once
+    void collect();
+
+    static ResourceCache *instance_;
+
+    QFutureWatcher<Resources> watcher_;
+    bool started_ = false;
+    bool collected_ = false;
+
+    QVector<QImage> dice_;
+    QVector<QSharedPointer<QPixmap>> pixmaps_;
+    QString titleFont_;
+};
+
+#endif // RESOURCECACHE_H
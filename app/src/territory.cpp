@@ -52,6 +52,18 @@ void Territory::paint(QPainter *painter)
     }
 }
 
+void Territory::reset()
+{
+    owner_ = nullptr;
+    selected_ = false;
+    numDice_ = 1;
+    cells_.clear();
+    neighbours_.clear();
+    center_ = QPointF(-1, -1);
+    setVisible(false);
+    update();
+}
+
 Player *Territory::owner() const
 {
     return owner_;
@@ -60,7 +72,6 @@ Player *Territory::owner() const
 void Territory::setOwner(Player *value)
 {
     owner_ = value;
-    if (!value) regenerateNeighbours(); //As not owned territories do not appear in the neighbours list, this needs a recalculation
 }
 
 int Territory::cellCount() const
@@ -68,119 +79,19 @@ int Territory::cellCount() const
     return cells_.size();
 }
 
-void Territory::appendCell(Hex *cell)
+void Territory::assignCells(const QVector<Hex *> &cells, const QVector<Territory *> &neighbours)
 {
-    if (cell == nullptr) return;
-
-    const auto grid = qobject_cast<HexGrid *>(parent());
-
-    auto cTerritory = cell->territory();
-    if (cTerritory != nullptr)
-    {
-        cTerritory->cells_.removeAll(cell);
-        regenerateNeighbours();
-    }
-    else if (grid)
-    {
-        for (auto i = 0; i < 6; i++)
-        {
-            const auto neighbour = grid->neighbour(cell, i);
-            if (!neighbour) continue;
-            auto terr = neighbour->territory();
-            if (terr && terr != this && terr->owner())
-            {
-                if (!neighbours_.contains(terr)) neighbours_.append(terr);
-                if (!terr->neighbours_.contains(this)) terr->neighbours_.append(this);
-            }
-        }
-    }
-    cells_.append(cell);
-    cell->setTerritory(this);
+    cells_ = cells;
+    for (auto cell : cells_) cell->setTerritory(this);
+    neighbours_ = neighbours;
     calculateCenter();
 }
 
-void Territory::removeCell(Hex *cell)
-{
-    if (cell == nullptr) return;
-    cells_.removeAll(cell);
-    cell->setTerritory(nullptr);
-    calculateCenter();
-    regenerateNeighbours();
-}
-
-void Territory::updateAll() //The cells are not automatically updated because they are not their children actually: they are the grid's children
+void Territory::updateAll() //The cells are not items, so they are repainted by the grid instead
 {
     update();
-    for (auto hex : cells_) hex->update();
-}
-
-Hex *Territory::findEmptyAdjacent() const
-{
-    //Note: the function assumes the qsrand() function has been previously used
-
-    if (cells_.empty()) return nullptr;
-    const auto grid = qobject_cast<HexGrid *>(parent());
-    if (!grid) return nullptr;
-
-    const auto size = cells_.size();
-    const auto indexOffset = qrand() % size;
-    for (auto indexBase = 0; indexBase < size; indexBase++)
-    {
-        const auto hex = cells_.at((indexBase + indexOffset) % size);
-
-        const auto dirOffset = qrand() % 6;    //Putting this outside this for loop should be random enough, but this looks cleaner
-        for (auto dirBase = 0; dirBase < 6; dirBase++)
-        {
-            const auto neighbour = grid->neighbour(hex, (dirBase + dirOffset) % 6);
-
-            if (neighbour != nullptr && neighbour->territory() == nullptr) return neighbour;
-        }
-    }
-
-    return nullptr;
-}
-
-int Territory::grow(int numCells)
-{
-    // Note: this function assumes qsrand() has been previously used
-
-    if (cells_.empty()) return 0;
     const auto grid = qobject_cast<HexGrid *>(parent());
-    if (!grid) return 0;
-
-    auto size = cells_.size();
-    for (auto cellCount = 0; cellCount < numCells; cellCount++)
-    {
-        auto cellAdded = false;
-
-        const auto indexOffset = qrand() % size;
-        for (auto indexBase = 0; indexBase < size; indexBase++)
-        {
-            const auto hex = cells_.at((indexBase + indexOffset) % size);
-
-            // Putting this outside the indexBase for loop should be random enough, but this looks cleaner
-            const auto dirOffset = qrand() % 6;
-
-            for (auto dirBase = 0; dirBase < 6; dirBase++)
-            {
-                const auto neighbour = grid->neighbour(hex, (dirBase + dirOffset) % 6);
-
-                if (neighbour != nullptr && neighbour->territory() == nullptr)
-                {
-                    cellAdded = true;
-                    appendCell(neighbour);
-                    size++;
-                    break;
-                }
-            }
-
-            if (cellAdded) break;
-        }
-
-        if (!cellAdded) return cellCount;
-    }
-
-    return numCells;
+    if (grid) grid->updateTerritory(this);
 }
 
 void Territory::calculateCenter()
@@ -241,32 +152,6 @@ bool Territory::selected() const
 void Territory::setSelected(bool selected)
 {
     selected_ = selected;
-    for (auto hex : cells_)
-    {
-        if (selected)
-            hex->setZ(0);
-        else
-            hex->setZ(-1);
-    }
     updateAll();
 }
 
-
-void Territory::regenerateNeighbours() //Territories with no owner do not appear in the neighbours list
-{
-    const auto grid = qobject_cast<HexGrid *>(parent());
-    if (!grid) return;
-
-    neighbours_.clear();
-
-    for (auto cell : cells_)
-    {
-        for (auto i = 0; i < 6; i++)
-        {
-            const auto neighbour = grid->neighbour(cell, i);
-            if (!neighbour) continue;
-            auto terr = neighbour->territory();
-            if (terr && terr != this && terr->owner() && !neighbours_.contains(terr)) neighbours_.append(terr);
-        }
-    }
-}
@@ -3,6 +3,8 @@
 
 #include <QtQuick/QQuickPaintedItem>
 
+#include "rules.h"
+
 class Hex;
 class Player;
 
@@ -28,28 +30,28 @@ class Territory : public QQuickPaintedItem
     /// Other territories adjacent to this one. Once precalculated at the game start, the list will not change
     QVector<Territory *> neighbours_;
 
-    /// To regenerate neighbours. The appendCell function is usually capable of generating the neighbours without using this
-    void regenerateNeighbours();
-
 public:
     explicit Territory(QQuickItem* parent = nullptr);
 
     void paint(QPainter *painter) override;
 
+    /// Brings the territory back to the state it had when created, so that it can be reused in another game.
+    /// The memory for its cells and neighbours is kept
+    void reset();
+
     Player *owner() const;
     void setOwner(Player *value);
 
     int cellCount() const;
-    void appendCell(Hex *cell);
-    void removeCell(Hex *cell);
 
-    void updateAll();
+    // This getter is defined here to ensure auto works
+    const auto& cells() const { return cells_; }
 
-    /// Finds an empty hex cell adjacent to this territory. If there are no empty hex cells, it will return 0
-    Hex *findEmptyAdjacent() const;
+    /// Sets all the cells and neighbours at once, as generated in a MapTopology, and places the item at the
+    /// center of the cells
+    void assignCells(const QVector<Hex *> &cells, const QVector<Territory *> &neighbours);
 
-    /// Attempts to increase the hex cells of the territory by the number specified; returns the actual number of cells that could be added
-    int grow(int numCells);
+    void updateAll();
 
     /// Calculates the center of the territory based on the attached hex cells. If no hex cells are attached, mCenter will be (-1,-1)
     void calculateCenter();
@@ -71,7 +73,7 @@ public:
     // Size of the dice, in pixels
     static constexpr int DICE_SIZE = 28;
 
-    static constexpr int MAX_DICE = 8;
+    static constexpr int MAX_DICE = StandardRules::MAX_DICE;
 };
 
 #endif // TERRITORY_H
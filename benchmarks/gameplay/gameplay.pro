@@ -0,0 +1,20 @@
+TEMPLATE = app
+
+TARGET = gameplaybench
+
+CONFIG += console
+CONFIG -= qt app_bundle
+
+include(../../engine/engine.pri)
+
+# The corpus is read from the sources, so the benchmark can run from any build directory
+DEFINES += GAMEPLAY_CORPUS=\\\"$$PWD/corpus.txt\\\"
+
+# Peak memory of the process
+win32: LIBS += -lpsapi
+
+SOURCES += \
+    main.cpp
+
+DISTFILES += \
+    corpus.txt
@@ -0,0 +1,395 @@
+// Plays whole games end to end, from generating the map to the last attack, for every preset of a corpus of
+// boards and seeds (corpus.txt), and reports the time spent generating and playing, the time per turn, the
+// latency of the decisions of the AI and the peak memory of the process. Everything runs on a single thread,
+// and the games only depend on the corpus, so two runs on the same machine are directly comparable.
+//
+//   gameplaybench [--corpus corpus.txt] [--repeat 3] [--save baseline.txt]
+//                 [--baseline baseline.txt --time-threshold 10 --memory-threshold 20]
+//
+// With --baseline, every figure is compared with the file saved by an earlier run with --save, and the
+// benchmark fails (exit code 2) if any time grew by more than --time-threshold percent or the peak memory by
+// more than --memory-threshold percent. The percentiles of the latency must also grow by more than a bucket of
+// LatencyHistogram. The times are the fastest of the repetitions, to leave out the noise of the machine
+
+#include "latencyhistogram.h"
+#include "mapgenerator.h"
+#include "match.h"
+#include "policy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifndef GAMEPLAY_CORPUS
+#define GAMEPLAY_CORPUS "corpus.txt"
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    struct Preset
+    {
+        std::string name;
+        MapSettings settings;
+        std::string generator;
+        std::vector<std::string> seats;
+        std::uint64_t firstSeed = 1;
+        std::uint64_t lastSeed = 1;
+    };
+
+    /// A figure of the report, as saved in the baselines
+    struct Metric
+    {
+        std::string preset;
+        std::string name;
+        double value = 0;
+
+        enum Kind
+        {
+            Time,
+
+            /// Percentiles of LatencyHistogram, which can only move a whole bucket at a time
+            Latency,
+
+            Memory,
+
+            /// Counts that only change with the games played, e.g. after changing the rules or the AI
+            Count
+        } kind = Time;
+    };
+
+    /// Measures every decision of the policy it plays for
+    class TimedPolicy final : public Policy
+    {
+        std::unique_ptr<Policy> policy_;
+        LatencyHistogram &latency_;
+
+    public:
+        TimedPolicy(std::unique_ptr<Policy> policy, LatencyHistogram &latency)
+            : policy_(std::move(policy)), latency_(latency)
+        {
+        }
+
+        bool chooseAttack(const GameState &state, int &from, int &to) override
+        {
+            const auto start = Clock::now();
+            const auto attack = policy_->chooseAttack(state, from, to);
+            latency_.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+            return attack;
+        }
+
+        std::string name() const override
+        {
+            return policy_->name();
+        }
+
+        void setCandidates(const AttackCandidates *candidates) override
+        {
+            Policy::setCandidates(candidates);
+            policy_->setCandidates(candidates);
+        }
+    };
+
+    std::vector<std::string> split(const char *text)
+    {
+        std::vector<std::string> parts(1);
+        for (; *text; text++)
+        {
+            if (*text == ',') parts.emplace_back();
+            else parts.back() += *text;
+        }
+        return parts;
+    }
+
+    /// Reads the presets of the corpus, skipping empty lines and comments. Returns false, after reporting the
+    /// line, if any of them is not valid
+    bool readCorpus(const char *fileName, std::vector<Preset> &presets)
+    {
+        const auto file = std::fopen(fileName, "r");
+        if (!file)
+        {
+            std::fprintf(stderr, "Could not open %s\n", fileName);
+            return false;
+        }
+
+        char line[1024];
+        auto number = 0;
+        auto valid = true;
+        while (valid && std::fgets(line, sizeof(line), file))
+        {
+            number++;
+            char name[64], board[32], generator[64], seats[512], seeds[64];
+            Preset preset;
+            if (std::sscanf(line, " %63s", name) != 1 || name[0] == '#') continue;
+
+            // A single seed is a range of one
+            unsigned long long first = 0, last = 0;
+            valid = std::sscanf(line, "%63s %31s %d %63s %511s %63s", name, board, &preset.settings.numTerritories,
+                                generator, seats, seeds) == 6
+                    && std::sscanf(board, "%dx%d", &preset.settings.width, &preset.settings.height) == 2
+                    && createMapGenerator(generator) != nullptr;
+            const auto parsed = std::sscanf(seeds, "%llu-%llu", &first, &last);
+            if (parsed == 1) last = first;
+            valid = valid && parsed >= 1;
+
+            preset.name = name;
+            preset.generator = generator;
+            preset.seats = split(seats);
+            preset.firstSeed = first;
+            preset.lastSeed = last;
+            valid = valid && preset.seats.size() >= 2 && preset.seats.size() <= static_cast<std::size_t>(GameState::MAX_PLAYERS)
+                    && first <= last;
+            if (valid) presets.push_back(preset);
+            else std::fprintf(stderr, "%s:%d: invalid preset\n", fileName, number);
+        }
+
+        std::fclose(file);
+        return valid && !presets.empty();
+    }
+
+    /// The most memory the process has had resident at once so far, in KB
+    double peakResidentKB()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return counters.PeakWorkingSetSize / 1024.0;
+#else
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024.0; // In bytes on macOS, in KB everywhere else
+#else
+        return static_cast<double>(usage.ru_maxrss);
+#endif
+#endif
+    }
+
+    /// Plays every game of the preset, as many times as requested, and adds its figures to the metrics.
+    /// Returns false if a policy of the preset is not valid or a map cannot be generated
+    bool runPreset(const Preset &preset, int repeat, std::vector<Metric> &metrics)
+    {
+        auto generator = createMapGenerator(preset.generator);
+        auto generateMs = 0.0, playMs = 0.0;
+        long long turns = 0, attacks = 0, won = 0;
+        LatencyHistogram latency;
+
+        for (auto run = 0; run < repeat; run++)
+        {
+            auto runGenerateMs = 0.0, runPlayMs = 0.0;
+            turns = attacks = won = 0;
+            for (auto seed = preset.firstSeed; seed <= preset.lastSeed; seed++)
+            {
+                auto start = Clock::now();
+                const auto map = generator->generate(preset.settings, seed);
+                runGenerateMs += elapsedMs(start);
+                if (!map)
+                {
+                    std::fprintf(stderr, "%s: could not generate the map of seed %llu\n", preset.name.c_str(), static_cast<unsigned long long>(seed));
+                    return false;
+                }
+
+                std::vector<std::unique_ptr<Policy>> owned;
+                std::vector<Policy *> policies;
+                for (std::size_t seat = 0; seat < preset.seats.size(); seat++)
+                {
+                    auto policy = createPolicy(preset.seats[seat], map, seed + seat);
+                    if (!policy)
+                    {
+                        std::fprintf(stderr, "%s: invalid AI configuration: %s\n", preset.name.c_str(), preset.seats[seat].c_str());
+                        return false;
+                    }
+                    owned.emplace_back(new TimedPolicy(std::move(policy), latency));
+                    policies.push_back(owned.back().get());
+                }
+
+                // Creating the policies is left out, as some of them allocate their caches up front
+                start = Clock::now();
+                Match match(map);
+                const auto result = match.play(policies, seed);
+                runPlayMs += elapsedMs(start);
+
+                turns += result.turns;
+                attacks += result.attacks;
+                won += result.winner >= 0;
+            }
+
+            if (run == 0 || runGenerateMs < generateMs) generateMs = runGenerateMs;
+            if (run == 0 || runPlayMs < playMs) playMs = runPlayMs;
+        }
+
+        const auto games = static_cast<double>(preset.lastSeed - preset.firstSeed + 1);
+        metrics.push_back({preset.name, "generate_ms", generateMs / games, Metric::Time});
+        metrics.push_back({preset.name, "game_ms", playMs / games, Metric::Time});
+        metrics.push_back({preset.name, "turn_us", turns > 0 ? 1000 * playMs / turns : 0, Metric::Time});
+        metrics.push_back({preset.name, "step_p50_us", latency.percentile(0.5) / 1000, Metric::Latency});
+        metrics.push_back({preset.name, "step_p99_us", latency.percentile(0.99) / 1000, Metric::Latency});
+        metrics.push_back({preset.name, "turns", static_cast<double>(turns), Metric::Count});
+        metrics.push_back({preset.name, "attacks", static_cast<double>(attacks), Metric::Count});
+        metrics.push_back({preset.name, "won", static_cast<double>(won), Metric::Count});
+
+        std::printf("%-10s %5.0f %9.2f %10.2f %9.2f %9.2f %9.2f %8lld %9lld %5lld %10.0f\n", preset.name.c_str(), games,
+                    generateMs / games, playMs / games, turns > 0 ? 1000 * playMs / turns : 0,
+                    latency.percentile(0.5) / 1000, latency.percentile(0.99) / 1000, turns, attacks, won, peakResidentKB());
+        std::fflush(stdout);
+        return true;
+    }
+
+    bool saveMetrics(const char *fileName, const std::vector<Metric> &metrics)
+    {
+        const auto file = std::fopen(fileName, "w");
+        if (!file) return false;
+
+        std::fprintf(file, "# Baseline of the gameplay benchmark: preset, figure and value\n");
+        for (const auto &metric : metrics) std::fprintf(file, "%s %s %.6g\n", metric.preset.c_str(), metric.name.c_str(), metric.value);
+        return std::fclose(file) == 0;
+    }
+
+    bool loadMetrics(const char *fileName, std::vector<Metric> &metrics)
+    {
+        const auto file = std::fopen(fileName, "r");
+        if (!file) return false;
+
+        char line[256];
+        while (std::fgets(line, sizeof(line), file))
+        {
+            char preset[64], name[64];
+            double value = 0;
+            if (line[0] == '#' || std::sscanf(line, "%63s %63s %lf", preset, name, &value) != 3) continue;
+            metrics.push_back({preset, name, value, Metric::Time});
+        }
+
+        std::fclose(file);
+        return true;
+    }
+
+    /// Prints how every figure changed since the baseline. Returns the number of them over their threshold
+    int compare(const std::vector<Metric> &metrics, const std::vector<Metric> &baseline, double timeThreshold, double memoryThreshold)
+    {
+        std::printf("\n%-10s %-12s %12s %12s %9s\n", "preset", "figure", "baseline", "now", "change");
+
+        // A percentile that moved to the next bucket of the histogram is not a regression by itself
+        const auto latencyThreshold = std::max(timeThreshold, 100 * (std::pow(2.0, 1.0 / LatencyHistogram::BUCKETS_PER_OCTAVE) - 1));
+
+        auto regressions = 0;
+        auto changedGames = false;
+        for (const auto &metric : metrics)
+        {
+            const auto old = std::find_if(baseline.begin(), baseline.end(), [&metric](const Metric &other)
+            {
+                return other.preset == metric.preset && other.name == metric.name;
+            });
+            if (old == baseline.end())
+            {
+                std::printf("%-10s %-12s %12s %12.2f\n", metric.preset.c_str(), metric.name.c_str(), "-", metric.value);
+                continue;
+            }
+
+            const auto change = old->value > 0 ? 100 * (metric.value - old->value) / old->value : 0;
+            const char *verdict = "";
+            if (metric.kind == Metric::Count && metric.value != old->value)
+            {
+                verdict = "different games";
+                changedGames = true;
+            }
+            else if ((metric.kind == Metric::Time && change > timeThreshold) || (metric.kind == Metric::Latency && change > latencyThreshold)
+                     || (metric.kind == Metric::Memory && change > memoryThreshold))
+            {
+                verdict = "REGRESSION";
+                regressions++;
+            }
+
+            std::printf("%-10s %-12s %12.2f %12.2f %+8.1f%% %s\n", metric.preset.c_str(), metric.name.c_str(), old->value,
+                        metric.value, change, verdict);
+        }
+
+        if (changedGames) std::printf("\nThe games are not the ones of the baseline (the rules, the AI or the corpus changed), so the times may not be comparable\n");
+        return regressions;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *corpus = GAMEPLAY_CORPUS;
+    const char *baselinePath = nullptr;
+    const char *savePath = nullptr;
+    auto repeat = 3;
+    auto timeThreshold = 10.0;
+    auto memoryThreshold = 20.0;
+
+    for (auto i = 1; i + 1 < argc; i += 2)
+    {
+        if (!std::strcmp(argv[i], "--corpus")) corpus = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--repeat")) repeat = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--baseline")) baselinePath = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--save")) savePath = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--time-threshold")) timeThreshold = std::atof(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--memory-threshold")) memoryThreshold = std::atof(argv[i + 1]);
+    }
+
+    std::vector<Preset> presets;
+    if (repeat < 1 || timeThreshold < 0 || memoryThreshold < 0 || !readCorpus(corpus, presets))
+    {
+        std::fprintf(stderr, "Usage: %s [--corpus corpus.txt] [--repeat 3] [--save baseline.txt]\n"
+                             "       [--baseline baseline.txt --time-threshold 10 --memory-threshold 20]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Metric> baseline;
+    if (baselinePath && !loadMetrics(baselinePath, baseline))
+    {
+        std::fprintf(stderr, "Could not read %s\n", baselinePath);
+        return 1;
+    }
+
+    // The peak memory only grows, so it is reported after each preset but only compared once, at the end
+    std::printf("Fastest of %d runs; times per game in ms, per turn and per decision of the AI in us, peak memory in KB\n", repeat);
+    std::printf("%-10s %5s %9s %10s %9s %9s %9s %8s %9s %5s %10s\n",
+                "preset", "games", "generate", "game", "turn", "step p50", "step p99", "turns", "attacks", "won", "peak RSS");
+
+    const auto start = Clock::now();
+    std::vector<Metric> metrics;
+    for (const auto &preset : presets)
+    {
+        if (!runPreset(preset, repeat, metrics)) return 1;
+    }
+    metrics.push_back({"all", "total_ms", elapsedMs(start) / repeat, Metric::Time});
+    metrics.push_back({"all", "peak_rss_kb", peakResidentKB(), Metric::Memory});
+    std::printf("Total: %.1f s per run, peak RSS %.0f KB\n", metrics[metrics.size() - 2].value / 1000, metrics.back().value);
+
+    if (savePath && !saveMetrics(savePath, metrics))
+    {
+        std::fprintf(stderr, "Could not write %s\n", savePath);
+        return 1;
+    }
+
+    if (baselinePath)
+    {
+        const auto regressions = compare(metrics, baseline, timeThreshold, memoryThreshold);
+        if (regressions > 0)
+        {
+            std::printf("\n%d figures regressed by more than the thresholds (time %.0f%%, memory %.0f%%)\n",
+                        regressions, timeThreshold, memoryThreshold);
+            return 2;
+        }
+    }
+    return 0;
+}
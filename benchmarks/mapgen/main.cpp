@@ -0,0 +1,214 @@
+// Generates the same number of maps with every map generator on boards of several sizes, and reports what
+// each of them costs (time and peak memory per map) and what it gives (territories, how even their sizes
+// are, how many neighbours they have and whether they all form a single continent). Every generator is
+// deterministic, so the quality figures only change with the seed
+
+#include "mapgenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /// Bytes allocated with operator new and not released yet, and the most there have been since the last reset.
+    /// The benchmark runs on a single thread, so they need no synchronisation
+    std::size_t allocatedBytes = 0;
+    std::size_t peakBytes = 0;
+
+    /// Every allocation is prefixed with its size, keeping the alignment of malloc
+    constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+    struct Board
+    {
+        int width;
+        int height;
+    };
+
+    struct Totals
+    {
+        double milliseconds = 0;
+        std::size_t peakBytes = 0;
+        double territories = 0;
+        double meanSize = 0;
+        double sizeDeviation = 0;
+        double neighbours = 0;
+        double coverage = 0;
+        int split = 0;
+        int failed = 0;
+    };
+
+    /// Number of groups of territories that cannot reach each other
+    int countComponents(const MapTopology &map)
+    {
+        std::vector<bool> visited(map.territoryCount(), false);
+        std::vector<int> stack;
+        auto components = 0;
+        for (auto start = 0; start < map.territoryCount(); start++)
+        {
+            if (visited[start]) continue;
+            components++;
+            visited[start] = true;
+            stack.push_back(start);
+            while (!stack.empty())
+            {
+                const auto terr = stack.back();
+                stack.pop_back();
+                for (auto neighbour : map.neighbours(terr))
+                {
+                    if (visited[neighbour]) continue;
+                    visited[neighbour] = true;
+                    stack.push_back(neighbour);
+                }
+            }
+        }
+        return components;
+    }
+
+    void addMap(const MapTopology &map, Totals &totals)
+    {
+        const auto count = map.territoryCount();
+        if (count == 0) return;
+
+        auto cells = 0.0, squares = 0.0, neighbours = 0.0;
+        for (auto terr = 0; terr < count; terr++)
+        {
+            cells += map.cellCount(terr);
+            squares += static_cast<double>(map.cellCount(terr)) * map.cellCount(terr);
+            neighbours += map.neighbours(terr).size();
+        }
+
+        const auto mean = cells / count;
+        totals.territories += count;
+        totals.meanSize += mean;
+        totals.sizeDeviation += std::sqrt(std::max(0.0, squares / count - mean * mean));
+        totals.neighbours += neighbours / count;
+        totals.coverage += cells / (static_cast<double>(map.width()) * map.height());
+        if (countComponents(map) > 1) totals.split++;
+    }
+}
+
+void *operator new(std::size_t size)
+{
+    const auto block = static_cast<char *>(std::malloc(size + HEADER_SIZE));
+    if (!block) throw std::bad_alloc();
+
+    *reinterpret_cast<std::size_t *>(block) = size;
+    allocatedBytes += size;
+    peakBytes = std::max(peakBytes, allocatedBytes);
+    return block + HEADER_SIZE;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    if (!pointer) return;
+
+    const auto block = static_cast<char *>(pointer) - HEADER_SIZE;
+    allocatedBytes -= *reinterpret_cast<std::size_t *>(block);
+    std::free(block);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+int main(int argc, char *argv[])
+{
+    auto maps = 10;
+    std::uint64_t seed = 1;
+    std::vector<std::string> generators;
+    std::vector<Board> boards;
+
+    for (auto i = 1; i + 1 < argc; i += 2)
+    {
+        if (!std::strcmp(argv[i], "--maps")) maps = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--seed")) seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--generator")) generators.push_back(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--board"))
+        {
+            Board board;
+            if (std::sscanf(argv[i + 1], "%dx%d", &board.width, &board.height) != 2 || board.width <= 0 || board.height <= 0)
+            {
+                std::fprintf(stderr, "Invalid board: %s (expected WIDTHxHEIGHT)\n", argv[i + 1]);
+                return 1;
+            }
+            boards.push_back(board);
+        }
+    }
+
+    if (generators.empty()) generators = {"growth", "grid", "voronoi", "flood"};
+    if (boards.empty()) boards = {{30, 20}, {60, 40}, {120, 80}, {240, 160}};
+    if (maps <= 0)
+    {
+        std::fprintf(stderr, "Usage: %s [--maps N] [--seed S] [--generator NAME]... [--board WIDTHxHEIGHT]...\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%d maps per generator and board. Sizes are in cells, the deviation relative to the mean size\n", maps);
+    std::printf("%-10s %-16s %10s %10s %8s %6s %6s %7s %7s %6s\n",
+                "board", "generator", "ms/map", "peak KB", "terr", "size", "dev", "neighb", "cover", "split");
+
+    for (const auto &board : boards)
+    {
+        // The same density as the default board of the game: 80 territories of 25 cells on 60x40
+        MapSettings settings;
+        settings.width = board.width;
+        settings.height = board.height;
+        settings.numTerritories = std::max(1, board.width * board.height / 30);
+
+        for (const auto &spec : generators)
+        {
+            auto generator = createMapGenerator(spec);
+            if (!generator)
+            {
+                std::fprintf(stderr, "Unknown generator: %s\n", spec.c_str());
+                return 1;
+            }
+
+            Totals totals;
+            for (auto i = 0; i < maps; i++)
+            {
+                const auto before = allocatedBytes;
+                peakBytes = allocatedBytes;
+
+                const auto start = Clock::now();
+                auto map = generator->generate(settings, seed + static_cast<std::uint64_t>(i));
+                totals.milliseconds += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                totals.peakBytes = std::max(totals.peakBytes, peakBytes - before);
+
+                if (!map)
+                {
+                    totals.failed++;
+                    continue;
+                }
+                addMap(*map, totals);
+            }
+
+            const auto generated = maps - totals.failed;
+            char boardName[32];
+            std::snprintf(boardName, sizeof(boardName), "%dx%d", board.width, board.height);
+            if (generated == 0)
+            {
+                std::printf("%-10s %-16s could not generate any map\n", boardName, generator->name().c_str());
+                continue;
+            }
+
+            std::printf("%-10s %-16s %10.3f %10.1f %8.1f %6.1f %6.2f %7.2f %6.1f%% %6d\n", boardName, generator->name().c_str(),
+                        totals.milliseconds / maps, totals.peakBytes / 1024.0, totals.territories / generated,
+                        totals.meanSize / generated, totals.sizeDeviation / totals.meanSize, totals.neighbours / generated,
+                        100 * totals.coverage / generated, totals.split);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Compares the turn search applying and reverting moves in place (make/unmake) against cloning the
+// whole state for every child position, on the same set of positions. Then measures the cost of
+// evaluating a leaf with each evaluation and each kernel of ModelEvaluator
+
+#include "evaluationcache.h"
+#include "gamestate.h"
+#include "mapgenerator.h"
+#include "modelevaluation.h"
+#include "turnsearch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    auto depth = 3;
+    auto positions = 20;
+    std::uint64_t seed = 1;
+
+    for (auto i = 1; i + 1 < argc; i += 2)
+    {
+        if (!std::strcmp(argv[i], "--depth")) depth = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--positions")) positions = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--seed")) seed = std::strtoull(argv[i + 1], nullptr, 10);
+    }
+
+    const auto map = generateGrowthMap(MapSettings(), seed);
+    if (!map)
+    {
+        std::fprintf(stderr, "Could not generate the map\n");
+        return 1;
+    }
+
+    std::printf("Map: %d territories, %zu bytes per state\n", map->territoryCount(), GameState::byteSize(*map));
+
+    // The positions are taken every few turns of a game where everyone just ends their turn, so that
+    // territories accumulate dice and the number of possible attacks grows
+    StateArena positionArena(map, static_cast<std::size_t>(positions) + 1);
+    auto state = positionArena.allocate();
+    state.setup(8, seed);
+    std::vector<GameState> samples;
+    for (auto i = 0; i < positions; i++)
+    {
+        for (auto turn = 0; turn < 3; turn++)
+        {
+            TurnUndo undo;
+            state.makeEndTurn(undo);
+        }
+        samples.push_back(positionArena.clone(state));
+    }
+
+    TurnSearch inPlace(map, depth, TurnSearch::Mode::MakeUnmake);
+    TurnSearch copies(map, depth, TurnSearch::Mode::Copy);
+
+    double timeInPlace = 0, timeCopies = 0;
+    std::int64_t nodes = 0;
+    for (const auto &sample : samples)
+    {
+        auto start = Clock::now();
+        const auto a = inPlace.search(sample);
+        timeInPlace += elapsedMs(start);
+
+        start = Clock::now();
+        const auto b = copies.search(sample);
+        timeCopies += elapsedMs(start);
+
+        if (a.from != b.from || a.to != b.to || a.nodes != b.nodes)
+        {
+            std::fprintf(stderr, "Both searches should find the same result\n");
+            return 1;
+        }
+        nodes += a.nodes;
+    }
+
+    std::printf("Depth %d, %d positions, %lld nodes\n", depth, positions, static_cast<long long>(nodes));
+    std::printf("make/unmake: %10.2f ms %10.0f nodes/s\n", timeInPlace, nodes / timeInPlace * 1000);
+    std::printf("copy:        %10.2f ms %10.0f nodes/s\n", timeCopies, nodes / timeCopies * 1000);
+
+    // The cache is kept for all the positions, the same way an AI player keeps it between turns. Each
+    // position is searched twice, as an AI does when it searches again after each of its attacks
+    EvaluationCache cache(1 << 20);
+    inPlace.setCache(&cache);
+    double timeCached = 0;
+    std::int64_t nodesCached = 0;
+    for (const auto &sample : samples)
+    {
+        for (auto repeat = 0; repeat < 2; repeat++)
+        {
+            const auto start = Clock::now();
+            nodesCached += inPlace.search(sample).nodes;
+            timeCached += elapsedMs(start);
+        }
+    }
+    const auto lookups = cache.hits() + cache.misses();
+    std::printf("cached (x2): %10.2f ms %10lld nodes, %.1f%% cache hits\n", timeCached,
+                static_cast<long long>(nodesCached), lookups ? 100.0 * cache.hits() / lookups : 0.0);
+
+    // Every position is evaluated many times, so the timings are not dominated by the clock
+    constexpr int EVALUATION_REPEATS = 2000;
+    const auto evaluations = static_cast<double>(samples.size()) * EVALUATION_REPEATS;
+
+    auto start = Clock::now();
+    auto checksum = 0.0;
+    for (auto repeat = 0; repeat < EVALUATION_REPEATS; repeat++)
+    {
+        for (const auto &sample : samples) checksum += heuristicEvaluation(sample, 0);
+    }
+    std::printf("heuristic:   %10.1f ns/position (%g)\n", elapsedMs(start) * 1e6 / evaluations, checksum);
+
+    const char *KERNEL_NAMES[] = {"scalar", "sse", "avx2"};
+    ModelEvaluator evaluator;
+    std::vector<float> reference(samples.size()), values(samples.size());
+    evaluator.setKernel(ModelEvaluator::Kernel::Scalar);
+    evaluator.evaluate(samples.data(), positions, 0, reference.data());
+    for (auto kernel : {ModelEvaluator::Kernel::Scalar, ModelEvaluator::Kernel::Sse, ModelEvaluator::Kernel::Avx2})
+    {
+        if (!evaluator.setKernel(kernel)) continue;
+
+        // All the positions go in one batch, as the candidates of a search would
+        start = Clock::now();
+        for (auto repeat = 0; repeat < EVALUATION_REPEATS; repeat++) evaluator.evaluate(samples.data(), positions, 0, values.data());
+        const auto time = elapsedMs(start);
+
+        auto error = 0.0f;
+        for (auto i = 0; i < positions; i++) error = std::max(error, std::fabs(values[i] - reference[i]));
+        std::printf("model %-6s %10.1f ns/position (max difference %g)\n", KERNEL_NAMES[static_cast<int>(kernel)],
+                    time * 1e6 / evaluations, error);
+    }
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include "attackcandidates.h"
+
+#include <algorithm>
+
+AttackCandidates::AttackCandidates(std::shared_ptr<const MapTopology> map)
+    : map_(std::move(map))
+{
+    const auto count = map_->territoryCount();
+    offsets_.resize(count + 1);
+    offsets_[0] = 0;
+    for (auto terr = 0; terr < count; terr++)
+    {
+        for (auto neighbour : map_->neighbours(terr)) slots_.push_back({static_cast<std::uint16_t>(terr), neighbour});
+        offsets_[terr + 1] = static_cast<int>(slots_.size());
+    }
+
+    // The neighbours of every territory are sorted, so the reverse slot is found with a binary search
+    reverse_.resize(slots_.size());
+    for (std::size_t slot = 0; slot < slots_.size(); slot++)
+    {
+        const auto to = slots_[slot].to;
+        const auto neighbours = map_->neighbours(to);
+        const auto found = std::lower_bound(neighbours.begin(), neighbours.end(), slots_[slot].from);
+        reverse_[slot] = offsets_[to] + static_cast<int>(found - neighbours.begin());
+    }
+
+    listed_.assign(slots_.size(), -1);
+    positions_.assign(slots_.size(), 0);
+}
+
+void AttackCandidates::reset(const GameState &state)
+{
+    for (auto player = 0; player < GameState::MAX_PLAYERS; player++)
+    {
+        lists_[player].clear();
+        listSlots_[player].clear();
+    }
+    std::fill(listed_.begin(), listed_.end(), -1);
+
+    for (auto slot = 0; slot < static_cast<int>(slots_.size()); slot++) refresh(state, slot);
+}
+
+void AttackCandidates::update(const GameState &state, int territory)
+{
+    for (auto slot = offsets_[territory]; slot < offsets_[territory + 1]; slot++)
+    {
+        refresh(state, slot);
+        refresh(state, reverse_[slot]);
+    }
+}
+
+void AttackCandidates::update(const GameState &state, const AttackUndo &undo)
+{
+    update(state, undo.from);
+    update(state, undo.to);
+}
+
+void AttackCandidates::update(const GameState &state, const TurnUndo &undo)
+{
+    // Territories receiving several dice are checked again for each of them, which is cheaper than sorting
+    for (auto i = 0; i < undo.placedCount; i++) update(state, undo.placed[i]);
+}
+
+AttackCandidates::Attacks AttackCandidates::attacks(int player) const
+{
+    const auto &list = lists_[player];
+    return Attacks(list.data(), list.data() + list.size());
+}
+
+bool AttackCandidates::matches(const GameState &state) const
+{
+    for (std::size_t slot = 0; slot < slots_.size(); slot++)
+    {
+        const auto attacker = state.owner(slots_[slot].from);
+        const auto legal = state.numDice(slots_[slot].from) >= 2 && attacker != GameState::NO_OWNER
+                && state.owner(slots_[slot].to) != GameState::NO_OWNER && state.owner(slots_[slot].to) != attacker;
+        if (listed_[slot] != (legal ? attacker : -1)) return false;
+    }
+    return true;
+}
+
+void AttackCandidates::refresh(const GameState &state, int slot)
+{
+    const auto &attack = slots_[slot];
+    const auto attacker = state.owner(attack.from);
+    const auto defender = state.owner(attack.to);
+    const auto player = attacker != GameState::NO_OWNER && defender != GameState::NO_OWNER && attacker != defender
+            && state.numDice(attack.from) >= 2 ? attacker : -1;
+
+    const auto previous = listed_[slot];
+    if (previous == player) return;
+
+    if (previous >= 0)
+    {
+        // The last attack of the list takes the place of the removed one
+        auto &list = lists_[previous];
+        auto &listSlots = listSlots_[previous];
+        const auto position = positions_[slot];
+        list[position] = list.back();
+        listSlots[position] = listSlots.back();
+        positions_[listSlots[position]] = position;
+        list.pop_back();
+        listSlots.pop_back();
+    }
+
+    listed_[slot] = static_cast<std::int8_t>(player);
+    if (player >= 0)
+    {
+        positions_[slot] = static_cast<int>(lists_[player].size());
+        lists_[player].push_back(attack);
+        listSlots_[player].push_back(slot);
+    }
+}
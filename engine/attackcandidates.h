@@ -0,0 +1,87 @@
+#ifndef ATTACKCANDIDATES_H
+#define ATTACKCANDIDATES_H
+
+#include "gamestate.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// The legal attacks of every player (from a territory of theirs with at least 2 dice to an adjacent enemy
+/// territory), kept up to date as the game goes on instead of being searched for on every move. Whoever plays
+/// the game calls update() for the territories whose owner or dice change, which only looks at the attacks
+/// from and to those territories, and the policies read the attacks of the current player in O(attacks).
+///
+/// Every pair of adjacent territories has a slot, and every player a list of the slots that are legal attacks
+/// for them. Removing an attack moves the last one of the list to its place, so the order of the lists depends
+/// on the moves played, but always in the same way for the same game
+class AttackCandidates
+{
+public:
+    struct Attack
+    {
+        std::uint16_t from;
+        std::uint16_t to;
+    };
+
+    /// Simple view over the attacks of a player, so that they can be iterated with a range for loop
+    class Attacks
+    {
+        const Attack *begin_;
+        const Attack *end_;
+
+    public:
+        Attacks(const Attack *begin, const Attack *end) : begin_(begin), end_(end) {}
+
+        const Attack *begin() const { return begin_; }
+        const Attack *end() const { return end_; }
+        int size() const { return static_cast<int>(end_ - begin_); }
+        bool empty() const { return begin_ == end_; }
+        const Attack &operator[](int index) const { return begin_[index]; }
+    };
+
+    explicit AttackCandidates(std::shared_ptr<const MapTopology> map);
+
+    /// Finds the attacks of every player from scratch, e.g. at the start of a game
+    void reset(const GameState &state);
+
+    /// Checks again the attacks from and to the territory, after its owner or its dice changed
+    void update(const GameState &state, int territory);
+
+    /// Same as above for both territories of an attack that has just been made
+    void update(const GameState &state, const AttackUndo &undo);
+
+    /// Same as above for the territories that received dice at the end of a turn
+    void update(const GameState &state, const TurnUndo &undo);
+
+    /// The legal attacks of the player, in no particular order
+    Attacks attacks(int player) const;
+
+    /// Whether the candidates are the ones of the given state, computing them from scratch. Only meant for
+    /// tests and debugging
+    bool matches(const GameState &state) const;
+
+private:
+    std::shared_ptr<const MapTopology> map_;
+
+    /// One slot per pair of adjacent territories and direction. The ones from territory i go from
+    /// offsets_[i] to offsets_[i + 1], in the order of MapTopology::neighbours
+    std::vector<int> offsets_;
+    std::vector<Attack> slots_;
+
+    /// The slot of the same pair in the opposite direction
+    std::vector<int> reverse_;
+
+    /// The player whose list holds each slot (or -1), and its position there
+    std::vector<std::int8_t> listed_;
+    std::vector<int> positions_;
+
+    /// The attacks of each player, and the slot of each of them
+    std::vector<Attack> lists_[GameState::MAX_PLAYERS];
+    std::vector<int> listSlots_[GameState::MAX_PLAYERS];
+
+    /// Adds or removes the slot from the lists according to the state
+    void refresh(const GameState &state, int slot);
+};
+
+#endif // ATTACKCANDIDATES_H
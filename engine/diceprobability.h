@@ -0,0 +1,81 @@
+#ifndef DICEPROBABILITY_H
+#define DICEPROBABILITY_H
+
+#include "rules.h"
+
+/// Exact probabilities of the dice rolls of an attack, calculated from the distribution of the sum of
+/// several dice. The attacker only wins if their score is strictly greater. The tables are built at
+/// compile time for the given rules, so looking a probability up is a single load
+template <int MaxDice, int DiceSides>
+class BasicDiceProbability
+{
+public:
+    /// Largest number of dice a territory can roll
+    static constexpr int MAX_DICE = MaxDice;
+
+    /// Largest score that can be rolled
+    static constexpr int MAX_SCORE = MaxDice * DiceSides;
+
+    /// Probability that the attacker wins with the given numbers of dice (between 1 and MAX_DICE)
+    static constexpr double attackWins(int attackDice, int defenseDice)
+    {
+        if (attackDice < 1 || defenseDice < 1 || attackDice > MAX_DICE || defenseDice > MAX_DICE) return 0;
+        return TABLES.wins[attackDice][defenseDice];
+    }
+
+    /// Probability of rolling exactly the given score with the given number of dice
+    static constexpr double score(int numDice, int score)
+    {
+        if (numDice < 0 || numDice > MAX_DICE || score < 0 || score > MAX_SCORE) return 0;
+        return TABLES.scores[numDice][score];
+    }
+
+private:
+    struct Tables
+    {
+        /// scores[n][s] is the probability of rolling a total of s with n dice
+        double scores[MAX_DICE + 1][MAX_SCORE + 1] = {};
+
+        /// wins[a][d] is the probability of a attacking dice beating d defending dice
+        double wins[MAX_DICE + 1][MAX_DICE + 1] = {};
+
+        constexpr Tables()
+        {
+            // Each extra die convolves the previous distribution with a uniform one
+            scores[0][0] = 1;
+            for (auto n = 1; n <= MAX_DICE; n++)
+            {
+                for (auto s = n; s <= n * DiceSides; s++)
+                {
+                    for (auto face = 1; face <= DiceSides && face <= s; face++) scores[n][s] += scores[n - 1][s - face] / DiceSides;
+                }
+            }
+
+            for (auto a = 1; a <= MAX_DICE; a++)
+            {
+                for (auto d = 1; d <= MAX_DICE; d++)
+                {
+                    // Accumulating the probability of the defender scoring less than each attacking score
+                    auto below = 0.0;
+                    for (auto s = 1; s <= a * DiceSides; s++)
+                    {
+                        below += scores[d][s - 1];
+                        wins[a][d] += scores[a][s] * below;
+                    }
+                }
+            }
+        }
+    };
+
+    static constexpr Tables TABLES{};
+};
+
+/// The probabilities for the dice of the standard rules
+using DiceProbability = BasicDiceProbability<StandardRules::MAX_DICE, StandardRules::DICE_SIDES>;
+
+/// The probabilities for every roll the given rules allow, including the extra dice of the cheat mode.
+/// Under StandardRules this is DiceProbability itself
+template <typename R>
+using RulesDiceProbability = BasicDiceProbability<R::MAX_ROLL, R::DICE_SIDES>;
+
+#endif // DICEPROBABILITY_H
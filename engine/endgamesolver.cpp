@@ -0,0 +1,152 @@
+#include "endgamesolver.h"
+
+#include "diceprobability.h"
+
+#include <algorithm>
+
+namespace
+{
+    /// The clock is only read every this many nodes
+    constexpr std::int64_t CLOCK_INTERVAL = 1024;
+
+    /// Once this close to a certain win, no other attack can be better
+    constexpr double CERTAIN = 1 - 1e-9;
+
+}
+
+template <typename R>
+BasicEndgameSolver<R>::BasicEndgameSolver(std::shared_ptr<const MapTopology> map)
+    : BasicEndgameSolver(std::move(map), Limits())
+{
+}
+
+template <typename R>
+BasicEndgameSolver<R>::BasicEndgameSolver(std::shared_ptr<const MapTopology> map, const Limits &limits)
+    : arena_(std::move(map), 1), limits_(limits)
+{
+}
+
+template <typename R>
+const typename BasicEndgameSolver<R>::Limits &BasicEndgameSolver<R>::limits() const
+{
+    return limits_;
+}
+
+template <typename R>
+bool BasicEndgameSolver<R>::applies(const BasicGameState<R> &state) const
+{
+    if (state.playersLeft() != 2) return false;
+
+    for (auto player = 0; player < state.playerCount(); player++)
+    {
+        if (player != state.playerTurn() && state.ownedTerritories(player) > 0) return state.ownedTerritories(player) <= limits_.maxTerritories;
+    }
+    return false;
+}
+
+template <typename R>
+typename BasicEndgameSolver<R>::Result BasicEndgameSolver<R>::solve(const BasicGameState<R> &state)
+{
+    Result result;
+    if (!applies(state)) return result;
+
+    const auto player = state.playerTurn();
+    auto opponent = 0;
+    while (opponent == player || state.ownedTerritories(opponent) == 0) opponent++;
+
+    if (memo_.size() > MAX_MEMO_SIZE) memo_.clear();
+    nodes_ = 0;
+    aborted_ = false;
+    deadline_ = Clock::now() + std::chrono::milliseconds(limits_.maxMilliseconds);
+
+    arena_.clear();
+    attacks_.clear();
+    auto root = arena_.clone(state);
+    const auto value = search(root, player, opponent, &result);
+
+    result.nodes = nodes_;
+    if (aborted_)
+    {
+        result.from = result.to = -1;
+        return result;
+    }
+    result.solved = true;
+    result.winProbability = value;
+    return result;
+}
+
+template <typename R>
+double BasicEndgameSolver<R>::search(BasicGameState<R> &state, int player, int opponent, Result *result)
+{
+    if (state.ownedTerritories(opponent) == 0) return 1;
+
+    const auto found = memo_.find(state.hash());
+    if (found != memo_.end())
+    {
+        if (result)
+        {
+            result->from = found->second.from;
+            result->to = found->second.to;
+        }
+        return found->second.value;
+    }
+
+    nodes_++;
+    if (nodes_ > limits_.maxNodes || (limits_.maxMilliseconds > 0 && nodes_ % CLOCK_INTERVAL == 0 && Clock::now() > deadline_)) aborted_ = true;
+    if (aborted_) return 0;
+
+    // Every attack against the opponent, the most likely to succeed first, so a certain win is found early.
+    // They are pushed on top of the ones of the parents, so the buffer is only allocated once
+    const auto first = attacks_.size();
+    const auto owners = state.ownerData();
+    const auto dice = state.diceData();
+    for (auto to = 0; to < state.territoryCount(); to++)
+    {
+        if (owners[to] != opponent) continue;
+        for (auto from : state.map().neighbours(to))
+        {
+            if (owners[from] != player || dice[from] < 2) continue;
+            attacks_.push_back({from, to, RulesDiceProbability<R>::attackWins(state.rollCount(from), state.rollCount(to))});
+        }
+    }
+    const auto last = attacks_.size();
+    std::stable_sort(attacks_.begin() + first, attacks_.end(), [](const Attack &a, const Attack &b) { return a.probability > b.probability; });
+
+    // Ending the turn is always an option, and it never eliminates the opponent
+    auto best = 0.0;
+    auto bestFrom = -1, bestTo = -1;
+    for (auto i = first; i < last && best < CERTAIN; i++)
+    {
+        const auto attack = attacks_[i];
+        AttackUndo undo;
+        state.makeAttackOutcome(attack.from, attack.to, true, undo);
+        const auto won = search(state, player, opponent, nullptr);
+        state.unmakeAttack(undo);
+
+        state.makeAttackOutcome(attack.from, attack.to, false, undo);
+        const auto lost = search(state, player, opponent, nullptr);
+        state.unmakeAttack(undo);
+        if (aborted_) break;
+
+        const auto value = attack.probability * won + (1 - attack.probability) * lost;
+        if (value > best)
+        {
+            best = value;
+            bestFrom = attack.from;
+            bestTo = attack.to;
+        }
+    }
+    attacks_.resize(first);
+    if (aborted_) return 0;
+
+    memo_[state.hash()] = {static_cast<float>(best), static_cast<std::int16_t>(bestFrom), static_cast<std::int16_t>(bestTo)};
+    if (result)
+    {
+        result->from = bestFrom;
+        result->to = bestTo;
+    }
+    return best;
+}
+
+template class BasicEndgameSolver<StandardRules>;
+template class BasicEndgameSolver<CheatRules>;
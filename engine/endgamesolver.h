@@ -0,0 +1,104 @@
+#ifndef ENDGAMESOLVER_H
+#define ENDGAMESOLVER_H
+
+#include "gamestate.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/// Exact expectimax over the attacks left in the turn when only two players remain and the opponent is down
+/// to a few territories. It finds the attacks that maximise the probability of eliminating the opponent
+/// before the turn ends, weighting both outcomes of every attack with the exact dice probabilities. What
+/// happens on later turns is not modelled, so the probability is a lower bound of the chances of winning.
+///
+/// Positions are memoised on GameState::hash for the whole game: the next attacks of the same turn, and
+/// sibling branches reaching the same position, are only solved once. Like the states it solves, it is
+/// templated on the rules, which decide how many dice each territory rolls
+template <typename R>
+class BasicEndgameSolver
+{
+public:
+    struct Limits
+    {
+        /// The solver only takes positions where the opponent owns at most this many territories
+        int maxTerritories = 8;
+
+        /// Positions visited before giving up
+        std::int64_t maxNodes = 200000;
+
+        /// Time before giving up, or 0 for no limit. Only the node limit gives the same decisions on
+        /// every machine, which a network game needs
+        int maxMilliseconds = 50;
+    };
+
+    struct Result
+    {
+        /// Whether the search finished within the limits. Otherwise, nothing else is set
+        bool solved = false;
+
+        /// Probability of eliminating the opponent before the turn ends, playing the best attacks
+        double winProbability = 0;
+
+        /// The attack to perform now, or -1 if no attack can eliminate the opponent
+        int from = -1;
+        int to = -1;
+
+        /// Positions visited, not counting the ones taken from the memo
+        std::int64_t nodes = 0;
+    };
+
+    explicit BasicEndgameSolver(std::shared_ptr<const MapTopology> map);
+    BasicEndgameSolver(std::shared_ptr<const MapTopology> map, const Limits &limits);
+
+    const Limits &limits() const;
+
+    /// Whether the position is small enough for the solver
+    bool applies(const BasicGameState<R> &state) const;
+
+    /// Solves the position for the player whose turn it is. The state is left untouched
+    Result solve(const BasicGameState<R> &state);
+
+    /// The memo is dropped once it holds this many positions
+    static constexpr std::size_t MAX_MEMO_SIZE = 1 << 20;
+
+private:
+    struct Entry
+    {
+        float value;
+        std::int16_t from;
+        std::int16_t to;
+    };
+
+    struct Attack
+    {
+        int from;
+        int to;
+        double probability;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double search(BasicGameState<R> &state, int player, int opponent, Result *result);
+
+    BasicStateArena<R> arena_;
+    Limits limits_;
+    std::unordered_map<std::uint64_t, Entry> memo_;
+
+    /// The attacks of every position on the current line, the ones of the deepest last
+    std::vector<Attack> attacks_;
+
+    std::int64_t nodes_ = 0;
+    Clock::time_point deadline_;
+    bool aborted_ = false;
+};
+
+using EndgameSolver = BasicEndgameSolver<StandardRules>;
+
+// Both are instantiated once in endgamesolver.cpp
+extern template class BasicEndgameSolver<StandardRules>;
+extern template class BasicEndgameSolver<CheatRules>;
+
+#endif // ENDGAMESOLVER_H
@@ -0,0 +1,56 @@
+# Headless game engine shared by the game and the tools. It does not depend on Qt, so it can be
+# used from any thread and in processes without a QGuiApplication
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+CONFIG += c++17 thread
+
+# The maps are generated with floating point math, and must come out the same on every machine for network games.
+# Fusing a multiplication and an addition rounds differently, so the compiler is not allowed to do it on its own
+gcc|clang: QMAKE_CXXFLAGS += -ffp-contract=off
+
+HEADERS += \
+    $$PWD/random.h \
+    $$PWD/rules.h \
+    $$PWD/hexcoord.h \
+    $$PWD/maptopology.h \
+    $$PWD/mapgenerator.h \
+    $$PWD/maplibrary.h \
+    $$PWD/gamestate.h \
+    $$PWD/attackcandidates.h \
+    $$PWD/diceprobability.h \
+    $$PWD/evaluation.h \
+    $$PWD/modelevaluation.h \
+    $$PWD/evaluationcache.h \
+    $$PWD/turnsearch.h \
+    $$PWD/endgamesolver.h \
+    $$PWD/policy.h \
+    $$PWD/match.h \
+    $$PWD/gametelemetry.h \
+    $$PWD/positionwriter.h \
+    $$PWD/latencyhistogram.h \
+    $$PWD/workstealingpool.h \
+    $$PWD/spscqueue.h \
+    $$PWD/timeline.h \
+    $$PWD/gamehost.h
+
+SOURCES += \
+    $$PWD/maptopology.cpp \
+    $$PWD/mapgenerator.cpp \
+    $$PWD/maplibrary.cpp \
+    $$PWD/gamestate.cpp \
+    $$PWD/attackcandidates.cpp \
+    $$PWD/evaluation.cpp \
+    $$PWD/modelevaluation.cpp \
+    $$PWD/evaluationcache.cpp \
+    $$PWD/turnsearch.cpp \
+    $$PWD/endgamesolver.cpp \
+    $$PWD/policy.cpp \
+    $$PWD/match.cpp \
+    $$PWD/gametelemetry.cpp \
+    $$PWD/positionwriter.cpp \
+    $$PWD/latencyhistogram.cpp \
+    $$PWD/workstealingpool.cpp \
+    $$PWD/timeline.cpp \
+    $$PWD/gamehost.cpp
@@ -0,0 +1,35 @@
+#include "evaluation.h"
+
+#include "gamestate.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr double CONNECTED_WEIGHT = 1.0;
+    constexpr double TERRITORY_WEIGHT = 0.4;
+    constexpr double DICE_WEIGHT = 0.1;
+}
+
+template <typename R>
+double heuristicEvaluation(const BasicGameState<R> &state, int player)
+{
+    double scores[R::MAX_PLAYERS] = {};
+    for (auto terr = 0; terr < state.territoryCount(); terr++)
+    {
+        const auto owner = state.owner(terr);
+        if (owner != BasicGameState<R>::NO_OWNER) scores[owner] += TERRITORY_WEIGHT + DICE_WEIGHT * state.numDice(terr);
+    }
+
+    auto best = 0.0;
+    for (auto other = 0; other < state.playerCount(); other++)
+    {
+        scores[other] += CONNECTED_WEIGHT * state.connectedTerritories(other);
+        if (other != player) best = std::max(best, scores[other]);
+    }
+
+    return scores[player] - best;
+}
+
+template double heuristicEvaluation(const GameState &state, int player);
+template double heuristicEvaluation(const CheatGameState &state, int player);
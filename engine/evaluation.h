@@ -0,0 +1,21 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include "rules.h"
+
+template <typename R>
+class BasicGameState;
+using GameState = BasicGameState<StandardRules>;
+
+/// Signature of the functions that estimate how good a position is for a player. Higher is better
+template <typename R>
+using BasicEvaluationFunction = double (*)(const BasicGameState<R> &state, int player);
+using EvaluationFunction = BasicEvaluationFunction<StandardRules>;
+
+/// Simple hand-tuned evaluation: connected territories (which determine the dice received each turn)
+/// matter most, followed by the number of territories and dice, all relative to the strongest opponent.
+/// It is instantiated for StandardRules and CheatRules
+template <typename R>
+double heuristicEvaluation(const BasicGameState<R> &state, int player);
+
+#endif // EVALUATION_H
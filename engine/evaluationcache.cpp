@@ -0,0 +1,60 @@
+#include "evaluationcache.h"
+
+EvaluationCache::EvaluationCache(std::size_t capacity)
+    : locks_(new std::mutex[LOCK_COUNT])
+{
+    std::size_t size = LOCK_COUNT;
+    while (size < capacity) size *= 2;
+
+    entries_.resize(size);
+    mask_ = size - 1;
+}
+
+bool EvaluationCache::lookup(std::uint64_t hash, int depth, Entry &entry) const
+{
+    const auto index = hash & mask_;
+    {
+        std::lock_guard<std::mutex> lock(locks_[index % LOCK_COUNT]);
+        entry = entries_[index];
+    }
+
+    // A zero hash is also how empty slots look like, which is fine: it only makes that position uncacheable
+    const auto found = entry.hash == hash && hash != 0 && entry.depth >= depth;
+    (found ? hits_ : misses_).fetch_add(1, std::memory_order_relaxed);
+    return found;
+}
+
+void EvaluationCache::store(const Entry &entry)
+{
+    const auto index = entry.hash & mask_;
+    std::lock_guard<std::mutex> lock(locks_[index % LOCK_COUNT]);
+
+    auto &slot = entries_[index];
+    if (slot.hash == entry.hash && slot.depth > entry.depth) return;
+    slot = entry;
+}
+
+void EvaluationCache::clear()
+{
+    for (std::size_t i = 0; i < LOCK_COUNT; i++) locks_[i].lock();
+    for (auto &entry : entries_) entry = Entry();
+    for (std::size_t i = 0; i < LOCK_COUNT; i++) locks_[i].unlock();
+
+    hits_ = 0;
+    misses_ = 0;
+}
+
+std::size_t EvaluationCache::capacity() const
+{
+    return entries_.size();
+}
+
+std::uint64_t EvaluationCache::hits() const
+{
+    return hits_;
+}
+
+std::uint64_t EvaluationCache::misses() const
+{
+    return misses_;
+}
@@ -0,0 +1,62 @@
+#ifndef EVALUATIONCACHE_H
+#define EVALUATIONCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// Fixed-size table of search results keyed by GameState::hash. It is meant to be kept by an AI player
+/// for the whole game, so positions repeated across sibling branches, consecutive AI steps and turns are
+/// only evaluated once. Several threads can use it at the same time
+class EvaluationCache
+{
+public:
+    struct Entry
+    {
+        std::uint64_t hash = 0;
+
+        /// Value of the position for the player whose turn it is
+        float value = 0;
+
+        /// Best attack found, or -1 if ending the turn was better
+        std::int16_t from = -1;
+        std::int16_t to = -1;
+
+        /// Remaining search depth when the value was calculated; 0 for a plain evaluation
+        std::uint8_t depth = 0;
+    };
+
+    /// The capacity is rounded up to a power of two
+    explicit EvaluationCache(std::size_t capacity);
+
+    /// Finds the entry of the given position. Returns false if it is not stored, or if it was searched with
+    /// less depth than the one requested
+    bool lookup(std::uint64_t hash, int depth, Entry &entry) const;
+
+    /// Stores an entry, replacing the one in its slot unless that one is for the same position and deeper
+    void store(const Entry &entry);
+
+    void clear();
+
+    std::size_t capacity() const;
+
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+
+private:
+    /// Each lock protects all the entries whose index has the same lowest bits
+    static constexpr std::size_t LOCK_COUNT = 64;
+
+    std::vector<Entry> entries_;
+    std::size_t mask_;
+
+    mutable std::unique_ptr<std::mutex[]> locks_;
+
+    mutable std::atomic<std::uint64_t> hits_{0};
+    mutable std::atomic<std::uint64_t> misses_{0};
+};
+
+#endif // EVALUATIONCACHE_H
@@ -0,0 +1,112 @@
+#include "gamehost.h"
+
+#include "policy.h"
+
+#include <chrono>
+
+class GameHost::Game final : public WorkStealingPool::Task
+{
+    GameHost *host_;
+    Match match_;
+    std::vector<std::unique_ptr<Policy>> policies_;
+    std::uint64_t seed_;
+    bool started_ = false;
+
+public:
+    Game(GameHost *host, std::shared_ptr<const MapTopology> map, std::vector<std::unique_ptr<Policy>> policies, std::uint64_t seed)
+        : host_(host), match_(std::move(map)), policies_(std::move(policies)), seed_(seed)
+    {
+    }
+
+    void run(int worker) override
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        if (!started_)
+        {
+            std::vector<Policy *> policies;
+            for (auto &policy : policies_) policies.push_back(policy.get());
+            match_.start(policies, seed_);
+            started_ = true;
+        }
+        const auto playing = match_.step();
+
+        auto &stats = host_->stats_[worker];
+        stats.latency.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                            std::chrono::steady_clock::now() - start).count()));
+        stats.steps++;
+
+        if (playing) host_->pool_.submit(this);
+    }
+
+    const MatchResult &result() const
+    {
+        return match_.result();
+    }
+};
+
+GameHost::GameHost(int threadCount)
+    : pool_(threadCount), stats_(pool_.threadCount())
+{
+}
+
+GameHost::~GameHost()
+{
+    pool_.wait();
+}
+
+int GameHost::addGame(std::shared_ptr<const MapTopology> map, const std::vector<std::string> &seats, std::uint64_t seed)
+{
+    if (!map || seats.size() < 2 || seats.size() > static_cast<std::size_t>(GameState::MAX_PLAYERS)) return -1;
+
+    std::vector<std::unique_ptr<Policy>> policies;
+    for (std::size_t seat = 0; seat < seats.size(); seat++)
+    {
+        policies.push_back(createPolicy(seats[seat], map, seed + seat));
+        if (!policies.back()) return -1;
+    }
+
+    games_.emplace_back(new Game(this, std::move(map), std::move(policies), seed));
+    return static_cast<int>(games_.size()) - 1;
+}
+
+GameHost::Metrics GameHost::run()
+{
+    for (auto &stats : stats_) stats = WorkerStats();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (; started_ < games_.size(); started_++) pool_.submit(games_[started_].get());
+
+    Metrics metrics;
+    std::uint64_t samples = 0, depthSum = 0;
+    while (pool_.pending() > 0)
+    {
+        const auto depth = pool_.queueDepth();
+        if (depth > metrics.maxQueueDepth) metrics.maxQueueDepth = depth;
+        depthSum += depth;
+        samples++;
+        std::this_thread::sleep_for(std::chrono::microseconds(SAMPLE_INTERVAL));
+    }
+    pool_.wait();
+
+    metrics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    metrics.games = games_.size();
+    metrics.meanQueueDepth = samples > 0 ? static_cast<double>(depthSum) / samples : 0;
+    metrics.steals = pool_.steals();
+    for (const auto &stats : stats_)
+    {
+        metrics.stepLatency.merge(stats.latency);
+        metrics.steps += stats.steps;
+    }
+    return metrics;
+}
+
+std::size_t GameHost::gameCount() const
+{
+    return games_.size();
+}
+
+const MatchResult &GameHost::result(int game) const
+{
+    return games_[game]->result();
+}
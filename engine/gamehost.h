@@ -0,0 +1,71 @@
+#ifndef GAMEHOST_H
+#define GAMEHOST_H
+
+#include "latencyhistogram.h"
+#include "match.h"
+#include "workstealingpool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Plays many independent games at the same time in one process. Every game is a task of a
+/// WorkStealingPool that plays a single turn and then reschedules itself, and owns everything it uses
+/// (state, policies, random generator), so the games only share the read-only maps
+class GameHost
+{
+public:
+    struct Metrics
+    {
+        std::size_t games = 0;
+
+        /// Turns played, i.e. tasks run
+        std::uint64_t steps = 0;
+
+        /// Time taken by each turn
+        LatencyHistogram stepLatency;
+
+        /// Tasks waiting in the queues of the pool, sampled while the games are running
+        std::size_t maxQueueDepth = 0;
+        double meanQueueDepth = 0;
+
+        std::size_t steals = 0;
+        double seconds = 0;
+    };
+
+    explicit GameHost(int threadCount);
+    ~GameHost();
+
+    /// Adds a game with one policy per seat (see createPolicy). Returns its index, or -1 if some policy is
+    /// not valid. Policies with large caches (e.g. search) take memory for every game, so hosting thousands
+    /// of them needs lighter ones
+    int addGame(std::shared_ptr<const MapTopology> map, const std::vector<std::string> &seats, std::uint64_t seed);
+
+    /// Plays all the games added since the last call until they finish
+    Metrics run();
+
+    std::size_t gameCount() const;
+    const MatchResult &result(int game) const;
+
+    /// Interval between samples of the queue depth, in microseconds
+    static constexpr int SAMPLE_INTERVAL = 1000;
+
+private:
+    class Game;
+
+    /// Counters of each worker, kept apart to avoid sharing cache lines between threads
+    struct alignas(64) WorkerStats
+    {
+        LatencyHistogram latency;
+        std::uint64_t steps = 0;
+    };
+
+    WorkStealingPool pool_;
+    std::vector<std::unique_ptr<Game>> games_;
+    std::vector<WorkerStats> stats_;
+    std::size_t started_ = 0;
+};
+
+#endif // GAMEHOST_H
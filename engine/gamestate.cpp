@@ -0,0 +1,590 @@
+#include "gamestate.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    /// The Zobrist keys are derived from their index instead of being stored in a table, so they take no
+    /// memory and are the same for every map and every process
+    constexpr std::uint64_t zobristKey(std::uint64_t index)
+    {
+        auto z = index * 0x9e3779b97f4a7c15ull + 0x632be59bd9b4e019ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    constexpr std::uint64_t ownerKey(int territory, int owner)
+    {
+        return zobristKey(static_cast<std::uint64_t>(territory) * 32 + static_cast<std::uint64_t>(owner + 1));
+    }
+
+    constexpr std::uint64_t diceKey(int territory, int dice)
+    {
+        return zobristKey(static_cast<std::uint64_t>(territory) * 32 + 16 + static_cast<std::uint64_t>(dice));
+    }
+
+    constexpr std::uint64_t turnKey(int player)
+    {
+        return zobristKey(static_cast<std::uint64_t>(MapTopology::MAX_TERRITORIES + 1) * 32 + static_cast<std::uint64_t>(player));
+    }
+}
+
+template <typename R>
+BasicGameState<R>::BasicGameState(const MapTopology *map, void *data)
+    : map_(map), data_(static_cast<std::uint8_t *>(data))
+{
+}
+
+template <typename R>
+bool BasicGameState<R>::isValid() const
+{
+    return map_ != nullptr && data_ != nullptr;
+}
+
+template <typename R>
+const MapTopology &BasicGameState<R>::map() const
+{
+    return *map_;
+}
+
+template <typename R>
+std::size_t BasicGameState<R>::byteSize(const MapTopology &map)
+{
+    const auto size = sizeof(Header) + static_cast<std::size_t>(map.territoryCount()) * 2;
+    return (size + 7) / 8 * 8;
+}
+
+template <typename R>
+std::size_t BasicGameState<R>::byteSize() const
+{
+    return byteSize(*map_);
+}
+
+template <typename R>
+const std::uint8_t *BasicGameState<R>::data() const
+{
+    return data_;
+}
+
+template <typename R>
+void BasicGameState<R>::copyFrom(const BasicGameState &other)
+{
+    std::memcpy(data_, other.data_, byteSize());
+}
+
+template <typename R>
+void BasicGameState<R>::setup(int playerCount, std::uint64_t seed)
+{
+    playerCount = std::max(1, std::min(playerCount, MAX_PLAYERS));
+
+    // Same assignment as HexGrid::createTerritories
+    std::vector<std::int8_t> owners(map_->territoryCount());
+    for (auto terr = 0; terr < map_->territoryCount(); terr++) owners[terr] = static_cast<std::int8_t>(terr % playerCount);
+
+    setup(playerCount, owners.data(), seed);
+}
+
+template <typename R>
+void BasicGameState<R>::setup(int playerCount, const std::int8_t *owners, std::uint64_t seed)
+{
+    playerCount = std::max(1, std::min(playerCount, MAX_PLAYERS));
+
+    std::memset(data_, 0, byteSize());
+    auto head = header();
+    head->random.setState(seed);
+    head->territoryCount = static_cast<std::uint16_t>(map_->territoryCount());
+    head->playerCount = static_cast<std::uint8_t>(playerCount);
+
+    for (auto terr = 0; terr < head->territoryCount; terr++)
+    {
+        const auto player = owners[terr] < playerCount ? owners[terr] : NO_OWNER;
+        this->owners()[terr] = static_cast<std::int8_t>(player);
+        dice()[terr] = 1;
+        if (player != NO_OWNER) head->ownedTerritories[player]++;
+    }
+
+    for (auto player = 0; player < playerCount; player++)
+    {
+        if (head->ownedTerritories[player] > 0) head->playersLeft++;
+        updateConnectedTerritories(player);
+    }
+
+    for (auto player = 0; player < playerCount; player++) addDice(player, head->territoryCount * 15 / 10 / playerCount);
+
+    auto turn = head->random.bounded(playerCount);
+    while (head->playersLeft > 0 && head->ownedTerritories[turn] == 0) turn = (turn + 1) % playerCount;
+    head->playerTurn = static_cast<std::uint8_t>(turn);
+
+    head->hash = computeHash();
+}
+
+template <typename R>
+int BasicGameState<R>::territoryCount() const
+{
+    return header()->territoryCount;
+}
+
+template <typename R>
+int BasicGameState<R>::playerCount() const
+{
+    return header()->playerCount;
+}
+
+template <typename R>
+int BasicGameState<R>::playerTurn() const
+{
+    return header()->playerTurn;
+}
+
+template <typename R>
+void BasicGameState<R>::setPlayerTurn(int player)
+{
+    auto head = header();
+    head->hash ^= turnKey(head->playerTurn) ^ turnKey(player);
+    head->playerTurn = static_cast<std::uint8_t>(player);
+}
+
+template <typename R>
+int BasicGameState<R>::playersLeft() const
+{
+    return header()->playersLeft;
+}
+
+template <typename R>
+int BasicGameState<R>::owner(int territory) const
+{
+    return owners()[territory];
+}
+
+template <typename R>
+void BasicGameState<R>::setOwner(int territory, int player)
+{
+    const auto previous = owners()[territory];
+    if (previous == player) return;
+
+    auto head = header();
+    owners()[territory] = static_cast<std::int8_t>(player);
+    head->hash ^= ownerKey(territory, previous) ^ ownerKey(territory, player);
+
+    if (previous != NO_OWNER)
+    {
+        if (--head->ownedTerritories[previous] == 0) head->playersLeft--;
+        updateConnectedTerritories(previous);
+    }
+
+    if (player != NO_OWNER)
+    {
+        if (head->ownedTerritories[player]++ == 0) head->playersLeft++;
+        updateConnectedTerritories(player);
+    }
+}
+
+template <typename R>
+int BasicGameState<R>::numDice(int territory) const
+{
+    return dice()[territory];
+}
+
+template <typename R>
+void BasicGameState<R>::setNumDice(int territory, int numDice)
+{
+    numDice = std::max(1, std::min(numDice, MAX_DICE));
+    header()->hash ^= diceKey(territory, dice()[territory]) ^ diceKey(territory, numDice);
+    dice()[territory] = static_cast<std::uint8_t>(numDice);
+}
+
+template <typename R>
+bool BasicGameState<R>::isHuman([[maybe_unused]] int player) const
+{
+    if constexpr (Rules::CHEAT_MODE)
+    {
+        return header()->humans >> player & 1;
+    }
+    return false;
+}
+
+template <typename R>
+void BasicGameState<R>::setHuman([[maybe_unused]] int player, [[maybe_unused]] bool human)
+{
+    if constexpr (Rules::CHEAT_MODE)
+    {
+        const auto bit = static_cast<std::uint8_t>(1 << player);
+        auto &humans = header()->humans;
+        humans = static_cast<std::uint8_t>(human ? humans | bit : humans & ~bit);
+    }
+}
+
+template <typename R>
+int BasicGameState<R>::rollCount(int territory) const
+{
+    if constexpr (Rules::CHEAT_MODE)
+    {
+        const auto owner = owners()[territory];
+        return Rules::rollCount(dice()[territory], owner != NO_OWNER && isHuman(owner));
+    }
+    return dice()[territory];
+}
+
+template <typename R>
+const std::int8_t *BasicGameState<R>::ownerData() const
+{
+    return owners();
+}
+
+template <typename R>
+const std::uint8_t *BasicGameState<R>::diceData() const
+{
+    return dice();
+}
+
+template <typename R>
+int BasicGameState<R>::remainingDice(int player) const
+{
+    return header()->remainingDice[player];
+}
+
+template <typename R>
+void BasicGameState<R>::setRemainingDice(int player, int remainingDice)
+{
+    header()->remainingDice[player] = static_cast<std::uint16_t>(remainingDice);
+}
+
+template <typename R>
+int BasicGameState<R>::ownedTerritories(int player) const
+{
+    return header()->ownedTerritories[player];
+}
+
+template <typename R>
+int BasicGameState<R>::connectedTerritories(int player) const
+{
+    return header()->connectedTerritories[player];
+}
+
+template <typename R>
+Random &BasicGameState<R>::random()
+{
+    return header()->random;
+}
+
+template <typename R>
+const Random &BasicGameState<R>::random() const
+{
+    return header()->random;
+}
+
+template <typename R>
+std::uint64_t BasicGameState<R>::hash() const
+{
+    return header()->hash;
+}
+
+template <typename R>
+std::uint64_t BasicGameState<R>::computeHash() const
+{
+    auto hash = turnKey(playerTurn());
+    for (auto terr = 0; terr < territoryCount(); terr++) hash ^= ownerKey(terr, owners()[terr]) ^ diceKey(terr, dice()[terr]);
+    return hash;
+}
+
+template <typename R>
+bool BasicGameState<R>::canAttack(int from, int to) const
+{
+    if (from < 0 || to < 0 || from >= territoryCount() || to >= territoryCount()) return false;
+
+    const auto attacker = owner(from);
+    if (attacker != playerTurn() || numDice(from) < 2) return false;
+
+    const auto defender = owner(to);
+    if (defender == NO_OWNER || defender == attacker) return false;
+
+    return map_->adjacent(from, to);
+}
+
+template <typename R>
+void BasicGameState<R>::addDice(int player, int numDice, bool distributeThem)
+{
+    auto &remaining = header()->remainingDice[player];
+    remaining = static_cast<std::uint16_t>(std::min(remaining + numDice, MAX_REMAINING_DICE));
+
+    if (distributeThem) distributeDice(player, remaining);
+}
+
+template <typename R>
+bool BasicGameState<R>::distributeDice(int player, int numDice, std::uint16_t *placed)
+{
+    auto head = header();
+    auto &remaining = head->remainingDice[player];
+    if (numDice > remaining) numDice = remaining;
+
+    const auto size = head->ownedTerritories[player];
+    if (size == 0) return numDice == 0;
+
+    const auto count = head->territoryCount;
+    const auto owner = owners();
+    auto dice = this->dice();
+
+    // For each remaining dice, a random territory of the player is chosen. If that territory has
+    // already 8 dice, the next one is tried instead. If all of them are full, the process stops
+    for (auto diceCount = 0; diceCount < numDice; diceCount++)
+    {
+        // Finding the randomly chosen territory, as the territories of a player are not stored separately
+        auto skip = head->random.bounded(size);
+        auto terr = 0;
+        for (; terr < count; terr++)
+        {
+            if (owner[terr] == player && skip-- == 0) break;
+        }
+
+        auto added = false;
+        for (auto offset = 0; offset < count; offset++, terr = terr + 1 == count ? 0 : terr + 1)
+        {
+            if (owner[terr] != player || dice[terr] >= MAX_DICE) continue;
+
+            head->hash ^= diceKey(terr, dice[terr]) ^ diceKey(terr, dice[terr] + 1);
+            dice[terr]++;
+            remaining--;
+            if (placed) placed[diceCount] = static_cast<std::uint16_t>(terr);
+            added = true;
+            break;
+        }
+        if (!added) return false;
+    }
+
+    return true;
+}
+
+template <typename R>
+void BasicGameState<R>::updateConnectedTerritories(int player)
+{
+    // Scratch memory sized for the largest map the rules allow, so that searches never allocate. It is
+    // zero-initialized thread-local storage, which costs nothing until a thread touches it
+    thread_local std::array<std::uint16_t, Rules::MAX_TERRITORIES> stack;
+    thread_local std::array<std::uint8_t, Rules::MAX_TERRITORIES> scanned;
+
+    const auto count = territoryCount();
+    std::fill_n(scanned.begin(), count, std::uint8_t(0));
+
+    const auto owner = owners();
+    auto result = 0;
+    for (auto terr = 0; terr < count; terr++)
+    {
+        if (owner[terr] != player || scanned[terr]) continue;
+
+        // Flood fill from this territory through the ones of the same player
+        auto size = 0;
+        // Every territory is pushed at most once, so the stack cannot hold more than the map
+        auto top = 0;
+        scanned[terr] = 1;
+        stack[top++] = static_cast<std::uint16_t>(terr);
+        while (top > 0)
+        {
+            const auto current = stack[--top];
+            size++;
+
+            for (auto neighbour : map_->neighbours(current))
+            {
+                if (owner[neighbour] != player || scanned[neighbour]) continue;
+                scanned[neighbour] = 1;
+                stack[top++] = neighbour;
+            }
+        }
+
+        result = std::max(result, size);
+    }
+
+    header()->connectedTerritories[player] = static_cast<std::uint16_t>(result);
+}
+
+template <typename R>
+bool BasicGameState<R>::makeAttack(int from, int to, AttackUndo &undo, int *attackScore, int *defenseScore)
+{
+    auto &random = header()->random;
+    const auto previous = random.state();
+
+    const auto attack = random.template roll<Rules::DICE_SIDES>(rollCount(from));
+    const auto defense = random.template roll<Rules::DICE_SIDES>(rollCount(to));
+    if (attackScore) *attackScore = attack;
+    if (defenseScore) *defenseScore = defense;
+
+    makeAttackOutcome(from, to, attack > defense, undo);
+    undo.random = previous;
+
+    return undo.captured;
+}
+
+template <typename R>
+void BasicGameState<R>::makeAttackOutcome(int from, int to, bool captured, AttackUndo &undo)
+{
+    auto head = header();
+    auto owner = owners();
+    auto dice = this->dice();
+
+    const auto attacker = owner[from];
+    const auto defender = owner[to];
+
+    undo.random = head->random.state();
+    undo.hash = head->hash;
+    undo.from = static_cast<std::uint16_t>(from);
+    undo.to = static_cast<std::uint16_t>(to);
+    undo.defender = defender;
+    undo.fromDice = dice[from];
+    undo.toDice = dice[to];
+    undo.playersLeft = head->playersLeft;
+    undo.attackerConnected = head->connectedTerritories[attacker];
+    undo.defenderConnected = head->connectedTerritories[defender];
+    undo.captured = captured;
+
+    if (captured)
+    {
+        setOwner(to, attacker);
+        setNumDice(to, dice[from] - 1);
+    }
+
+    setNumDice(from, 1);
+}
+
+template <typename R>
+void BasicGameState<R>::unmakeAttack(const AttackUndo &undo)
+{
+    auto head = header();
+    auto owner = owners();
+    auto dice = this->dice();
+
+    const auto attacker = owner[undo.from];
+
+    // The counters are restored directly instead of going through setOwner, which would recalculate
+    // the connected territories from scratch
+    if (undo.captured)
+    {
+        owner[undo.to] = undo.defender;
+        head->ownedTerritories[attacker]--;
+        head->ownedTerritories[undo.defender]++;
+    }
+
+    head->playersLeft = undo.playersLeft;
+    head->connectedTerritories[attacker] = undo.attackerConnected;
+    head->connectedTerritories[undo.defender] = undo.defenderConnected;
+
+    dice[undo.from] = undo.fromDice;
+    dice[undo.to] = undo.toDice;
+
+    head->random.setState(undo.random);
+    head->hash = undo.hash;
+}
+
+template <typename R>
+void BasicGameState<R>::makeEndTurn(TurnUndo &undo)
+{
+    auto head = header();
+    const auto player = head->playerTurn;
+
+    undo.random = head->random.state();
+    undo.hash = head->hash;
+    undo.player = player;
+    undo.remainingDice = head->remainingDice[player];
+
+    addDice(player, head->connectedTerritories[player], false);
+
+    // growPlayer distributes the dice one at a time until they run out or all the territories are full
+    const auto before = head->remainingDice[player];
+    distributeDice(player, before, undo.placed);
+    undo.placedCount = static_cast<std::uint16_t>(before - head->remainingDice[player]);
+
+    if (head->playersLeft == 0) return;
+
+    auto turn = static_cast<int>(player);
+    do
+    {
+        turn = (turn + 1) % head->playerCount;
+    } while (head->ownedTerritories[turn] == 0);
+    setPlayerTurn(turn);
+}
+
+template <typename R>
+void BasicGameState<R>::unmakeEndTurn(const TurnUndo &undo)
+{
+    auto head = header();
+    auto dice = this->dice();
+
+    for (auto i = 0; i < undo.placedCount; i++) dice[undo.placed[i]]--;
+
+    head->remainingDice[undo.player] = undo.remainingDice;
+    head->playerTurn = undo.player;
+    head->random.setState(undo.random);
+    head->hash = undo.hash;
+}
+
+template <typename R>
+BasicStateArena<R>::BasicStateArena(std::shared_ptr<const MapTopology> map, std::size_t capacity)
+    : map_(std::move(map)),
+      stateSize_(BasicGameState<R>::byteSize(*map_)),
+      capacity_(map_->territoryCount() <= R::MAX_TERRITORIES ? capacity : 0),
+      storage_(new std::uint64_t[stateSize_ / 8 * capacity_])
+{
+}
+
+template <typename R>
+const std::shared_ptr<const MapTopology> &BasicStateArena<R>::map() const
+{
+    return map_;
+}
+
+template <typename R>
+std::size_t BasicStateArena<R>::capacity() const
+{
+    return capacity_;
+}
+
+template <typename R>
+std::size_t BasicStateArena<R>::size() const
+{
+    return used_;
+}
+
+template <typename R>
+BasicGameState<R> BasicStateArena<R>::allocate()
+{
+    if (used_ == capacity_) return BasicGameState<R>();
+
+    const auto data = storage_.get() + stateSize_ / 8 * used_++;
+    std::memset(data, 0, stateSize_);
+    return BasicGameState<R>(map_.get(), data);
+}
+
+template <typename R>
+BasicGameState<R> BasicStateArena<R>::clone(const BasicGameState<R> &state)
+{
+    if (used_ == capacity_) return BasicGameState<R>();
+
+    const auto data = storage_.get() + stateSize_ / 8 * used_++;
+    std::memcpy(data, state.data_, stateSize_);
+    return BasicGameState<R>(map_.get(), data);
+}
+
+template <typename R>
+std::size_t BasicStateArena<R>::mark() const
+{
+    return used_;
+}
+
+template <typename R>
+void BasicStateArena<R>::rewind(std::size_t mark)
+{
+    if (mark < used_) used_ = mark;
+}
+
+template <typename R>
+void BasicStateArena<R>::clear()
+{
+    used_ = 0;
+}
+
+template class BasicGameState<StandardRules>;
+template class BasicGameState<CheatRules>;
+template class BasicStateArena<StandardRules>;
+template class BasicStateArena<CheatRules>;
@@ -0,0 +1,284 @@
+#ifndef GAMESTATE_H
+#define GAMESTATE_H
+
+#include "maptopology.h"
+#include "random.h"
+#include "rules.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/// Everything an attack changes, recorded by GameState::makeAttack so that GameState::unmakeAttack can
+/// restore the previous state exactly
+struct AttackUndo
+{
+    /// Position of the random generator before rolling the dice
+    std::uint64_t random = 0;
+
+    /// Hash of the state before the attack
+    std::uint64_t hash = 0;
+
+    std::uint16_t from = 0;
+    std::uint16_t to = 0;
+
+    /// Owner of the attacked territory before the attack
+    std::int8_t defender = 0;
+
+    std::uint8_t fromDice = 0;
+    std::uint8_t toDice = 0;
+    std::uint8_t playersLeft = 0;
+
+    /// Connected territories of both players before the attack
+    std::uint16_t attackerConnected = 0;
+    std::uint16_t defenderConnected = 0;
+
+    bool captured = false;
+};
+
+/// Everything the end of a turn changes, recorded by GameState::makeEndTurn so that
+/// GameState::unmakeEndTurn can restore the previous state exactly
+struct TurnUndo
+{
+    /// Position of the random generator before distributing the dice
+    std::uint64_t random = 0;
+
+    /// Hash of the state before the turn ended
+    std::uint64_t hash = 0;
+
+    std::uint8_t player = 0;
+    std::uint16_t remainingDice = 0;
+
+    /// The territory that received each of the dice, in order
+    std::uint16_t placedCount = 0;
+    std::uint16_t placed[StandardRules::MAX_REMAINING_DICE];
+};
+
+template <typename R>
+class BasicStateArena;
+
+/// This class gives access to everything that changes during a game: owner and dice of each territory,
+/// dice waiting to be placed, whose turn it is and the random generator. All of it is stored in a single
+/// block of memory using indices instead of pointers, so copying a state is one memcpy of a few hundred
+/// bytes. The block is owned by a StateArena; a GameState is only a lightweight handle to it.
+/// The class is templated on the Rules it is played with. GameState plays the StandardRules, for which the
+/// branches of the cheat mode are not compiled at all
+template <typename R>
+class BasicGameState
+{
+public:
+    /// The rules the state is laid out for. The fixed-size arrays of the header have room for their players,
+    /// and dice are rolled and placed following them
+    using Rules = R;
+    static_assert(Rules::MAX_TERRITORIES <= MapTopology::MAX_TERRITORIES, "Territories are indexed by the map");
+    static_assert(Rules::MAX_PLAYERS < 16 && Rules::MAX_DICE < 16, "The Zobrist keys leave room for 16 owners and 16 dice");
+    static_assert(!Rules::CHEAT_MODE || Rules::MAX_PLAYERS <= 8, "Human players are stored as a bitmask of one byte");
+    static_assert(Rules::MAX_REMAINING_DICE <= StandardRules::MAX_REMAINING_DICE, "TurnUndo records every die placed");
+
+    static constexpr int MAX_PLAYERS = Rules::MAX_PLAYERS;
+    static constexpr int MAX_DICE = Rules::MAX_DICE;
+    static constexpr int MAX_REMAINING_DICE = Rules::MAX_REMAINING_DICE;
+
+    /// Owner of the territories that do not belong to any player
+    static constexpr int NO_OWNER = -1;
+
+    BasicGameState() = default;
+    BasicGameState(const MapTopology *map, void *data);
+
+    /// A default constructed state, or one returned by a full StateArena, is not valid
+    bool isValid() const;
+
+    const MapTopology &map() const;
+
+    /// Size in bytes of the mutable part of a state played on the given map
+    static std::size_t byteSize(const MapTopology &map);
+    std::size_t byteSize() const;
+
+    /// The whole mutable state, byteSize() bytes long. Two states played on the same map are the same position
+    /// exactly when these bytes are equal
+    const std::uint8_t *data() const;
+
+    /// Overwrites this state with another one played on the same map
+    void copyFrom(const BasicGameState &other);
+
+    /// Starts a new game the same way HexGrid::initializeGrid does: territories are shared round-robin
+    /// between the players, each of them gets the same amount of initial dice randomly distributed across
+    /// their territories, and the first turn is chosen randomly
+    void setup(int playerCount, std::uint64_t seed);
+
+    /// Same as above, but with the owner of every territory given instead of sharing them round-robin.
+    /// Territories owned by NO_OWNER take no part in the game
+    void setup(int playerCount, const std::int8_t *owners, std::uint64_t seed);
+
+    int territoryCount() const;
+    int playerCount() const;
+
+    int playerTurn() const;
+    void setPlayerTurn(int player);
+
+    /// Number of players that still own some territory
+    int playersLeft() const;
+
+    /// Returns NO_OWNER for territories that do not belong to any player
+    int owner(int territory) const;
+
+    /// Changes the owner of the territory, updating the territory counts and connected territories of
+    /// both the previous and the new owner
+    void setOwner(int territory, int player);
+
+    int numDice(int territory) const;
+    void setNumDice(int territory, int numDice);
+
+    /// Whether the player is human, which only makes a difference in cheat mode. setup() makes every player
+    /// an AI, and setHuman() is ignored unless the rules enable the cheat mode
+    bool isHuman(int player) const;
+    void setHuman(int player, bool human);
+
+    /// Number of dice the territory rolls when it attacks or defends, see Rules::rollCount
+    int rollCount(int territory) const;
+
+    /// The owner and the dice of every territory, one after another, for code that scans all of them
+    const std::int8_t *ownerData() const;
+    const std::uint8_t *diceData() const;
+
+    int remainingDice(int player) const;
+    void setRemainingDice(int player, int remainingDice);
+
+    /// Number of territories owned by the player
+    int ownedTerritories(int player) const;
+
+    /// The maximum number of territories that are both owned by the player and contiguous. This is the
+    /// amount of dice the player receives at the end of their turn
+    int connectedTerritories(int player) const;
+
+    Random &random();
+    const Random &random() const;
+
+    /// Zobrist hash of the owner and dice of every territory and the player whose turn it is. It is kept
+    /// up to date in O(1) on every change, so it can be used to identify positions during a search
+    std::uint64_t hash() const;
+
+    /// Calculates the hash from scratch, which must always give the same value as hash()
+    std::uint64_t computeHash() const;
+
+    /// Whether the territory can attack the other one, following the same rules as HexGrid::processClick:
+    /// it must belong to the current player, have at least 2 dice and be adjacent to an enemy territory.
+    /// Indices outside the map are rejected too, so they can be taken from untrusted input
+    bool canAttack(int from, int to) const;
+
+    /// Adds the specified number of dice to the stack of the player, up to MAX_REMAINING_DICE
+    void addDice(int player, int numDice, bool distributeThem = true);
+
+    /// Distributes dice from the stack of the player randomly across their territories, skipping the full
+    /// ones. If all the dice could not be distributed, it will return false.
+    /// If placed is not null, the territory receiving each die is written there
+    bool distributeDice(int player, int numDice, std::uint16_t *placed = nullptr);
+
+    /// Recalculates the connected territories of the player from scratch
+    void updateConnectedTerritories(int player);
+
+    /// Resolves an attack like GameEngine does, rolling rollCount() dice for each territory with the random generator of the
+    /// state, and returns whether the territory was captured. The scores rolled are written to
+    /// attackScore and defenseScore if they are not null. The attack must be legal (see canAttack)
+    bool makeAttack(int from, int to, AttackUndo &undo, int *attackScore = nullptr, int *defenseScore = nullptr);
+
+    /// Same as makeAttack, but with the result decided by the caller instead of rolling the dice. This lets
+    /// a search explore both outcomes of an attack
+    void makeAttackOutcome(int from, int to, bool captured, AttackUndo &undo);
+
+    /// Restores the state as it was before the attack recorded in the undo entry
+    void unmakeAttack(const AttackUndo &undo);
+
+    /// Finishes the turn like GameEngine does at once: the player gets as many dice as
+    /// connected territories, they are distributed one by one, and the turn goes to the next player with
+    /// some territory left
+    void makeEndTurn(TurnUndo &undo);
+
+    /// Restores the state as it was before the turn end recorded in the undo entry
+    void unmakeEndTurn(const TurnUndo &undo);
+
+private:
+    /// The fixed-size part of the block, followed by the owner and the dice of each territory
+    struct Header
+    {
+        Random random;
+        std::uint64_t hash;
+        std::uint16_t territoryCount;
+        std::uint8_t playerCount;
+        std::uint8_t playerTurn;
+        std::uint8_t playersLeft;
+        std::uint8_t humans;
+        std::uint8_t reserved[2];
+        std::uint16_t remainingDice[MAX_PLAYERS];
+        std::uint16_t ownedTerritories[MAX_PLAYERS];
+        std::uint16_t connectedTerritories[MAX_PLAYERS];
+    };
+
+    Header *header() { return reinterpret_cast<Header *>(data_); }
+    const Header *header() const { return reinterpret_cast<const Header *>(data_); }
+
+    std::int8_t *owners() { return reinterpret_cast<std::int8_t *>(data_ + sizeof(Header)); }
+    const std::int8_t *owners() const { return reinterpret_cast<const std::int8_t *>(data_ + sizeof(Header)); }
+
+    std::uint8_t *dice() { return data_ + sizeof(Header) + header()->territoryCount; }
+    const std::uint8_t *dice() const { return data_ + sizeof(Header) + header()->territoryCount; }
+
+    const MapTopology *map_ = nullptr;
+    std::uint8_t *data_ = nullptr;
+
+    friend class BasicStateArena<R>;
+};
+
+using GameState = BasicGameState<StandardRules>;
+using CheatGameState = BasicGameState<CheatRules>;
+
+/// This class owns the memory of many GameState instances played on the same map, laid out one after
+/// another in a single allocation. It hands them out like a stack, so a search can take a mark, clone
+/// as many states as it needs and rewind to the mark without ever calling the memory allocator
+template <typename R>
+class BasicStateArena
+{
+    std::shared_ptr<const MapTopology> map_;
+
+    /// Size of each state, rounded up so that every state is 8-byte aligned
+    std::size_t stateSize_;
+
+    std::size_t capacity_;
+    std::size_t used_ = 0;
+
+    std::unique_ptr<std::uint64_t[]> storage_;
+
+public:
+    /// A map with more territories than the rules allow gives an arena with no capacity
+    BasicStateArena(std::shared_ptr<const MapTopology> map, std::size_t capacity);
+
+    const std::shared_ptr<const MapTopology> &map() const;
+
+    std::size_t capacity() const;
+    std::size_t size() const;
+
+    /// Returns a new zero-initialized state, or an invalid one if the arena is full
+    BasicGameState<R> allocate();
+
+    /// Returns a copy of the given state, or an invalid one if the arena is full
+    BasicGameState<R> clone(const BasicGameState<R> &state);
+
+    /// Current position of the stack, to be passed to rewind()
+    std::size_t mark() const;
+
+    /// Releases all the states allocated after the given mark
+    void rewind(std::size_t mark);
+
+    void clear();
+};
+
+using StateArena = BasicStateArena<StandardRules>;
+using CheatStateArena = BasicStateArena<CheatRules>;
+
+// Both are instantiated once in gamestate.cpp
+extern template class BasicGameState<StandardRules>;
+extern template class BasicGameState<CheatRules>;
+extern template class BasicStateArena<StandardRules>;
+extern template class BasicStateArena<CheatRules>;
+
+#endif // GAMESTATE_H
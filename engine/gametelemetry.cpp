@@ -0,0 +1,131 @@
+#include "gametelemetry.h"
+
+namespace
+{
+    void writeArray(std::FILE *file, const std::uint64_t *values, int count)
+    {
+        std::fprintf(file, "[");
+        for (auto i = 0; i < count; i++) std::fprintf(file, i > 0 ? ",%llu" : "%llu", static_cast<unsigned long long>(values[i]));
+        std::fprintf(file, "]");
+    }
+
+    void writeCount(std::FILE *file, const char *key, std::uint64_t value)
+    {
+        std::fprintf(file, "  \"%s\": %llu,\n", key, static_cast<unsigned long long>(value));
+    }
+}
+
+void GameTelemetry::merge(const GameTelemetry &other)
+{
+    for (auto a = 0; a < MAX_DICE; a++)
+    {
+        for (auto d = 0; d < MAX_DICE; d++)
+        {
+            attacks_[a][d] += other.attacks_[a][d];
+            captures_[a][d] += other.captures_[a][d];
+        }
+    }
+    for (auto i = 0; i < CAPTURE_BUCKETS; i++) capturesPerTurn_[i] += other.capturesPerTurn_[i];
+    turns_ += other.turns_;
+
+    overflowDice_ += other.overflowDice_;
+    unplacedDice_ += other.unplacedDice_;
+    fullTurns_ += other.fullTurns_;
+
+    eliminations_ += other.eliminations_;
+    for (auto i = 0; i < TURN_BUCKETS; i++) eliminationTurns_[i] += other.eliminationTurns_[i];
+
+    games_ += other.games_;
+    victories_ += other.victories_;
+    victoryTurns_ += other.victoryTurns_;
+    for (auto i = 0; i < TURN_BUCKETS; i++) turnsToVictory_[i] += other.turnsToVictory_[i];
+}
+
+void GameTelemetry::clear()
+{
+    *this = GameTelemetry();
+}
+
+std::uint64_t GameTelemetry::games() const
+{
+    return games_;
+}
+
+bool GameTelemetry::writeJson(std::FILE *file) const
+{
+    std::uint64_t attacks = 0, captures = 0;
+    for (auto a = 0; a < MAX_DICE; a++)
+    {
+        for (auto d = 0; d < MAX_DICE; d++)
+        {
+            attacks += attacks_[a][d];
+            captures += captures_[a][d];
+        }
+    }
+
+    std::fprintf(file, "{\n");
+    writeCount(file, "games", games_);
+    writeCount(file, "victories", victories_);
+    writeCount(file, "draws", games_ - victories_);
+    writeCount(file, "turns", turns_);
+    writeCount(file, "attacks", attacks);
+    writeCount(file, "captures", captures);
+
+    // Rows are the dice of the attacker and columns the ones of the defender, from 1 to MAX_DICE
+    const char *matrices[] = {"attacksByDice", "capturesByDice"};
+    const std::uint64_t (*values[])[MAX_DICE] = {attacks_, captures_};
+    for (auto m = 0; m < 2; m++)
+    {
+        std::fprintf(file, "  \"%s\": [\n", matrices[m]);
+        for (auto a = 0; a < MAX_DICE; a++)
+        {
+            std::fprintf(file, "    ");
+            writeArray(file, values[m][a], MAX_DICE);
+            std::fprintf(file, a + 1 < MAX_DICE ? ",\n" : "\n");
+        }
+        std::fprintf(file, "  ],\n");
+    }
+
+    std::fprintf(file, "  \"winRateByDice\": [\n");
+    for (auto a = 0; a < MAX_DICE; a++)
+    {
+        std::fprintf(file, "    [");
+        for (auto d = 0; d < MAX_DICE; d++)
+        {
+            const auto rate = attacks_[a][d] > 0 ? static_cast<double>(captures_[a][d]) / attacks_[a][d] : 0.0;
+            std::fprintf(file, d > 0 ? ",%.4f" : "%.4f", rate);
+        }
+        std::fprintf(file, a + 1 < MAX_DICE ? "],\n" : "]\n");
+    }
+    std::fprintf(file, "  ],\n");
+
+    std::fprintf(file, "  \"capturesPerTurn\": ");
+    writeArray(file, capturesPerTurn_, CAPTURE_BUCKETS);
+    std::fprintf(file, ",\n");
+
+    writeCount(file, "overflowDice", overflowDice_);
+    writeCount(file, "unplacedDice", unplacedDice_);
+    writeCount(file, "fullTurns", fullTurns_);
+
+    writeCount(file, "eliminations", eliminations_);
+    std::fprintf(file, "  \"turnBucketSize\": %d,\n", TURN_BUCKET_SIZE);
+    std::fprintf(file, "  \"eliminationTurns\": ");
+    writeArray(file, eliminationTurns_, TURN_BUCKETS);
+    std::fprintf(file, ",\n");
+
+    std::fprintf(file, "  \"meanTurnsToVictory\": %.2f,\n", victories_ > 0 ? static_cast<double>(victoryTurns_) / victories_ : 0.0);
+    std::fprintf(file, "  \"turnsToVictory\": ");
+    writeArray(file, turnsToVictory_, TURN_BUCKETS);
+    std::fprintf(file, "\n}\n");
+
+    return !std::ferror(file);
+}
+
+bool GameTelemetry::save(const std::string &fileName) const
+{
+    auto file = std::fopen(fileName.c_str(), "w");
+    if (!file) return false;
+
+    const auto ok = writeJson(file);
+    return std::fclose(file) == 0 && ok;
+}
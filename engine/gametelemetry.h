@@ -0,0 +1,111 @@
+#ifndef GAMETELEMETRY_H
+#define GAMETELEMETRY_H
+
+#include "gamestate.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/// Counters about how games go, used to balance the settings (number and size of the territories, initial
+/// dice, etc.): attacks made and won for every matchup of dice, captures per turn, dice lost to the limit of
+/// the stack or left there because every territory was full, eliminations and the length of the games.
+///
+/// Like LatencyHistogram, it has a fixed size and recording only increments some counters, so every thread
+/// keeps its own one and they are merged once the games are over. Whoever plays a game (Match, GameEngine)
+/// records into it only when one is set, so it costs nothing otherwise
+class GameTelemetry
+{
+public:
+    static constexpr int MAX_DICE = GameState::MAX_DICE;
+
+    /// Captures per turn are counted one by one up to this, and the last bucket takes any turn with more
+    static constexpr int CAPTURE_BUCKETS = 32;
+
+    /// Turns are counted in buckets of this size up to Match::MAX_TURNS, and the last one takes longer games
+    static constexpr int TURN_BUCKET_SIZE = 25;
+    static constexpr int TURN_BUCKETS = 81;
+
+    /// An attack of attackDice (the dice of the attacking territory) against defenseDice, both from 1 to MAX_DICE
+    void recordAttack(int attackDice, int defenseDice, bool captured)
+    {
+        attacks_[attackDice - 1][defenseDice - 1]++;
+        captures_[attackDice - 1][defenseDice - 1] += captured;
+    }
+
+    /// The end of a turn with the given number of captures. The turn earned the player income dice on top of
+    /// remainingBefore already in their stack, and left remainingAfter there once it had placed what it could
+    void recordTurn(int captures, int remainingBefore, int income, int remainingAfter)
+    {
+        turns_++;
+        capturesPerTurn_[captures < CAPTURE_BUCKETS ? captures : CAPTURE_BUCKETS - 1]++;
+
+        const auto overflow = remainingBefore + income - GameState::MAX_REMAINING_DICE;
+        if (overflow > 0) overflowDice_ += static_cast<std::uint64_t>(overflow);
+        if (remainingAfter > 0)
+        {
+            fullTurns_++;
+            unplacedDice_ += static_cast<std::uint64_t>(remainingAfter);
+        }
+    }
+
+    /// A player losing their last territory during the given turn (counted from 0)
+    void recordElimination(int turn)
+    {
+        eliminations_++;
+        eliminationTurns_[turnBucket(turn)]++;
+    }
+
+    /// The end of a game after the given number of turns, either won by a player or drawn at the turn limit
+    void recordGame(int turns, bool won)
+    {
+        games_++;
+        if (!won) return;
+
+        victories_++;
+        victoryTurns_ += static_cast<std::uint64_t>(turns);
+        turnsToVictory_[turnBucket(turns)]++;
+    }
+
+    void merge(const GameTelemetry &other);
+    void clear();
+
+    std::uint64_t games() const;
+
+    /// Writes the counters as a JSON object, together with the win rate of every matchup and the mean
+    /// length of the games that were won
+    bool writeJson(std::FILE *file) const;
+
+    /// Same as above into a new file, replacing it if it already exists
+    bool save(const std::string &fileName) const;
+
+private:
+    static int turnBucket(int turn)
+    {
+        const auto bucket = turn / TURN_BUCKET_SIZE;
+        return bucket < TURN_BUCKETS ? bucket : TURN_BUCKETS - 1;
+    }
+
+    /// Indexed by the dice of the attacker and then the ones of the defender, from 1
+    std::uint64_t attacks_[MAX_DICE][MAX_DICE] = {};
+    std::uint64_t captures_[MAX_DICE][MAX_DICE] = {};
+
+    std::uint64_t capturesPerTurn_[CAPTURE_BUCKETS] = {};
+    std::uint64_t turns_ = 0;
+
+    /// Dice that did not fit in the stack, and dice that could not be placed because every territory of the
+    /// player was full (they stay in the stack, so the same dice can be counted again on later turns)
+    std::uint64_t overflowDice_ = 0;
+    std::uint64_t unplacedDice_ = 0;
+    std::uint64_t fullTurns_ = 0;
+
+    std::uint64_t eliminations_ = 0;
+    std::uint64_t eliminationTurns_[TURN_BUCKETS] = {};
+
+    std::uint64_t games_ = 0;
+    std::uint64_t victories_ = 0;
+    std::uint64_t victoryTurns_ = 0;
+    std::uint64_t turnsToVictory_[TURN_BUCKETS] = {};
+};
+
+#endif // GAMETELEMETRY_H
@@ -0,0 +1,221 @@
+#ifndef HEXCOORD_H
+#define HEXCOORD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/// Axial coordinates (q, r) of a hex cell, packed into 32 bits so that they are as cheap to copy, compare and
+/// hash as an int. Everything is constexpr, so the tables of directions and the conversions cost nothing when
+/// the arguments are known at compile time.
+///
+/// Boards are stored row by row in offset coordinates (column and row), with pointy-top cells and the odd rows
+/// shifted half a cell to the right. In pixels, the center of the cell at column 0 and row 0 is at the origin
+/// and cells have the given radius (from the center to a corner), like MapTopology::center and HexGrid do
+class HexCoord
+{
+    std::uint32_t packed_ = 0;
+
+    template <class T>
+    static constexpr T SQRT3 = static_cast<T>(1.7320508075688772935);
+
+    static constexpr int abs(int value) { return value < 0 ? -value : value; }
+
+    /// Rounds half away from zero like std::lround, but can be used in constant expressions
+    template <class T>
+    static constexpr int roundToInt(T value) { return value >= 0 ? static_cast<int>(value + T(0.5)) : -static_cast<int>(T(0.5) - value); }
+
+public:
+    /// Number of neighbours of a cell
+    static constexpr int DIRECTION_COUNT = 6;
+
+    /// Offset to the neighbour in each direction, starting from the right and going clockwise on screen
+    static constexpr int DIRECTIONS[DIRECTION_COUNT][2] = {{1,0},{0,1},{-1,1},{-1,0},{0,-1},{+1,-1}};
+
+    constexpr HexCoord() = default;
+
+    /// Both coordinates must fit in 16 bits
+    constexpr HexCoord(int q, int r)
+        : packed_(static_cast<std::uint16_t>(q) | static_cast<std::uint32_t>(static_cast<std::uint16_t>(r)) << 16)
+    {
+    }
+
+    constexpr int q() const { return static_cast<std::int16_t>(packed_ & 0xffff); }
+    constexpr int r() const { return static_cast<std::int16_t>(packed_ >> 16); }
+
+    /// The third cube coordinate, as q + r + s is always 0
+    constexpr int s() const { return -q() - r(); }
+
+    constexpr std::uint32_t packed() const { return packed_; }
+
+    static constexpr HexCoord fromPacked(std::uint32_t packed)
+    {
+        HexCoord coord;
+        coord.packed_ = packed;
+        return coord;
+    }
+
+    static constexpr HexCoord fromOffset(int column, int row) { return HexCoord(column - (row - (row & 1)) / 2, row); }
+
+    /// The cell at the given index of a board stored row by row
+    static constexpr HexCoord fromIndex(int index, int width) { return fromOffset(index % width, index / width); }
+
+    constexpr int column() const { return q() + (r() - (r() & 1)) / 2; }
+    constexpr int row() const { return r(); }
+
+    constexpr bool isInside(int width, int height) const
+    {
+        return row() >= 0 && row() < height && column() >= 0 && column() < width;
+    }
+
+    /// Index of the cell in a board stored row by row, which must contain it
+    constexpr int index(int width) const { return row() * width + column(); }
+
+    static constexpr HexCoord direction(int direction) { return HexCoord(DIRECTIONS[direction][0], DIRECTIONS[direction][1]); }
+
+    /// The adjacent cell in the given direction, from 0 to DIRECTION_COUNT - 1
+    constexpr HexCoord neighbour(int direction) const { return *this + HexCoord::direction(direction); }
+
+    constexpr HexCoord operator+(HexCoord other) const { return HexCoord(q() + other.q(), r() + other.r()); }
+    constexpr HexCoord operator-(HexCoord other) const { return HexCoord(q() - other.q(), r() - other.r()); }
+    constexpr HexCoord operator*(int factor) const { return HexCoord(q() * factor, r() * factor); }
+
+    constexpr bool operator==(HexCoord other) const { return packed_ == other.packed_; }
+    constexpr bool operator!=(HexCoord other) const { return packed_ != other.packed_; }
+
+    /// Distance to the origin, in cells
+    constexpr int length() const { return (abs(q()) + abs(r()) + abs(s())) / 2; }
+
+    /// Number of steps between both cells
+    constexpr int distance(HexCoord other) const { return (*this - other).length(); }
+
+    /// Number of cells at a distance of radius or less from any cell
+    static constexpr int cellsWithin(int radius) { return 1 + 3 * radius * (radius + 1); }
+
+    /// Fibonacci hashing of the packed value, which spreads nearby cells over the whole range
+    constexpr std::uint32_t hash() const { return packed_ * 0x9e3779b9u; }
+
+    template <class T>
+    constexpr T centerX(T radius = 1) const { return SQRT3<T> * radius * (static_cast<T>(column()) + static_cast<T>(row() & 1) * T(0.5)); }
+
+    template <class T>
+    constexpr T centerY(T radius = 1) const { return T(1.5) * radius * static_cast<T>(row()); }
+
+    /// The nearest cell to the fractional axial coordinates, rounding them in cube coordinates
+    template <class T>
+    static constexpr HexCoord round(T q, T r)
+    {
+        const auto s = -q - r;
+        auto rq = roundToInt(q);
+        auto rr = roundToInt(r);
+        const auto rs = roundToInt(s);
+
+        const auto qDiff = q > rq ? q - rq : rq - q;
+        const auto rDiff = r > rr ? r - rr : rr - r;
+        const auto sDiff = s > rs ? s - rs : rs - s;
+        if (qDiff > rDiff && qDiff > sDiff) rq = -rr - rs;
+        else if (rDiff > sDiff) rr = -rq - rs;
+        return HexCoord(rq, rr);
+    }
+
+    /// The cell containing the point, which may be outside the board
+    template <class T>
+    static constexpr HexCoord fromPixel(T x, T y, T radius = 1)
+    {
+        return round((x * SQRT3<T> / 3 - y / 3) / radius, y * 2 / 3 / radius);
+    }
+};
+
+namespace std
+{
+    template <>
+    struct hash<HexCoord>
+    {
+        std::size_t operator()(HexCoord coord) const { return coord.hash(); }
+    };
+}
+
+/// The cells at the given distance from a center, going once around it:
+///
+///     for (auto cell : HexRing(center, 2)) ...
+///
+/// The ring starts at the top left corner and follows the directions in order. A ring of radius 0 is the center
+class HexRing
+{
+    HexCoord center_;
+    int radius_;
+
+public:
+    class iterator
+    {
+        HexCoord current_;
+        int radius_;
+        int index_;
+
+    public:
+        constexpr iterator(HexCoord current, int radius, int index) : current_(current), radius_(radius), index_(index) {}
+
+        constexpr HexCoord operator*() const { return current_; }
+
+        constexpr iterator &operator++()
+        {
+            if (radius_ > 0) current_ = current_.neighbour(index_ / radius_);
+            index_++;
+            return *this;
+        }
+
+        constexpr bool operator==(const iterator &other) const { return index_ == other.index_; }
+        constexpr bool operator!=(const iterator &other) const { return index_ != other.index_; }
+    };
+
+    constexpr HexRing(HexCoord center, int radius) : center_(center), radius_(radius) {}
+
+    constexpr int size() const { return radius_ > 0 ? HexCoord::DIRECTION_COUNT * radius_ : 1; }
+
+    constexpr iterator begin() const { return iterator(center_ + HexCoord::direction(4) * radius_, radius_, 0); }
+    constexpr iterator end() const { return iterator(HexCoord(), radius_, size()); }
+};
+
+/// The cells at a distance of radius or less from a center, from the center outwards ring by ring
+class HexSpiral
+{
+    HexCoord center_;
+    int radius_;
+
+public:
+    class iterator
+    {
+        HexCoord center_;
+        HexCoord current_;
+        int ring_;
+        int index_;
+
+    public:
+        constexpr iterator(HexCoord center, int ring) : center_(center), current_(center + HexCoord::direction(4) * ring), ring_(ring), index_(0) {}
+
+        constexpr HexCoord operator*() const { return current_; }
+
+        constexpr iterator &operator++()
+        {
+            if (ring_ > 0) current_ = current_.neighbour(index_ / ring_);
+            if (++index_ < HexRing(center_, ring_).size()) return *this;
+
+            ring_++;
+            index_ = 0;
+            current_ = center_ + HexCoord::direction(4) * ring_;
+            return *this;
+        }
+
+        constexpr bool operator==(const iterator &other) const { return ring_ == other.ring_ && index_ == other.index_; }
+        constexpr bool operator!=(const iterator &other) const { return !(*this == other); }
+    };
+
+    constexpr HexSpiral(HexCoord center, int radius) : center_(center), radius_(radius) {}
+
+    constexpr int size() const { return HexCoord::cellsWithin(radius_); }
+
+    constexpr iterator begin() const { return iterator(center_, 0); }
+    constexpr iterator end() const { return iterator(center_, radius_ + 1); }
+};
+
+#endif // HEXCOORD_H
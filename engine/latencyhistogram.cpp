@@ -0,0 +1,76 @@
+#include "latencyhistogram.h"
+
+#include <cmath>
+
+void LatencyHistogram::record(std::uint64_t nanoseconds)
+{
+    buckets_[bucket(nanoseconds)]++;
+    count_++;
+    sum_ += nanoseconds;
+    if (nanoseconds > max_) max_ = nanoseconds;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (auto i = 0; i < BUCKET_COUNT; i++) buckets_[i] += other.buckets_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    if (other.max_ > max_) max_ = other.max_;
+}
+
+void LatencyHistogram::clear()
+{
+    *this = LatencyHistogram();
+}
+
+std::uint64_t LatencyHistogram::count() const
+{
+    return count_;
+}
+
+std::uint64_t LatencyHistogram::max() const
+{
+    return max_;
+}
+
+double LatencyHistogram::mean() const
+{
+    return count_ > 0 ? static_cast<double>(sum_) / count_ : 0;
+}
+
+double LatencyHistogram::percentile(double fraction) const
+{
+    if (count_ == 0) return 0;
+
+    const auto target = static_cast<std::uint64_t>(std::ceil(fraction * count_));
+    std::uint64_t accumulated = 0;
+    for (auto i = 0; i < BUCKET_COUNT; i++)
+    {
+        accumulated += buckets_[i];
+        if (accumulated >= target && buckets_[i] > 0)
+        {
+            // The middle of the bucket, but never above the largest sample
+            const auto value = (lowerBound(i) + lowerBound(i + 1)) / 2;
+            return value < max_ ? value : static_cast<double>(max_);
+        }
+    }
+    return static_cast<double>(max_);
+}
+
+int LatencyHistogram::bucket(std::uint64_t nanoseconds)
+{
+    if (nanoseconds < 2) return static_cast<int>(nanoseconds);
+
+    // The position of the highest bit gives the octave, and the next two bits the bucket inside it
+    auto octave = 63;
+    while (!(nanoseconds >> octave)) octave--;
+    const auto fraction = octave >= 2 ? (nanoseconds >> (octave - 2)) & 3 : (nanoseconds << (2 - octave)) & 3;
+    return octave * BUCKETS_PER_OCTAVE + static_cast<int>(fraction);
+}
+
+double LatencyHistogram::lowerBound(int bucket)
+{
+    const auto octave = bucket / BUCKETS_PER_OCTAVE;
+    const auto fraction = bucket % BUCKETS_PER_OCTAVE;
+    return std::ldexp(1.0 + fraction / static_cast<double>(BUCKETS_PER_OCTAVE), octave);
+}
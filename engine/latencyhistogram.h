@@ -0,0 +1,38 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <cstdint>
+
+/// Histogram of durations in nanoseconds with logarithmic buckets (four per power of two, so any
+/// percentile is within 19% of the real value). It has a fixed size and recording does not allocate, so
+/// every thread can keep its own one and merge them at the end
+class LatencyHistogram
+{
+public:
+    static constexpr int BUCKETS_PER_OCTAVE = 4;
+    static constexpr int BUCKET_COUNT = 64 * BUCKETS_PER_OCTAVE;
+
+    void record(std::uint64_t nanoseconds);
+    void merge(const LatencyHistogram &other);
+    void clear();
+
+    std::uint64_t count() const;
+    std::uint64_t max() const;
+    double mean() const;
+
+    /// The duration below which the given fraction (between 0 and 1) of the samples are, in nanoseconds
+    double percentile(double fraction) const;
+
+private:
+    static int bucket(std::uint64_t nanoseconds);
+
+    /// Smallest duration that goes into the bucket
+    static double lowerBound(int bucket);
+
+    std::uint64_t buckets_[BUCKET_COUNT] = {};
+    std::uint64_t count_ = 0;
+    std::uint64_t sum_ = 0;
+    std::uint64_t max_ = 0;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,578 @@
+#include "mapgenerator.h"
+
+#include "hexcoord.h"
+#include "random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    /// Cell centers are in board coordinates for cells with a radius of 1, like MapTopology::center
+    constexpr float HORIZONTAL_SPACING = HexCoord(1, 0).centerX<float>();
+    constexpr float VERTICAL_SPACING = HexCoord(0, 1).centerY<float>();
+
+    /// Area of a cell with a radius of 1
+    constexpr float CELL_AREA = VERTICAL_SPACING * HORIZONTAL_SPACING;
+
+    /// Candidates tried around a Poisson-disc sample before it stops spreading
+    constexpr int POISSON_ATTEMPTS = 30;
+
+    /// Directions a Poisson-disc candidate can be placed in around its sample. They are taken from a table rather
+    /// than from std::cos and std::sin, which round differently with each standard library, so that the same seed
+    /// gives the same map on every machine (network games rely on it)
+    constexpr int DIRECTIONS = 64;
+
+    /// cos(i * pi / 32) for the first quarter of the circle; the other quarters are the same values swapped and negated
+    constexpr float QUARTER_COSINES[DIRECTIONS / 4 + 1] = {
+        1.0f, 0.99518472f, 0.980785251f, 0.956940353f, 0.923879504f, 0.881921291f, 0.831469595f, 0.773010433f,
+        0.707106769f, 0.634393275f, 0.555570245f, 0.471396744f, 0.382683426f, 0.290284663f, 0.195090324f,
+        0.0980171412f, 0.0f};
+
+    void direction(int index, float &x, float &y)
+    {
+        const auto quarter = index / (DIRECTIONS / 4);
+        const auto i = index % (DIRECTIONS / 4);
+        const auto c = QUARTER_COSINES[i];
+        const auto s = QUARTER_COSINES[DIRECTIONS / 4 - i];
+        switch (quarter)
+        {
+            case 0: x = c; y = s; break;
+            case 1: x = -s; y = c; break;
+            case 2: x = -c; y = -s; break;
+            default: x = s; y = -c; break;
+        }
+    }
+
+    /// Returns the index of the neighbour of the given cell, or -1 if it is outside the board
+    int neighbourCell(int width, int height, int cell, int direction)
+    {
+        const auto neighbour = HexCoord::fromIndex(cell, width).neighbour(direction);
+        return neighbour.isInside(width, height) ? neighbour.index(width) : -1;
+    }
+
+    /// A random number between 0 and 1, with the same result on every platform
+    float uniform(Random &random)
+    {
+        return static_cast<float>(random.next() >> 40) * (1.0f / (1 << 24));
+    }
+
+    int maxTerritories(const MapSettings &settings)
+    {
+        return std::min(settings.numTerritories, static_cast<int>(MapTopology::MAX_TERRITORIES));
+    }
+
+    /// Numbers the territories left consecutively, in the same order, dropping the cells of the others
+    void renumber(std::vector<std::int16_t> &cells, const std::vector<bool> &keep)
+    {
+        std::vector<std::int16_t> newIndex(keep.size(), -1);
+        std::int16_t count = 0;
+        for (std::size_t i = 0; i < keep.size(); i++)
+        {
+            if (keep[i]) newIndex[i] = count++;
+        }
+
+        for (auto &cell : cells)
+        {
+            if (cell >= 0) cell = newIndex[cell];
+        }
+    }
+
+    /// Removes the territories with fewer cells than the settings ask for, numbers the rest consecutively and
+    /// builds the topology. If that leaves groups of territories that cannot reach each other, only the
+    /// largest group is kept, as the players of the others could never win
+    std::shared_ptr<const MapTopology> finishMap(const MapSettings &settings, std::vector<std::int16_t> cells, int territoryCount)
+    {
+        std::vector<int> sizes(territoryCount, 0);
+        for (auto cell : cells)
+        {
+            if (cell >= 0) sizes[cell]++;
+        }
+
+        std::vector<bool> keep(territoryCount);
+        for (auto i = 0; i < territoryCount; i++) keep[i] = sizes[i] >= settings.minCells;
+        renumber(cells, keep);
+
+        auto map = MapTopology::fromCells(settings.width, settings.height, cells);
+        if (!map || map->territoryCount() == 0) return map;
+
+        std::vector<int> groups(map->territoryCount(), -1);
+        std::vector<int> groupSizes;
+        std::vector<int> stack;
+        for (auto start = 0; start < map->territoryCount(); start++)
+        {
+            if (groups[start] >= 0) continue;
+            const auto group = static_cast<int>(groupSizes.size());
+            groupSizes.push_back(0);
+            groups[start] = group;
+            stack.push_back(start);
+            while (!stack.empty())
+            {
+                const auto terr = stack.back();
+                stack.pop_back();
+                groupSizes[group]++;
+                for (auto neighbour : map->neighbours(terr))
+                {
+                    if (groups[neighbour] >= 0) continue;
+                    groups[neighbour] = group;
+                    stack.push_back(neighbour);
+                }
+            }
+        }
+        if (groupSizes.size() == 1) return map;
+
+        const auto largest = static_cast<int>(std::max_element(groupSizes.begin(), groupSizes.end()) - groupSizes.begin());
+        keep.assign(groups.size(), false);
+        for (std::size_t i = 0; i < groups.size(); i++) keep[i] = groups[i] == largest;
+        renumber(cells, keep);
+
+        return MapTopology::fromCells(settings.width, settings.height, std::move(cells));
+    }
+
+    /// Working data while growing the territories: the territory of every cell and the cells of every territory
+    class GrowthBoard
+    {
+        int width_;
+        int height_;
+        std::vector<std::int16_t> cells_;
+        std::vector<std::vector<int>> territories_;
+
+    public:
+        GrowthBoard(int width, int height) : width_(width), height_(height), cells_(static_cast<std::size_t>(width) * height, -1) {}
+
+        int territoryCount() const { return static_cast<int>(territories_.size()); }
+        int cellCount(int terr) const { return static_cast<int>(territories_[terr].size()); }
+        std::vector<std::int16_t> &cells() { return cells_; }
+
+        int neighbour(int cell, int direction) const { return neighbourCell(width_, height_, cell, direction); }
+
+        int addTerritory()
+        {
+            territories_.emplace_back();
+            return territoryCount() - 1;
+        }
+
+        void appendCell(int terr, int cell)
+        {
+            cells_[cell] = static_cast<std::int16_t>(terr);
+            territories_[terr].push_back(cell);
+        }
+
+        /// Finds an empty cell adjacent to the territory, starting from a random cell and direction, or -1 if there is none
+        int findEmptyAdjacent(int terr, Random &random) const
+        {
+            const auto &list = territories_[terr];
+            const auto size = static_cast<int>(list.size());
+            if (size == 0) return -1;
+
+            const auto indexOffset = random.bounded(size);
+            for (auto indexBase = 0; indexBase < size; indexBase++)
+            {
+                const auto cell = list[(indexBase + indexOffset) % size];
+                const auto dirOffset = random.bounded(6);
+                for (auto dirBase = 0; dirBase < 6; dirBase++)
+                {
+                    const auto neighbour = this->neighbour(cell, (dirBase + dirOffset) % 6);
+                    if (neighbour >= 0 && cells_[neighbour] < 0) return neighbour;
+                }
+            }
+
+            return -1;
+        }
+
+        /// Adds up to the given number of cells to the territory, stopping when it cannot grow anymore
+        void grow(int terr, int numCells, Random &random)
+        {
+            for (auto cellCount = 0; cellCount < numCells; cellCount++)
+            {
+                const auto cell = findEmptyAdjacent(terr, random);
+                if (cell < 0) return;
+                appendCell(terr, cell);
+            }
+        }
+    };
+}
+
+bool MapSettings::isValid() const
+{
+    // Larger settings than the limits are rejected rather than overflowing the cell indices or the 16-bit
+    // territory numbers
+    return width > 0 && height > 0 && width <= MAX_SIDE && height <= MAX_SIDE
+           && static_cast<std::int64_t>(width) * height <= MAX_CELLS
+           && numTerritories > 0 && numTerritories <= MapTopology::MAX_TERRITORIES
+           && territorySize > 0 && territorySize <= MAX_CELLS;
+}
+
+std::shared_ptr<const MapTopology> generateGrowthMap(const MapSettings &settings, std::uint64_t seed,
+                                                     const MapProgress &progress)
+{
+    if (!settings.isValid()) return nullptr;
+
+    Random random(seed);
+    GrowthBoard board(settings.width, settings.height);
+
+    const auto x = random.bounded(settings.width);
+    const auto y = random.bounded(settings.height);
+    auto terr = board.addTerritory();
+    board.appendCell(terr, y * settings.width + x);
+    board.grow(terr, settings.territorySize, random);
+
+    const auto total = maxTerritories(settings);
+    if (progress) progress(1, total);
+    for (auto terrCount = 1; terrCount < total; terrCount++)
+    {
+        // First attempt: selecting and adjacent hex from the previous territory
+        auto cell = board.findEmptyAdjacent(terr, random);
+
+        // If that does not work, then select an adjacent hex from a random territory, giving up once the
+        // board is full
+        for (auto attempt = 0; cell < 0 && attempt < terrCount * 4; attempt++)
+        {
+            cell = board.findEmptyAdjacent(random.bounded(terrCount), random);
+        }
+        for (auto other = 0; cell < 0 && other < terrCount; other++) cell = board.findEmptyAdjacent(other, random);
+        if (cell < 0) break;
+
+        terr = board.addTerritory();
+        board.appendCell(terr, cell);
+        board.grow(terr, settings.territorySize, random);
+        if (progress) progress(terrCount + 1, total);
+    }
+
+    return finishMap(settings, std::move(board.cells()), board.territoryCount());
+}
+
+std::shared_ptr<const MapTopology> GrowthMapGenerator::generate(const MapSettings &settings, std::uint64_t seed,
+                                                                const MapProgress &progress)
+{
+    return generateGrowthMap(settings, seed, progress);
+}
+
+std::string GrowthMapGenerator::name() const
+{
+    return "growth";
+}
+
+std::shared_ptr<const MapTopology> GridMapGenerator::generate(const MapSettings &settings, std::uint64_t seed,
+                                                              const MapProgress &progress)
+{
+    if (!settings.isValid()) return nullptr;
+
+    Random random(seed);
+
+    // Blocks are squares of about territorySize cells. There is one more row of them than fits the board, so
+    // that the cells at the bottom edge can move down
+    const auto size = std::max(2, static_cast<int>(std::lround(std::sqrt(static_cast<double>(settings.territorySize)))));
+    const auto rows = settings.height / size + 1;
+    const auto territoryCount = (settings.width / size + 2) * rows;
+    if (territoryCount > MapTopology::MAX_TERRITORIES) return nullptr;
+
+    std::vector<std::int16_t> cells(static_cast<std::size_t>(settings.width) * settings.height, -1);
+    for (auto x = 0; x < settings.width; x++)
+    {
+        for (auto y = 0; y < settings.height; y++)
+        {
+            auto index = (x / size) * rows + y / size;
+            if (x % size == size - 1) //At the limit of a terrain
+                index += random.bounded(2) * rows;
+            else if (y % size == size - 1)
+                index += random.bounded(2);
+
+            cells[y * settings.width + x] = static_cast<std::int16_t>(index);
+        }
+        if (progress) progress(x + 1, settings.width);
+    }
+
+    return finishMap(settings, std::move(cells), territoryCount);
+}
+
+std::string GridMapGenerator::name() const
+{
+    return "grid";
+}
+
+VoronoiMapGenerator::VoronoiMapGenerator(int relaxations)
+    : relaxations_(relaxations)
+{
+}
+
+int VoronoiMapGenerator::nearestSeed(float x, float y, float maxDistance, float bucketSize, int bucketColumns, int bucketRows) const
+{
+    // No seed is further than one bucket away
+    const auto column = static_cast<int>(x / bucketSize);
+    const auto row = static_cast<int>(y / bucketSize);
+
+    auto best = -1;
+    auto bestDistance = maxDistance * maxDistance;
+    for (auto r = std::max(0, row - 1); r <= std::min(bucketRows - 1, row + 1); r++)
+    {
+        for (auto c = std::max(0, column - 1); c <= std::min(bucketColumns - 1, column + 1); c++)
+        {
+            for (auto seed = bucketHeads_[r * bucketColumns + c]; seed >= 0; seed = bucketNext_[seed])
+            {
+                const auto dx = seedX_[seed] - x;
+                const auto dy = seedY_[seed] - y;
+                const auto distance = dx * dx + dy * dy;
+
+                // Ties go to the lowest seed, so the result does not depend on the order of the buckets
+                if (distance < bestDistance || (distance == bestDistance && best >= 0 && seed < best))
+                {
+                    best = seed;
+                    bestDistance = distance;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+std::shared_ptr<const MapTopology> VoronoiMapGenerator::generate(const MapSettings &settings, std::uint64_t seed,
+                                                                 const MapProgress &progress)
+{
+    if (!settings.isValid()) return nullptr;
+
+    Random random(seed);
+    const auto total = maxTerritories(settings);
+    const auto boardWidth = HORIZONTAL_SPACING * (settings.width + 0.5f);
+    const auto boardHeight = VERTICAL_SPACING * settings.height;
+
+    // Poisson-disc sampling keeps every seed at least this far from the others. Dense enough samplings leave
+    // about 1.5 spacing^2 of board around every seed, which should be territorySize cells
+    const auto spacing = std::sqrt(settings.territorySize * CELL_AREA / 1.5f);
+    const auto steps = relaxations_ + 2;
+
+    // Bridson's algorithm, always taking the oldest active seed so that they spread out from the first one
+    // as a single continent. The buckets are small enough to hold one seed at most
+    const auto sampleBucket = spacing / std::sqrt(2.0f);
+    const auto sampleColumns = static_cast<int>(boardWidth / sampleBucket) + 1;
+    const auto sampleRows = static_cast<int>(boardHeight / sampleBucket) + 1;
+    bucketHeads_.assign(static_cast<std::size_t>(sampleColumns) * sampleRows, -1);
+    seedX_.clear();
+    seedY_.clear();
+
+    const auto addSeed = [&](float x, float y)
+    {
+        bucketHeads_[static_cast<int>(y / sampleBucket) * sampleColumns + static_cast<int>(x / sampleBucket)] = static_cast<int>(seedX_.size());
+        seedX_.push_back(x);
+        seedY_.push_back(y);
+    };
+    const auto fits = [&](float x, float y)
+    {
+        if (x < 0 || y < 0 || x >= boardWidth || y >= boardHeight) return false;
+
+        const auto column = static_cast<int>(x / sampleBucket);
+        const auto row = static_cast<int>(y / sampleBucket);
+        for (auto r = std::max(0, row - 2); r <= std::min(sampleRows - 1, row + 2); r++)
+        {
+            for (auto c = std::max(0, column - 2); c <= std::min(sampleColumns - 1, column + 2); c++)
+            {
+                const auto other = bucketHeads_[r * sampleColumns + c];
+                if (other < 0) continue;
+                const auto dx = seedX_[other] - x;
+                const auto dy = seedY_[other] - y;
+                if (dx * dx + dy * dy < spacing * spacing) return false;
+            }
+        }
+        return true;
+    };
+
+    const auto startX = random.bounded(settings.width);
+    const auto startY = random.bounded(settings.height);
+    const auto start = HexCoord::fromOffset(startX, startY);
+    addSeed(start.centerX<float>(), start.centerY<float>());
+    for (std::size_t active = 0; active < seedX_.size() && static_cast<int>(seedX_.size()) < total;)
+    {
+        auto added = false;
+        for (auto attempt = 0; attempt < POISSON_ATTEMPTS && !added; attempt++)
+        {
+            float dx, dy;
+            direction(random.bounded(DIRECTIONS), dx, dy);
+            const auto distance = spacing * (1 + uniform(random));
+            const auto x = seedX_[active] + distance * dx;
+            const auto y = seedY_[active] + distance * dy;
+            if (!fits(x, y)) continue;
+            addSeed(x, y);
+            added = true;
+        }
+        if (!added) active++;
+    }
+    const auto seedCount = static_cast<int>(seedX_.size());
+    if (progress) progress(1, steps);
+
+    // Cells further than the spacing from every seed are left empty, which gives the continent its coast.
+    // Neighbouring seeds are closer than twice the spacing, so their territories always touch
+    const auto bucketColumns = static_cast<int>(boardWidth / spacing) + 1;
+    const auto bucketRows = static_cast<int>(boardHeight / spacing) + 1;
+    std::vector<std::int16_t> cells(static_cast<std::size_t>(settings.width) * settings.height, -1);
+    for (auto step = 0; step <= relaxations_; step++)
+    {
+        // The seeds move on every relaxation, so they are bucketed again
+        bucketHeads_.assign(static_cast<std::size_t>(bucketColumns) * bucketRows, -1);
+        bucketNext_.assign(seedCount, -1);
+        for (auto i = seedCount; i-- > 0;)
+        {
+            const auto column = std::min(bucketColumns - 1, std::max(0, static_cast<int>(seedX_[i] / spacing)));
+            const auto row = std::min(bucketRows - 1, std::max(0, static_cast<int>(seedY_[i] / spacing)));
+            auto &head = bucketHeads_[row * bucketColumns + column];
+            bucketNext_[i] = head;
+            head = i;
+        }
+
+        sums_.assign(static_cast<std::size_t>(seedCount) * 3, 0);
+        for (auto y = 0; y < settings.height; y++)
+        {
+            for (auto x = 0; x < settings.width; x++)
+            {
+                const auto cell = HexCoord::fromOffset(x, y);
+                const auto cx = cell.centerX<float>();
+                const auto cy = cell.centerY<float>();
+                const auto nearest = nearestSeed(cx, cy, spacing, spacing, bucketColumns, bucketRows);
+                cells[y * settings.width + x] = static_cast<std::int16_t>(nearest);
+                if (nearest < 0) continue;
+                sums_[nearest * 3] += cx;
+                sums_[nearest * 3 + 1] += cy;
+                sums_[nearest * 3 + 2] += 1;
+            }
+        }
+        if (progress) progress(step + 2, steps);
+        if (step == relaxations_) break;
+
+        // Lloyd relaxation: every seed moves to the centroid of its cells
+        for (auto i = 0; i < seedCount; i++)
+        {
+            if (sums_[i * 3 + 2] == 0) continue;
+            seedX_[i] = static_cast<float>(sums_[i * 3] / sums_[i * 3 + 2]);
+            seedY_[i] = static_cast<float>(sums_[i * 3 + 1] / sums_[i * 3 + 2]);
+        }
+    }
+
+    return finishMap(settings, std::move(cells), seedCount);
+}
+
+std::string VoronoiMapGenerator::name() const
+{
+    if (relaxations_ == DEFAULT_RELAXATIONS) return "voronoi";
+    return "voronoi:relax=" + std::to_string(relaxations_);
+}
+
+std::shared_ptr<const MapTopology> FloodMapGenerator::generate(const MapSettings &settings, std::uint64_t seed,
+                                                               const MapProgress &progress)
+{
+    if (!settings.isValid()) return nullptr;
+
+    Random random(seed);
+    const auto cellCount = settings.width * settings.height;
+    const auto total = maxTerritories(settings);
+    std::vector<std::int16_t> cells(static_cast<std::size_t>(cellCount), -1);
+
+    // The seeds are laid on a jittered lattice in the middle of the board, with a square of about territorySize
+    // cells for each of them, so that neighbouring territories meet as they grow into a single continent
+    const auto columns = std::max(1, std::min(settings.width, static_cast<int>(std::lround(std::sqrt(static_cast<double>(total) * settings.width / settings.height)))));
+    const auto rows = std::max(1, std::min(settings.height, (total + columns - 1) / columns));
+    const auto step = std::sqrt(static_cast<float>(settings.territorySize));
+    const auto stepX = std::min(step, static_cast<float>(settings.width) / columns);
+    const auto stepY = std::min(step, static_cast<float>(settings.height) / rows);
+    const auto left = (settings.width - stepX * columns) / 2;
+    const auto top = (settings.height - stepY * rows) / 2;
+
+    if (frontiers_.size() < static_cast<std::size_t>(total)) frontiers_.resize(total);
+    frontierHeads_.assign(total, 0);
+    sizes_.assign(total, 0);
+    growing_.clear();
+
+    const auto claim = [&](int terr, int cell)
+    {
+        cells[cell] = static_cast<std::int16_t>(terr);
+        sizes_[terr]++;
+
+        auto &frontier = frontiers_[terr];
+        const auto dirOffset = random.bounded(6);
+        for (auto dirBase = 0; dirBase < HexCoord::DIRECTION_COUNT; dirBase++)
+        {
+            const auto neighbour = neighbourCell(settings.width, settings.height, cell, (dirBase + dirOffset) % HexCoord::DIRECTION_COUNT);
+            if (neighbour >= 0 && cells[neighbour] < 0) frontier.push_back(neighbour);
+        }
+    };
+
+    auto territoryCount = 0;
+    for (auto lattice = 0; lattice < rows * columns && territoryCount < total; lattice++)
+    {
+        const auto x = std::min(settings.width - 1, static_cast<int>(left + (lattice % columns + 0.25f + 0.5f * uniform(random)) * stepX));
+        const auto y = std::min(settings.height - 1, static_cast<int>(top + (lattice / columns + 0.25f + 0.5f * uniform(random)) * stepY));
+        const auto cell = y * settings.width + x;
+        if (cells[cell] >= 0) continue;
+
+        frontiers_[territoryCount].clear();
+        claim(territoryCount, cell);
+        growing_.push_back(territoryCount);
+        territoryCount++;
+    }
+
+    // Every round, the territories still growing take one cell each, in a random order so that none of them
+    // is always first to reach the cells they compete for
+    auto claimed = territoryCount;
+    const auto target = territoryCount * settings.territorySize;
+    while (!growing_.empty())
+    {
+        for (auto i = static_cast<int>(growing_.size()) - 1; i > 0; i--) std::swap(growing_[i], growing_[random.bounded(i + 1)]);
+
+        for (std::size_t i = 0; i < growing_.size();)
+        {
+            const auto terr = growing_[i];
+            auto &frontier = frontiers_[terr];
+            auto &head = frontierHeads_[terr];
+            while (head < frontier.size() && cells[frontier[head]] >= 0) head++;
+
+            if (head < frontier.size())
+            {
+                claim(terr, frontier[head++]);
+                claimed++;
+            }
+
+            if (head >= frontier.size() || sizes_[terr] >= settings.territorySize)
+            {
+                growing_[i] = growing_.back();
+                growing_.pop_back();
+                continue;
+            }
+            i++;
+        }
+
+        if (progress) progress(std::min(claimed, target), target);
+    }
+
+    return finishMap(settings, std::move(cells), territoryCount);
+}
+
+std::string FloodMapGenerator::name() const
+{
+    return "flood";
+}
+
+std::unique_ptr<MapGenerator> createMapGenerator(const std::string &spec)
+{
+    if (spec == "growth") return std::unique_ptr<MapGenerator>(new GrowthMapGenerator());
+    if (spec == "grid") return std::unique_ptr<MapGenerator>(new GridMapGenerator());
+    if (spec == "flood") return std::unique_ptr<MapGenerator>(new FloodMapGenerator());
+
+    const std::string voronoi = "voronoi";
+    if (spec.compare(0, voronoi.size(), voronoi) == 0)
+    {
+        auto relaxations = VoronoiMapGenerator::DEFAULT_RELAXATIONS;
+        const std::string option = ":relax=";
+        if (spec.size() > voronoi.size())
+        {
+            if (spec.compare(voronoi.size(), option.size(), option) != 0) return nullptr;
+            const auto digits = spec.c_str() + voronoi.size() + option.size();
+            char *end = nullptr;
+            relaxations = static_cast<int>(std::strtol(digits, &end, 10));
+            if (end == digits || *end) return nullptr;
+        }
+        if (relaxations < 0 || relaxations > 16) return nullptr;
+        return std::unique_ptr<MapGenerator>(new VoronoiMapGenerator(relaxations));
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,130 @@
+#ifndef MAPGENERATOR_H
+#define MAPGENERATOR_H
+
+#include "maptopology.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// The parameters HexGrid exposes to QML to generate a board, with the same defaults as Game.qml
+struct MapSettings
+{
+    int width = 60;
+    int height = 40;
+    int numTerritories = 80;
+    int territorySize = 25;
+
+    /// Territories with fewer cells than this are removed after growing them
+    int minCells = 6;
+
+    /// Largest width and height of a board, as cells are addressed with 16-bit coordinates (see HexCoord)
+    static constexpr int MAX_SIDE = 0x7fff;
+
+    /// Largest number of cells of a board, which keeps the cell indices and the memory of the generators small
+    static constexpr int MAX_CELLS = 1 << 22;
+
+    /// Whether the sizes fit the limits above. The generators return nullptr for settings that are not valid, and
+    /// settings received from elsewhere (e.g. the other peer of a network game) must be checked with this
+    bool isValid() const;
+};
+
+/// Called as a map is generated, with the work done so far out of the total (e.g. territories grown out of the
+/// ones requested)
+using MapProgress = std::function<void(int done, int total)>;
+
+/// Territories are started next to each other and grown randomly cell by cell, then the ones that could
+/// not grow enough (or were left apart by removing them) are removed. The same seed always produces the same map. Only plain data is touched, so
+/// HexGrid runs this on a worker thread and creates the items once the map is ready
+std::shared_ptr<const MapTopology> generateGrowthMap(const MapSettings &settings, std::uint64_t seed,
+                                                     const MapProgress &progress = nullptr);
+
+/// This class builds the boards of the games. Every generator only works on plain data and is deterministic:
+/// the same settings and seed always produce the same map, on every machine. The territories that end up with
+/// fewer than MapSettings::minCells cells, or cut off from the largest group of territories, are removed, and
+/// the rest numbered consecutively
+class MapGenerator
+{
+public:
+    virtual ~MapGenerator() = default;
+
+    /// Returns nullptr if the settings are not valid
+    virtual std::shared_ptr<const MapTopology> generate(const MapSettings &settings, std::uint64_t seed,
+                                                        const MapProgress &progress = nullptr) = 0;
+
+    /// Name used to identify the generator in settings and reports, which createMapGenerator accepts back
+    virtual std::string name() const = 0;
+};
+
+/// The original generator of the game (see generateGrowthMap). Territories grow one random cell at a time,
+/// which gives irregular shapes, but finding an empty cell gets slower as the board fills up
+class GrowthMapGenerator final : public MapGenerator
+{
+public:
+    std::shared_ptr<const MapTopology> generate(const MapSettings &settings, std::uint64_t seed,
+                                                const MapProgress &progress = nullptr) override;
+    std::string name() const override;
+};
+
+/// Covers the whole board with square blocks of about territorySize cells, randomly moving the cells on the
+/// edges of the blocks to the block next to them. It ignores numTerritories, and gives very regular boards
+class GridMapGenerator final : public MapGenerator
+{
+public:
+    std::shared_ptr<const MapTopology> generate(const MapSettings &settings, std::uint64_t seed,
+                                                const MapProgress &progress = nullptr) override;
+    std::string name() const override;
+};
+
+/// Places one seed per territory with Poisson-disc sampling, spreading outwards from a random cell so that they
+/// form a single continent, then gives every cell to the nearest seed within reach. A few steps of Lloyd
+/// relaxation (moving every seed to the centroid of its cells) even out the sizes of the territories
+class VoronoiMapGenerator final : public MapGenerator
+{
+    int relaxations_;
+
+    /// Scratch space, kept between maps
+    std::vector<float> seedX_;
+    std::vector<float> seedY_;
+    std::vector<int> bucketHeads_;
+    std::vector<int> bucketNext_;
+    std::vector<double> sums_;
+
+    /// Index of the seed closest to the point within the given distance, or -1 if there is none
+    int nearestSeed(float x, float y, float maxDistance, float bucketSize, int bucketColumns, int bucketRows) const;
+
+public:
+    explicit VoronoiMapGenerator(int relaxations = DEFAULT_RELAXATIONS);
+
+    std::shared_ptr<const MapTopology> generate(const MapSettings &settings, std::uint64_t seed,
+                                                const MapProgress &progress = nullptr) override;
+    std::string name() const override;
+
+    static constexpr int DEFAULT_RELAXATIONS = 2;
+};
+
+/// Drops one seed per territory on a jittered lattice in the middle of the board, then grows all the territories at
+/// once, breadth first, claiming one cell per territory and round until they reach territorySize. Every cell is
+/// visited a constant number of times, so it scales linearly with the size of the board
+class FloodMapGenerator final : public MapGenerator
+{
+    /// Scratch space, kept between maps: the cells each territory can grow into, first to last, and the
+    /// territories still growing
+    std::vector<std::vector<int>> frontiers_;
+    std::vector<std::size_t> frontierHeads_;
+    std::vector<int> sizes_;
+    std::vector<int> growing_;
+
+public:
+    std::shared_ptr<const MapTopology> generate(const MapSettings &settings, std::uint64_t seed,
+                                                const MapProgress &progress = nullptr) override;
+    std::string name() const override;
+};
+
+/// Creates a generator from its name: "growth", "grid", "voronoi" (or "voronoi:relax=N" to choose the steps of
+/// relaxation) or "flood". Returns nullptr if the name is not valid
+std::unique_ptr<MapGenerator> createMapGenerator(const std::string &spec);
+
+#endif // MAPGENERATOR_H
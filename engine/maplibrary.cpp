@@ -0,0 +1,187 @@
+#include "maplibrary.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    constexpr char MAGIC[8] = {'D', 'W', 'M', 'A', 'P', 'L', 'I', 'B'};
+
+    std::size_t align4(std::size_t size)
+    {
+        return (size + 3) & ~static_cast<std::size_t>(3);
+    }
+}
+
+MapLibrary::MapLibrary(const void *data, std::size_t size)
+{
+    if (!data || size < sizeof(FileHeader)) return;
+
+    const auto header = static_cast<const FileHeader *>(data);
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION) return;
+    if (header->width <= 0 || header->height <= 0 || header->width > MapSettings::MAX_SIDE || header->height > MapSettings::MAX_SIDE
+            || static_cast<std::int64_t>(header->width) * header->height > MapSettings::MAX_CELLS) return;
+    if (header->mapCount > (size - sizeof(FileHeader)) / sizeof(std::uint64_t)) return;
+
+    data_ = static_cast<const std::uint8_t *>(data);
+    size_ = size;
+}
+
+bool MapLibrary::isValid() const
+{
+    return data_ != nullptr;
+}
+
+int MapLibrary::mapCount() const
+{
+    return data_ ? static_cast<int>(reinterpret_cast<const FileHeader *>(data_)->mapCount) : 0;
+}
+
+int MapLibrary::width() const
+{
+    return data_ ? reinterpret_cast<const FileHeader *>(data_)->width : 0;
+}
+
+int MapLibrary::height() const
+{
+    return data_ ? reinterpret_cast<const FileHeader *>(data_)->height : 0;
+}
+
+MapSettings MapLibrary::settings() const
+{
+    MapSettings settings;
+    if (!data_) return settings;
+
+    const auto header = reinterpret_cast<const FileHeader *>(data_);
+    settings.width = header->width;
+    settings.height = header->height;
+    settings.numTerritories = header->numTerritories;
+    settings.territorySize = header->territorySize;
+    settings.minCells = header->minCells;
+    return settings;
+}
+
+std::size_t MapLibrary::mapSize(int width, int height, std::size_t territoryCount, std::size_t neighbourCount)
+{
+    return sizeof(MapHeader)
+            + align4(static_cast<std::size_t>(width) * height * sizeof(std::int16_t))
+            + (territoryCount + 1) * sizeof(std::uint32_t)
+            + territoryCount * 2 * sizeof(float)
+            + align4(neighbourCount * sizeof(std::uint16_t));
+}
+
+MapLibrary::Map MapLibrary::map(int index) const
+{
+    Map map;
+    if (index < 0 || index >= mapCount()) return map;
+
+    // Only the data of this map is read, so picking a map does not touch the rest of the file. The sizes are compared
+    // with what is left of the file rather than added to the offset, which could wrap around with a damaged index
+    std::uint64_t offset;
+    std::memcpy(&offset, data_ + sizeof(FileHeader) + static_cast<std::size_t>(index) * sizeof(offset), sizeof(offset));
+    if (offset % 4 != 0 || offset > size_ - sizeof(MapHeader)) return map;
+
+    const auto header = reinterpret_cast<const MapHeader *>(data_ + offset);
+    const auto available = size_ - static_cast<std::size_t>(offset);
+    if (header->territoryCount > static_cast<std::uint32_t>(MapTopology::MAX_TERRITORIES)) return map;
+    if (header->neighbourCount > available / sizeof(std::uint16_t)) return map;
+    if (mapSize(width(), height(), header->territoryCount, header->neighbourCount) > available) return map;
+
+    auto position = data_ + offset + sizeof(MapHeader);
+    map.territoryCount = static_cast<int>(header->territoryCount);
+    map.cells = reinterpret_cast<const std::int16_t *>(position);
+    position += align4(static_cast<std::size_t>(width()) * height() * sizeof(std::int16_t));
+    map.neighbourOffsets = reinterpret_cast<const std::uint32_t *>(position);
+    position += (header->territoryCount + 1) * sizeof(std::uint32_t);
+    map.centers = reinterpret_cast<const float *>(position);
+    position += header->territoryCount * 2 * sizeof(float);
+    map.neighbours = reinterpret_cast<const std::uint16_t *>(position);
+
+    // The lists must not reach past the neighbours of the record
+    if (map.neighbourOffsets[map.territoryCount] != header->neighbourCount) return Map();
+    return map;
+}
+
+std::shared_ptr<const MapTopology> MapLibrary::topology(int index) const
+{
+    const auto map = this->map(index);
+    if (!map.isValid()) return nullptr;
+
+    // The adjacency and the centers stored are used as they are; only a damaged or edited map is rejected
+    std::vector<std::int16_t> cells(map.cells, map.cells + static_cast<std::size_t>(width()) * height());
+    return MapTopology::fromCells(width(), height(), std::move(cells), map.territoryCount, map.neighbourOffsets,
+                                  map.neighbours, map.centers);
+}
+
+bool MapLibrary::write(const std::string &fileName, const MapSettings &settings, const std::vector<std::shared_ptr<const MapTopology>> &maps)
+{
+    FileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.mapCount = static_cast<std::uint32_t>(maps.size());
+    header.width = settings.width;
+    header.height = settings.height;
+    header.numTerritories = settings.numTerritories;
+    header.territorySize = settings.territorySize;
+    header.minCells = settings.minCells;
+
+    // Calculating where every map will be before writing anything
+    std::vector<std::uint64_t> offsets;
+    offsets.reserve(maps.size());
+    std::uint64_t offset = align4(sizeof(FileHeader) + maps.size() * sizeof(std::uint64_t));
+    for (const auto &map : maps)
+    {
+        if (!map || map->width() != settings.width || map->height() != settings.height) return false;
+
+        std::size_t neighbourCount = 0;
+        for (auto terr = 0; terr < map->territoryCount(); terr++) neighbourCount += map->neighbours(terr).size();
+
+        offsets.push_back(offset);
+        offset += mapSize(settings.width, settings.height, map->territoryCount(), neighbourCount);
+    }
+
+    auto file = std::fopen(fileName.c_str(), "wb");
+    if (!file) return false;
+
+    const std::uint32_t padding = 0;
+    auto ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    if (!offsets.empty()) ok = ok && std::fwrite(offsets.data(), sizeof(std::uint64_t), offsets.size(), file) == offsets.size();
+    const auto headerSize = sizeof(FileHeader) + maps.size() * sizeof(std::uint64_t);
+    ok = ok && std::fwrite(&padding, 1, align4(headerSize) - headerSize, file) == align4(headerSize) - headerSize;
+
+    std::vector<std::uint32_t> neighbourOffsets;
+    std::vector<std::uint16_t> neighbours;
+    std::vector<float> centers;
+    for (const auto &map : maps)
+    {
+        neighbourOffsets.assign(1, 0);
+        neighbours.clear();
+        centers.clear();
+        for (auto terr = 0; terr < map->territoryCount(); terr++)
+        {
+            const auto list = map->neighbours(terr);
+            neighbours.insert(neighbours.end(), list.begin(), list.end());
+            neighbourOffsets.push_back(static_cast<std::uint32_t>(neighbours.size()));
+            centers.push_back(map->center(terr).x);
+            centers.push_back(map->center(terr).y);
+        }
+
+        MapHeader mapHeader;
+        mapHeader.territoryCount = static_cast<std::uint32_t>(map->territoryCount());
+        mapHeader.neighbourCount = static_cast<std::uint32_t>(neighbours.size());
+
+        const auto &cells = map->cellTerritories();
+        const auto cellBytes = cells.size() * sizeof(std::int16_t);
+        const auto neighbourBytes = neighbours.size() * sizeof(std::uint16_t);
+
+        ok = ok && std::fwrite(&mapHeader, sizeof(mapHeader), 1, file) == 1;
+        ok = ok && std::fwrite(cells.data(), 1, cellBytes, file) == cellBytes;
+        ok = ok && std::fwrite(&padding, 1, align4(cellBytes) - cellBytes, file) == align4(cellBytes) - cellBytes;
+        ok = ok && std::fwrite(neighbourOffsets.data(), sizeof(std::uint32_t), neighbourOffsets.size(), file) == neighbourOffsets.size();
+        ok = ok && std::fwrite(centers.data(), sizeof(float), centers.size(), file) == centers.size();
+        ok = ok && std::fwrite(neighbours.data(), 1, neighbourBytes, file) == neighbourBytes;
+        ok = ok && std::fwrite(&padding, 1, align4(neighbourBytes) - neighbourBytes, file) == align4(neighbourBytes) - neighbourBytes;
+    }
+
+    return std::fclose(file) == 0 && ok;
+}
@@ -0,0 +1,97 @@
+#ifndef MAPLIBRARY_H
+#define MAPLIBRARY_H
+
+#include "mapgenerator.h"
+#include "maptopology.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Read-only view over a file with many pregenerated maps of the same size, so a new game can pick one
+/// in O(1) instead of generating it. The view does not copy anything: the data is meant to be a memory
+/// mapped file, so only the pages of the maps actually used are ever read from disk.
+///
+/// Layout (little endian, every section 4-byte aligned):
+///   header: magic, version, map count, MapSettings the maps were generated with
+///   offsets: position of each map from the start of the file (64-bit)
+///   each map: territory count, neighbour count, territory of each cell (16-bit, row by row),
+///             neighbour offsets (territory count + 1, 32-bit), centers (x and y floats, in board
+///             coordinates for cells with a radius of 1), neighbours (16-bit)
+class MapLibrary
+{
+public:
+    /// Pointers to the data of one map inside the library
+    struct Map
+    {
+        int territoryCount = 0;
+        const std::int16_t *cells = nullptr;
+
+        /// The neighbours of territory i go from neighbours[neighbourOffsets[i]] to neighbours[neighbourOffsets[i + 1]]
+        const std::uint32_t *neighbourOffsets = nullptr;
+        const std::uint16_t *neighbours = nullptr;
+
+        /// x and y of each territory, one after another
+        const float *centers = nullptr;
+
+        bool isValid() const { return cells != nullptr; }
+    };
+
+    MapLibrary() = default;
+
+    /// The data must stay alive while the library is used. If it is not a valid library, isValid() will
+    /// return false
+    MapLibrary(const void *data, std::size_t size);
+
+    bool isValid() const;
+
+    int mapCount() const;
+    int width() const;
+    int height() const;
+
+    /// The settings the maps were generated with, so the caller can check they match the requested board
+    MapSettings settings() const;
+
+    /// Returns an invalid map if the index is out of range or the record of the map does not fit in the data. The
+    /// values inside the record are not checked here; topology() checks them as it builds the map
+    Map map(int index) const;
+
+    /// Builds a MapTopology for the engine from one of the maps, with the adjacency and the centers stored in the
+    /// library, or returns nullptr if the data of the map is not valid
+    std::shared_ptr<const MapTopology> topology(int index) const;
+
+    /// Writes a library with the given maps, which must all have the size in the settings
+    static bool write(const std::string &fileName, const MapSettings &settings, const std::vector<std::shared_ptr<const MapTopology>> &maps);
+
+    static constexpr std::uint32_t VERSION = 1;
+
+private:
+    struct FileHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t mapCount;
+        std::int32_t width;
+        std::int32_t height;
+        std::int32_t numTerritories;
+        std::int32_t territorySize;
+        std::int32_t minCells;
+        std::uint32_t reserved;
+    };
+
+    struct MapHeader
+    {
+        std::uint32_t territoryCount;
+        std::uint32_t neighbourCount;
+    };
+
+    /// Size of a map record with the given counts, including the padding
+    static std::size_t mapSize(int width, int height, std::size_t territoryCount, std::size_t neighbourCount);
+
+    const std::uint8_t *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+#endif // MAPLIBRARY_H
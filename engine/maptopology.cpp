@@ -0,0 +1,176 @@
+#include "maptopology.h"
+
+#include "hexcoord.h"
+
+#include <algorithm>
+#include <cmath>
+
+std::shared_ptr<const MapTopology> MapTopology::fromCells(int width, int height, std::vector<std::int16_t> cellTerritories)
+{
+    if (width <= 0 || height <= 0 || cellTerritories.size() != static_cast<std::size_t>(width) * height) return nullptr;
+
+    std::shared_ptr<MapTopology> map(new MapTopology());
+    map->width_ = width;
+    map->height_ = height;
+
+    for (auto terr : cellTerritories)
+    {
+        if (terr >= map->territoryCount_) map->territoryCount_ = terr + 1;
+    }
+
+    const auto count = map->territoryCount_;
+    map->cellCounts_.assign(count, 0);
+    map->centers_.assign(count, Point());
+
+    // Every pair of adjacent cells from different territories adds a (possibly repeated) edge
+    std::vector<std::vector<std::uint16_t>> adjacency(count);
+    for (auto y = 0; y < height; y++)
+    {
+        for (auto x = 0; x < width; x++)
+        {
+            const auto terr = cellTerritories[y * width + x];
+            if (terr < 0) continue;
+
+            const auto cell = HexCoord::fromOffset(x, y);
+            map->cellCounts_[terr]++;
+            map->centers_[terr].x += cell.centerX<float>();
+            map->centers_[terr].y += cell.centerY<float>();
+
+            for (auto direction = 0; direction < HexCoord::DIRECTION_COUNT; direction++)
+            {
+                const auto neighbour = cell.neighbour(direction);
+                if (!neighbour.isInside(width, height)) continue;
+
+                const auto other = cellTerritories[neighbour.index(width)];
+                if (other >= 0 && other != terr) adjacency[terr].push_back(static_cast<std::uint16_t>(other));
+            }
+        }
+    }
+
+    map->neighbourOffsets_.reserve(count + 1);
+    map->neighbourOffsets_.push_back(0);
+    for (auto terr = 0; terr < count; terr++)
+    {
+        auto &list = adjacency[terr];
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+        map->neighbours_.insert(map->neighbours_.end(), list.begin(), list.end());
+        map->neighbourOffsets_.push_back(static_cast<int>(map->neighbours_.size()));
+
+        if (map->cellCounts_[terr] > 0)
+        {
+            map->centers_[terr].x /= map->cellCounts_[terr];
+            map->centers_[terr].y /= map->cellCounts_[terr];
+        }
+    }
+
+    map->cellTerritories_ = std::move(cellTerritories);
+    return map;
+}
+
+std::shared_ptr<const MapTopology> MapTopology::fromCells(int width, int height, std::vector<std::int16_t> cellTerritories,
+                                                         int territoryCount, const std::uint32_t *neighbourOffsets,
+                                                         const std::uint16_t *neighbours, const float *centers)
+{
+    if (width <= 0 || height <= 0 || cellTerritories.size() != static_cast<std::size_t>(width) * height) return nullptr;
+    if (territoryCount < 0 || territoryCount > MAX_TERRITORIES || neighbourOffsets[0] != 0) return nullptr;
+
+    std::shared_ptr<MapTopology> map(new MapTopology());
+    map->width_ = width;
+    map->height_ = height;
+    map->territoryCount_ = territoryCount;
+
+    map->cellCounts_.assign(territoryCount, 0);
+    for (auto terr : cellTerritories)
+    {
+        if (terr >= territoryCount) return nullptr;
+        if (terr >= 0) map->cellCounts_[terr]++;
+    }
+
+    // The lists must be the ones fromCells gives: AttackCandidates, for instance, looks the reverse of every pair up
+    // with a binary search
+    map->neighbourOffsets_.assign(neighbourOffsets, neighbourOffsets + territoryCount + 1);
+    for (auto terr = 0; terr < territoryCount; terr++)
+    {
+        if (map->cellCounts_[terr] == 0 || neighbourOffsets[terr] > neighbourOffsets[terr + 1]) return nullptr;
+    }
+    map->neighbours_.assign(neighbours, neighbours + neighbourOffsets[territoryCount]);
+    for (auto terr = 0; terr < territoryCount; terr++)
+    {
+        const auto list = map->neighbours(terr);
+        for (auto i = 0; i < list.size(); i++)
+        {
+            if (list[i] >= territoryCount || list[i] == terr || (i > 0 && list[i] <= list[i - 1])) return nullptr;
+        }
+    }
+    for (auto terr = 0; terr < territoryCount; terr++)
+    {
+        for (auto other : map->neighbours(terr))
+        {
+            const auto reverse = map->neighbours(other);
+            if (!std::binary_search(reverse.begin(), reverse.end(), static_cast<std::uint16_t>(terr))) return nullptr;
+        }
+    }
+
+    map->centers_.resize(territoryCount);
+    for (auto terr = 0; terr < territoryCount; terr++)
+    {
+        map->centers_[terr].x = centers[terr * 2];
+        map->centers_[terr].y = centers[terr * 2 + 1];
+        if (!std::isfinite(map->centers_[terr].x) || !std::isfinite(map->centers_[terr].y)) return nullptr;
+    }
+
+    map->cellTerritories_ = std::move(cellTerritories);
+    return map;
+}
+
+int MapTopology::width() const
+{
+    return width_;
+}
+
+int MapTopology::height() const
+{
+    return height_;
+}
+
+int MapTopology::territoryCount() const
+{
+    return territoryCount_;
+}
+
+int MapTopology::cellTerritory(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= width_ || y >= height_) return -1;
+    return cellTerritories_[y * width_ + x];
+}
+
+const std::vector<std::int16_t>& MapTopology::cellTerritories() const
+{
+    return cellTerritories_;
+}
+
+int MapTopology::cellCount(int territory) const
+{
+    return cellCounts_[territory];
+}
+
+MapTopology::Neighbours MapTopology::neighbours(int territory) const
+{
+    const auto data = neighbours_.data();
+    return Neighbours(data + neighbourOffsets_[territory], data + neighbourOffsets_[territory + 1]);
+}
+
+bool MapTopology::adjacent(int territory, int other) const
+{
+    for (auto neighbour : neighbours(territory))
+    {
+        if (neighbour == other) return true;
+    }
+    return false;
+}
+
+MapTopology::Point MapTopology::center(int territory) const
+{
+    return centers_[territory];
+}
@@ -0,0 +1,90 @@
+#ifndef MAPTOPOLOGY_H
+#define MAPTOPOLOGY_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// This class describes the parts of a board that never change during a game: which territory each hex
+/// cell belongs to, which territories are adjacent and where their centers are. It is immutable, so
+/// every GameState played on the same board shares a single instance. It is only ever created by fromCells,
+/// so code handed a reference can take shared ownership of it with shared_from_this()
+class MapTopology : public std::enable_shared_from_this<MapTopology>
+{
+public:
+    /// Simple view over the neighbours of a territory, so that they can be iterated with a range for loop
+    class Neighbours
+    {
+        const std::uint16_t *begin_;
+        const std::uint16_t *end_;
+
+    public:
+        Neighbours(const std::uint16_t *begin, const std::uint16_t *end) : begin_(begin), end_(end) {}
+
+        const std::uint16_t *begin() const { return begin_; }
+        const std::uint16_t *end() const { return end_; }
+        int size() const { return static_cast<int>(end_ - begin_); }
+        std::uint16_t operator[](int index) const { return begin_[index]; }
+    };
+
+    struct Point
+    {
+        float x = 0;
+        float y = 0;
+    };
+
+    /// Builds the topology from the territory of each cell, given row by row in offset coordinates (odd
+    /// rows shifted half a cell to the right, like in HexGrid). Territories are numbered from 0, and cells
+    /// with a negative value are not part of any territory. Returns nullptr if the input is not valid
+    static std::shared_ptr<const MapTopology> fromCells(int width, int height, std::vector<std::int16_t> cellTerritories);
+
+    /// Same as above, with the adjacency and the centers worked out before by fromCells (e.g. stored in a MapLibrary)
+    /// instead of going through the neighbours of every cell again. The neighbours of territory i go from
+    /// neighbours[neighbourOffsets[i]] to neighbours[neighbourOffsets[i + 1]], and centers holds the x and y of each
+    /// territory one after another. Returns nullptr if a cell is outside the territories, a territory has no cell,
+    /// or the adjacency lists are not sorted, without repeats and symmetric
+    static std::shared_ptr<const MapTopology> fromCells(int width, int height, std::vector<std::int16_t> cellTerritories,
+                                                        int territoryCount, const std::uint32_t *neighbourOffsets,
+                                                        const std::uint16_t *neighbours, const float *centers);
+
+    int width() const;
+    int height() const;
+
+    int territoryCount() const;
+
+    /// The territory of the cell at the given offset coordinates, or -1 if it does not belong to any
+    int cellTerritory(int x, int y) const;
+    const std::vector<std::int16_t>& cellTerritories() const;
+
+    /// Number of cells the territory is made of
+    int cellCount(int territory) const;
+
+    Neighbours neighbours(int territory) const;
+    bool adjacent(int territory, int other) const;
+
+    /// Center of the territory, in board coordinates for cells with a radius of 1
+    Point center(int territory) const;
+
+    /// Territory indices are stored as 16-bit values, with -1 for cells without territory
+    static constexpr int MAX_TERRITORIES = 0x7fff;
+
+private:
+    MapTopology() = default;
+
+    int width_ = 0;
+    int height_ = 0;
+    int territoryCount_ = 0;
+
+    std::vector<std::int16_t> cellTerritories_;
+
+    std::vector<int> cellCounts_;
+
+    /// Adjacency lists of all the territories one after another. The ones of territory i go from
+    /// neighbourOffsets_[i] to neighbourOffsets_[i + 1]
+    std::vector<int> neighbourOffsets_;
+    std::vector<std::uint16_t> neighbours_;
+
+    std::vector<Point> centers_;
+};
+
+#endif // MAPTOPOLOGY_H
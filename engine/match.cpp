@@ -0,0 +1,142 @@
+#include "match.h"
+
+#include "gametelemetry.h"
+#include "policy.h"
+
+#include <algorithm>
+
+Match::Match(std::shared_ptr<const MapTopology> map)
+    : map_(std::move(map)), arena_(map_, 1), candidates_(map_)
+{
+    state_ = arena_.allocate();
+}
+
+MatchResult Match::play(const std::vector<Policy *> &policies, std::uint64_t seed)
+{
+    start(policies, seed);
+    while (step()) {}
+    return result_;
+}
+
+void Match::start(const std::vector<Policy *> &policies, std::uint64_t seed)
+{
+    policies_ = policies;
+    const auto playerCount = static_cast<int>(policies_.size());
+    state_.setup(playerCount, seed);
+    candidates_.reset(state_);
+    for (auto policy : policies_) policy->setCandidates(&candidates_);
+
+    result_ = MatchResult();
+    result_.placements.assign(playerCount, 0);
+
+    // Players are placed from the last position as they are eliminated
+    nextPlacement_ = state_.playersLeft() - 1;
+    alive_.resize(playerCount);
+    for (auto player = 0; player < playerCount; player++) alive_[player] = state_.ownedTerritories(player) > 0;
+
+    finished_ = false;
+    if (state_.playersLeft() <= 1) finish();
+}
+
+bool Match::step()
+{
+    if (finished_) return false;
+
+    const auto player = state_.playerTurn();
+    auto policy = policies_[player];
+
+    int from, to;
+    auto captures = 0;
+    for (auto attack = 0; attack < MAX_ATTACKS_PER_TURN && policy->chooseAttack(state_, from, to); attack++)
+    {
+        if (!state_.canAttack(from, to)) break;
+
+        if (observer_) observer_(state_, from, to);
+
+        const auto defender = state_.owner(to);
+        const auto attackDice = state_.numDice(from);
+        const auto defenseDice = state_.numDice(to);
+        AttackUndo undo;
+        const auto captured = state_.makeAttack(from, to, undo);
+        candidates_.update(state_, undo);
+        result_.attacks++;
+        captures += captured;
+        if (telemetry_) telemetry_->recordAttack(attackDice, defenseDice, captured);
+
+        if (alive_[defender] && state_.ownedTerritories(defender) == 0)
+        {
+            alive_[defender] = false;
+            result_.placements[defender] = nextPlacement_--;
+            if (telemetry_) telemetry_->recordElimination(result_.turns);
+        }
+        if (state_.playersLeft() <= 1)
+        {
+            // The winning turn never ends, so it gives no dice
+            if (telemetry_) telemetry_->recordTurn(captures, 0, 0, 0);
+            finish();
+            return false;
+        }
+    }
+
+    if (observer_) observer_(state_, -1, -1);
+
+    const auto remainingBefore = state_.remainingDice(player);
+    const auto income = state_.connectedTerritories(player);
+    TurnUndo undo;
+    state_.makeEndTurn(undo);
+    candidates_.update(state_, undo);
+    result_.turns++;
+    if (telemetry_) telemetry_->recordTurn(captures, remainingBefore, income, state_.remainingDice(player));
+
+    if (result_.turns >= MAX_TURNS)
+    {
+        finish();
+        return false;
+    }
+    return true;
+}
+
+void Match::finish()
+{
+    // The players still alive take the best placements, ordered by territories
+    std::vector<int> survivors;
+    for (auto player = 0; player < static_cast<int>(alive_.size()); player++)
+    {
+        if (alive_[player]) survivors.push_back(player);
+    }
+    std::stable_sort(survivors.begin(), survivors.end(), [this](int a, int b)
+    {
+        return state_.ownedTerritories(a) > state_.ownedTerritories(b);
+    });
+    for (auto i = 0; i < static_cast<int>(survivors.size()); i++) result_.placements[survivors[i]] = i;
+
+    if (survivors.size() == 1) result_.winner = survivors.front();
+    finished_ = true;
+
+    if (telemetry_) telemetry_->recordGame(result_.turns, result_.winner >= 0);
+}
+
+bool Match::finished() const
+{
+    return finished_;
+}
+
+void Match::setObserver(MoveObserver observer)
+{
+    observer_ = std::move(observer);
+}
+
+void Match::setTelemetry(GameTelemetry *telemetry)
+{
+    telemetry_ = telemetry;
+}
+
+const MatchResult &Match::result() const
+{
+    return result_;
+}
+
+const GameState &Match::state() const
+{
+    return state_;
+}
@@ -0,0 +1,100 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include "attackcandidates.h"
+#include "gamestate.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class GameTelemetry;
+class Policy;
+
+/// Outcome of a game played by AI policies
+struct MatchResult
+{
+    /// Position of each player at the end: 0 for the winner, 1 for the last one eliminated, etc. Players
+    /// still alive when the turn limit is reached are ranked by their number of territories
+    std::vector<int> placements;
+
+    /// Player that won, or -1 if the turn limit was reached with several players left
+    int winner = -1;
+
+    /// Number of turns played
+    int turns = 0;
+
+    /// Number of attacks performed
+    int attacks = 0;
+};
+
+/// Plays a whole game on the given map with one policy per player, without any delays or animations. The
+/// game can either be played at once with play(), or turn by turn with start() and step(), so that many
+/// games can be interleaved on the same threads
+class Match
+{
+public:
+    /// Called with the state right before each move is made: an attack from one territory to another, or the
+    /// end of the turn, with from and to set to -1
+    using MoveObserver = std::function<void(const GameState &state, int from, int to)>;
+
+private:
+    std::shared_ptr<const MapTopology> map_;
+    StateArena arena_;
+    GameState state_;
+
+    /// Kept up to date after every move and handed to the policies, so they do not scan the board
+    AttackCandidates candidates_;
+
+    std::vector<Policy *> policies_;
+    MatchResult result_;
+    MoveObserver observer_;
+    GameTelemetry *telemetry_ = nullptr;
+
+    /// Players still owning some territory, and the placement for the next one to be eliminated
+    std::vector<bool> alive_;
+    int nextPlacement_ = 0;
+
+    bool finished_ = true;
+
+    /// Fills the placements of the players still alive once the game is over
+    void finish();
+
+public:
+    explicit Match(std::shared_ptr<const MapTopology> map);
+
+    /// Plays a game from the beginning. The seed determines the initial dice, the first player and all the
+    /// rolls, so the same seed and policies always give the same game
+    MatchResult play(const std::vector<Policy *> &policies, std::uint64_t seed);
+
+    /// Sets up a new game without playing any turn. The policies must stay alive until the game finishes
+    void start(const std::vector<Policy *> &policies, std::uint64_t seed);
+
+    /// Plays the turn of the current player. Returns false once the game is over
+    bool step();
+
+    bool finished() const;
+
+    /// Lets the caller see every position of the games played from now on, e.g. to record them. The observer
+    /// runs on the thread playing the game, so it should be quick
+    void setObserver(MoveObserver observer);
+
+    /// Counts the attacks, turns and eliminations of the games played from now on into the telemetry, which
+    /// must outlive them. Matches played on the same thread can share it, but not matches on different ones
+    void setTelemetry(GameTelemetry *telemetry);
+
+    /// The result of the game, which is only complete once it has finished
+    const MatchResult &result() const;
+
+    /// The state as it was left by the last turn
+    const GameState &state() const;
+
+    /// Games where nobody wins after this many turns end in a draw
+    static constexpr int MAX_TURNS = 2000;
+
+    /// Safety limit, in case a policy keeps choosing attacks that are not legal
+    static constexpr int MAX_ATTACKS_PER_TURN = 1000;
+};
+
+#endif // MATCH_H
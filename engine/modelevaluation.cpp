@@ -0,0 +1,303 @@
+#include "modelevaluation.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MODEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compiles AVX2 intrinsics anywhere, while GCC and Clang need the functions using them to be marked
+#if defined(MODEL_X86) && !defined(_MSC_VER)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace
+{
+    constexpr int FEATURES = ModelEvaluator::FEATURES;
+
+    /// Rows are processed 8 at a time by the widest kernel, so they are padded to a multiple of it
+    constexpr std::size_t ROW_ALIGNMENT = 8;
+
+    /// The hand-tuned weights, as output weights of a hidden unit per feature that just passes it through.
+    /// All the features are positive, so the ReLU does not change them
+    constexpr float DEFAULT_WEIGHTS[FEATURES] = {0.4f, -0.1f, 0.8f, -0.2f, -0.2f, -0.4f, 6.0f, -2.0f};
+
+    /// Computes out[row] for rows [0, rows), which must be a multiple of the width of the kernel
+    using KernelFunction = void (*)(int hidden, const float (*weights)[FEATURES], const float *bias, const float *output,
+                                    const float *features, std::size_t stride, std::size_t rows, float *out);
+
+    void runScalar(int hidden, const float (*weights)[FEATURES], const float *bias, const float *output,
+                   const float *features, std::size_t stride, std::size_t rows, float *out)
+    {
+        for (std::size_t row = 0; row < rows; row++)
+        {
+            auto sum = 0.0f;
+            for (auto h = 0; h < hidden; h++)
+            {
+                auto acc = bias[h];
+                for (auto f = 0; f < FEATURES; f++) acc += weights[h][f] * features[f * stride + row];
+                sum += output[h] * std::max(acc, 0.0f);
+            }
+            out[row] = sum;
+        }
+    }
+
+#ifdef MODEL_X86
+    void runSse(int hidden, const float (*weights)[FEATURES], const float *bias, const float *output,
+                const float *features, std::size_t stride, std::size_t rows, float *out)
+    {
+        const auto zero = _mm_setzero_ps();
+        for (std::size_t row = 0; row < rows; row += 4)
+        {
+            __m128 x[FEATURES];
+            for (auto f = 0; f < FEATURES; f++) x[f] = _mm_loadu_ps(features + f * stride + row);
+
+            auto sum = zero;
+            for (auto h = 0; h < hidden; h++)
+            {
+                auto acc = _mm_set1_ps(bias[h]);
+                for (auto f = 0; f < FEATURES; f++) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[h][f]), x[f]));
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(output[h]), _mm_max_ps(acc, zero)));
+            }
+            _mm_storeu_ps(out + row, sum);
+        }
+    }
+
+    TARGET_AVX2 void runAvx2(int hidden, const float (*weights)[FEATURES], const float *bias, const float *output,
+                             const float *features, std::size_t stride, std::size_t rows, float *out)
+    {
+        const auto zero = _mm256_setzero_ps();
+        for (std::size_t row = 0; row < rows; row += 8)
+        {
+            __m256 x[FEATURES];
+            for (auto f = 0; f < FEATURES; f++) x[f] = _mm256_loadu_ps(features + f * stride + row);
+
+            auto sum = zero;
+            for (auto h = 0; h < hidden; h++)
+            {
+                auto acc = _mm256_set1_ps(bias[h]);
+                for (auto f = 0; f < FEATURES; f++) acc = _mm256_fmadd_ps(_mm256_set1_ps(weights[h][f]), x[f], acc);
+                sum = _mm256_fmadd_ps(_mm256_set1_ps(output[h]), _mm256_max_ps(acc, zero), sum);
+            }
+            _mm256_storeu_ps(out + row, sum);
+        }
+    }
+
+    bool supportsAvx2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        const auto fma = (info[2] & (1 << 12)) != 0;
+        const auto osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return fma && osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+#endif
+
+    KernelFunction kernelFunction(ModelEvaluator::Kernel kernel)
+    {
+        switch (kernel)
+        {
+#ifdef MODEL_X86
+        case ModelEvaluator::Kernel::Avx2: return runAvx2;
+        case ModelEvaluator::Kernel::Sse: return runSse;
+#endif
+        default: return runScalar;
+        }
+    }
+}
+
+ModelEvaluator::ModelEvaluator()
+    : kernel_(bestKernel())
+{
+    hidden_ = FEATURES;
+    for (auto h = 0; h < hidden_; h++)
+    {
+        for (auto f = 0; f < FEATURES; f++) hiddenWeights_[h][f] = h == f ? 1.0f : 0.0f;
+        hiddenBias_[h] = 0;
+        outputWeights_[h] = DEFAULT_WEIGHTS[h];
+    }
+}
+
+bool ModelEvaluator::load(const std::string &fileName)
+{
+    auto file = std::fopen(fileName.c_str(), "r");
+    if (!file) return false;
+
+    // Everything is read into a copy first, so a damaged file leaves the current weights untouched
+    char magic[32] = {};
+    int version = 0, hidden = 0;
+    auto ok = std::fscanf(file, "%31s %d hidden %d", magic, &version, &hidden) == 3
+            && !std::strcmp(magic, "dicewars-model") && version == 1 && hidden >= 1 && hidden <= MAX_HIDDEN;
+
+    float weights[MAX_HIDDEN][FEATURES], bias[MAX_HIDDEN], output[MAX_HIDDEN], outputBias = 0;
+    for (auto h = 0; ok && h < hidden; h++)
+    {
+        for (auto f = 0; ok && f < FEATURES; f++) ok = std::fscanf(file, "%f", &weights[h][f]) == 1;
+        ok = ok && std::fscanf(file, "%f", &bias[h]) == 1;
+    }
+    for (auto h = 0; ok && h < hidden; h++) ok = std::fscanf(file, "%f", &output[h]) == 1;
+    ok = ok && std::fscanf(file, "%f", &outputBias) == 1;
+    std::fclose(file);
+    if (!ok) return false;
+
+    hidden_ = hidden;
+    std::memcpy(hiddenWeights_, weights, sizeof(weights));
+    std::memcpy(hiddenBias_, bias, sizeof(bias));
+    std::memcpy(outputWeights_, output, sizeof(output));
+    outputBias_ = outputBias;
+    return true;
+}
+
+ModelEvaluator::Kernel ModelEvaluator::bestKernel()
+{
+#ifdef MODEL_X86
+    static const auto best = supportsAvx2() ? Kernel::Avx2 : Kernel::Sse;
+    return best;
+#else
+    return Kernel::Scalar;
+#endif
+}
+
+bool ModelEvaluator::setKernel(Kernel kernel)
+{
+    if (kernel > bestKernel()) return false;
+    kernel_ = kernel;
+    return true;
+}
+
+ModelEvaluator::Kernel ModelEvaluator::kernel() const
+{
+    return kernel_;
+}
+
+void ModelEvaluator::evaluate(const GameState *states, int count, int player, float *values)
+{
+    if (count <= 0) return;
+
+    const auto territories = static_cast<std::size_t>(states[0].territoryCount());
+    const auto rows = territories * count;
+    stride_ = (rows + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+
+    // The padding rows are evaluated too, but never added to any position
+    if (features_.size() < FEATURES * stride_) features_.resize(FEATURES * stride_);
+    outputs_.resize(stride_);
+    for (auto i = 0; i < count; i++) extractFeatures(states[i], player, i * territories);
+
+    kernelFunction(kernel_)(hidden_, hiddenWeights_, hiddenBias_, outputWeights_, features_.data(), stride_, stride_, outputs_.data());
+
+    for (auto i = 0; i < count; i++)
+    {
+        auto value = outputBias_;
+        const auto out = outputs_.data() + i * territories;
+        for (std::size_t terr = 0; terr < territories; terr++) value += out[terr];
+        values[i] = value;
+    }
+}
+
+float ModelEvaluator::evaluate(const GameState &state, int player)
+{
+    float value;
+    evaluate(&state, 1, player, &value);
+    return value;
+}
+
+void ModelEvaluator::extractFeatures(const GameState &state, int player, std::size_t row)
+{
+    const auto count = state.territoryCount();
+    const auto owners = state.ownerData();
+    const auto dice = state.diceData();
+
+    // The adjacency is copied once per map, so it is read without calling into MapTopology
+    if (&state.map() != map_.get())
+    {
+        map_ = state.map().shared_from_this();
+        neighbourOffsets_.assign(1, 0);
+        neighbours_.clear();
+        for (auto terr = 0; terr < count; terr++)
+        {
+            const auto list = map_->neighbours(terr);
+            neighbours_.insert(neighbours_.end(), list.begin(), list.end());
+            neighbourOffsets_.push_back(static_cast<int>(neighbours_.size()));
+        }
+    }
+    const auto offsets = neighbourOffsets_.data();
+    const auto neighbours = neighbours_.data();
+
+    // Labelling the regions of territories of the same owner, with a flood fill from every unlabelled one
+    regions_.assign(count, -1);
+    regionSizes_.clear();
+    stack_.resize(count);
+    for (auto first = 0; first < count; first++)
+    {
+        const auto owner = owners[first];
+        if (regions_[first] >= 0 || owner == GameState::NO_OWNER) continue;
+
+        const auto region = static_cast<int>(regionSizes_.size());
+        regions_[first] = region;
+        auto size = 0, top = 0;
+        stack_[top++] = first;
+        while (top > 0)
+        {
+            const auto terr = stack_[--top];
+            size++;
+            for (auto i = offsets[terr]; i < offsets[terr + 1]; i++)
+            {
+                const auto neighbour = neighbours[i];
+                if (regions_[neighbour] >= 0 || owners[neighbour] != owner) continue;
+                regions_[neighbour] = region;
+                stack_[top++] = neighbour;
+            }
+        }
+        regionSizes_.push_back(size);
+    }
+
+    // Every feature of every territory is written, so the buffer never needs to be cleared. The owner of a
+    // territory is as good as random for the branch predictor, so the features are calculated for every
+    // territory and masked instead of branching on it
+    float *columns[FEATURES];
+    for (auto f = 0; f < FEATURES; f++) columns[f] = features_.data() + f * stride_ + row;
+    const auto diceScale = 1.0f / GameState::MAX_DICE;
+    const auto regionScale = 1.0f / count;
+
+    for (auto terr = 0; terr < count; terr++)
+    {
+        const auto owner = owners[terr];
+        const auto mine = static_cast<float>(owner == player);
+        const auto enemy = static_cast<float>(owner != player && owner != GameState::NO_OWNER);
+
+        auto enemies = 0, strongest = 0;
+        for (auto i = offsets[terr]; i < offsets[terr + 1]; i++)
+        {
+            const auto other = owners[neighbours[i]];
+            const auto isEnemy = other != player && other != GameState::NO_OWNER;
+            enemies += isEnemy;
+            strongest = std::max(strongest, isEnemy ? dice[neighbours[i]] : 0);
+        }
+
+        const auto numDice = dice[terr] * diceScale;
+        const auto region = regions_[terr] >= 0 ? regionSizes_[regions_[terr]] * regionScale : 0.0f;
+        const auto neighbourCount = offsets[terr + 1] - offsets[terr];
+
+        columns[Mine][terr] = mine;
+        columns[Enemy][terr] = enemy;
+        columns[MyDice][terr] = mine * numDice;
+        columns[EnemyDice][terr] = enemy * numDice;
+        columns[Exposure][terr] = neighbourCount ? mine * enemies / neighbourCount : 0.0f;
+        columns[Threat][terr] = mine * strongest * diceScale;
+        columns[MyRegion][terr] = mine * region;
+        columns[EnemyRegion][terr] = enemy * region;
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef MODELEVALUATION_H
+#define MODELEVALUATION_H
+
+#include "gamestate.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Evaluation learned offline (e.g. from the positions recorded by the selfplay tool) or tuned by hand. Every
+/// territory is described by the same few features, seen from the player evaluated, and goes through a
+/// small network shared by all of them: one hidden layer with ReLU and a single output. The value of the
+/// position is the sum of the outputs of its territories.
+///
+/// Many positions are evaluated at once, with the territories of all of them laid out one feature after
+/// another, so the network runs over 8 territories per instruction with AVX2 (4 with SSE). Searches should
+/// collect the positions they need to evaluate and call evaluate() once for all of them.
+///
+/// Weights file (text, numbers separated by whitespace):
+///   dicewars-model 1
+///   hidden <count>
+///   for each hidden unit: FEATURES weights, then its bias
+///   one output weight per hidden unit, then the output bias
+class ModelEvaluator
+{
+public:
+    enum Feature
+    {
+        /// 1 if the territory belongs to the player or to an opponent
+        Mine,
+        Enemy,
+
+        /// Dice of the territory, over MAX_DICE, for territories of the player or of an opponent
+        MyDice,
+        EnemyDice,
+
+        /// Share of the neighbours of a territory of the player owned by opponents
+        Exposure,
+
+        /// Most dice of a neighbouring opponent, over MAX_DICE, for territories of the player
+        Threat,
+
+        /// Size of the connected region the territory is part of, over the territories of the map, for
+        /// territories of the player or of an opponent
+        MyRegion,
+        EnemyRegion,
+
+        FEATURES
+    };
+
+    /// The instruction set the network runs with. They all give the same values, up to rounding
+    enum class Kernel
+    {
+        Scalar,
+        Sse,
+        Avx2
+    };
+
+    static constexpr int MAX_HIDDEN = 64;
+
+    /// Starts with hand-tuned weights, which make the network a linear function of the features
+    ModelEvaluator();
+
+    /// Replaces the weights with the ones of the file. Returns false, keeping the current ones, if the file
+    /// cannot be read or is not valid
+    bool load(const std::string &fileName);
+
+    /// Evaluates the positions for the given player. They must all be played on the same map
+    void evaluate(const GameState *states, int count, int player, float *values);
+
+    /// Same as above for a single position, which wastes most of the vector width
+    float evaluate(const GameState &state, int player);
+
+    /// The best kernel supported by this processor, which is the one used unless setKernel is called
+    static Kernel bestKernel();
+
+    /// Forces a kernel, mainly to compare them. Returns false if the processor does not support it
+    bool setKernel(Kernel kernel);
+
+    Kernel kernel() const;
+
+private:
+    int hidden_ = 0;
+    float hiddenWeights_[MAX_HIDDEN][FEATURES];
+    float hiddenBias_[MAX_HIDDEN];
+    float outputWeights_[MAX_HIDDEN];
+    float outputBias_ = 0;
+
+    Kernel kernel_;
+
+    /// features_[f * stride_ + row] is feature f of a row, with one row per territory of each position
+    std::vector<float> features_;
+    std::size_t stride_ = 0;
+
+    /// Output of the network for each row
+    std::vector<float> outputs_;
+
+    /// The map the adjacency below was copied from, in the layout of MapTopology. It is kept alive, so a
+    /// map created later at the same address can never be mistaken for it
+    std::shared_ptr<const MapTopology> map_;
+    std::vector<int> neighbourOffsets_;
+    std::vector<std::uint16_t> neighbours_;
+
+    /// Scratch space to find the connected regions of a position
+    std::vector<int> regions_;
+    std::vector<int> regionSizes_;
+    std::vector<int> stack_;
+
+    void extractFeatures(const GameState &state, int player, std::size_t row);
+};
+
+#endif // MODELEVALUATION_H
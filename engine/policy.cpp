@@ -0,0 +1,275 @@
+#include "policy.h"
+
+#include "diceprobability.h"
+#include "gamestate.h"
+
+#include <cstdlib>
+
+void Policy::setCandidates(const AttackCandidates *candidates)
+{
+    candidates_ = candidates;
+}
+
+GreedyPolicy::GreedyPolicy(std::uint64_t seed) : random_(seed)
+{
+}
+
+bool GreedyPolicy::chooseAttack(const GameState &state, int &from, int &to)
+{
+    const auto player = state.playerTurn();
+
+    if (candidates_)
+    {
+        const auto attacks = candidates_->attacks(player);
+        if (attacks.empty()) return false;
+
+        const auto base = random_.bounded(attacks.size());
+        for (auto offset = 0; offset < attacks.size(); offset++)
+        {
+            const auto &attack = attacks[(base + offset) % attacks.size()];
+            if (state.numDice(attack.to) <= GameState::Rules::maxTargetDice(state.numDice(attack.from)))
+            {
+                from = attack.from;
+                to = attack.to;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    territories_.clear();
+    for (auto terr = 0; terr < state.territoryCount(); terr++)
+    {
+        if (state.owner(terr) == player) territories_.push_back(terr);
+    }
+
+    const auto terrCount = static_cast<int>(territories_.size());
+    if (terrCount == 0) return false;
+    const auto terrBase = random_.bounded(terrCount);
+
+    for (auto terrOffset = 0; terrOffset < terrCount; terrOffset++)
+    {
+        const auto terr = territories_[(terrBase + terrOffset) % terrCount];
+        if (state.numDice(terr) < 2) continue;
+
+        const auto neighbours = state.map().neighbours(terr);
+        const auto nTerrCount = neighbours.size();
+        if (nTerrCount == 0) continue;
+        const auto nTerrBase = random_.bounded(nTerrCount);
+
+        for (auto nTerrOffset = 0; nTerrOffset < nTerrCount; nTerrOffset++)
+        {
+            const auto neigh = neighbours[(nTerrBase + nTerrOffset) % nTerrCount];
+            const auto owner = state.owner(neigh);
+            if (owner == GameState::NO_OWNER || owner == player) continue;
+
+            if (state.numDice(neigh) <= GameState::Rules::maxTargetDice(state.numDice(terr)))
+            {
+                from = terr;
+                to = neigh;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+std::string GreedyPolicy::name() const
+{
+    return "greedy";
+}
+
+SearchPolicy::SearchPolicy(std::shared_ptr<const MapTopology> map, int depth)
+    : search_(std::move(map), depth), cache_(CACHE_SIZE), depth_(depth)
+{
+    search_.setCache(&cache_);
+}
+
+bool SearchPolicy::chooseAttack(const GameState &state, int &from, int &to)
+{
+    const auto result = search_.search(state);
+    if (result.from < 0) return false;
+
+    from = result.from;
+    to = result.to;
+    return true;
+}
+
+std::string SearchPolicy::name() const
+{
+    return "search:depth=" + std::to_string(depth_);
+}
+
+namespace
+{
+    /// Room for the root and both outcomes of every attack: at most one per pair of neighbours
+    std::size_t candidateCapacity(const MapTopology &map)
+    {
+        std::size_t pairs = 0;
+        for (auto terr = 0; terr < map.territoryCount(); terr++) pairs += map.neighbours(terr).size();
+        return 2 * pairs + 1;
+    }
+}
+
+ModelPolicy::ModelPolicy(std::shared_ptr<const MapTopology> map)
+    : arena_(map, candidateCapacity(*map))
+{
+}
+
+bool ModelPolicy::load(const std::string &fileName)
+{
+    if (!evaluator_.load(fileName)) return false;
+    weights_ = fileName;
+    return true;
+}
+
+bool ModelPolicy::chooseAttack(const GameState &state, int &from, int &to)
+{
+    const auto player = state.playerTurn();
+
+    // The current state goes first, as the value of ending the turn
+    arena_.clear();
+    states_.assign(1, arena_.clone(state));
+    from_.clear();
+    to_.clear();
+    probabilities_.clear();
+
+    const auto consider = [&](int terr, int neighbour)
+    {
+        const auto probability = DiceProbability::attackWins(state.numDice(terr), state.numDice(neighbour));
+        if (probability < TurnSearch::MIN_PROBABILITY) return;
+
+        AttackUndo undo;
+        states_.push_back(arena_.clone(state));
+        states_.back().makeAttackOutcome(terr, neighbour, true, undo);
+        states_.push_back(arena_.clone(state));
+        states_.back().makeAttackOutcome(terr, neighbour, false, undo);
+
+        from_.push_back(terr);
+        to_.push_back(neighbour);
+        probabilities_.push_back(static_cast<float>(probability));
+    };
+
+    if (candidates_)
+    {
+        for (const auto &attack : candidates_->attacks(player)) consider(attack.from, attack.to);
+    }
+    else
+    {
+        for (auto terr = 0; terr < state.territoryCount(); terr++)
+        {
+            if (state.owner(terr) != player || state.numDice(terr) < 2) continue;
+
+            for (auto neighbour : state.map().neighbours(terr))
+            {
+                const auto defender = state.owner(neighbour);
+                if (defender != player && defender != GameState::NO_OWNER) consider(terr, neighbour);
+            }
+        }
+    }
+    if (from_.empty()) return false;
+
+    values_.resize(states_.size());
+    evaluator_.evaluate(states_.data(), static_cast<int>(states_.size()), player, values_.data());
+
+    auto best = values_[0];
+    auto bestAttack = -1;
+    for (auto attack = 0; attack < static_cast<int>(from_.size()); attack++)
+    {
+        const auto p = probabilities_[attack];
+        const auto value = p * values_[1 + 2 * attack] + (1 - p) * values_[2 + 2 * attack];
+        if (value > best)
+        {
+            best = value;
+            bestAttack = attack;
+        }
+    }
+    if (bestAttack < 0) return false;
+
+    from = from_[bestAttack];
+    to = to_[bestAttack];
+    return true;
+}
+
+std::string ModelPolicy::name() const
+{
+    return weights_.empty() ? "model" : "model:weights=" + weights_;
+}
+
+EndgamePolicy::EndgamePolicy(std::shared_ptr<const MapTopology> map, std::unique_ptr<Policy> fallback,
+                             const EndgameSolver::Limits &limits)
+    : fallback_(std::move(fallback)), solver_(std::move(map), limits)
+{
+}
+
+bool EndgamePolicy::chooseAttack(const GameState &state, int &from, int &to)
+{
+    if (solver_.applies(state))
+    {
+        const auto result = solver_.solve(state);
+        if (result.solved && result.winProbability >= MIN_WIN_PROBABILITY)
+        {
+            from = result.from;
+            to = result.to;
+            return true;
+        }
+    }
+
+    return fallback_->chooseAttack(state, from, to);
+}
+
+std::string EndgamePolicy::name() const
+{
+    return "endgame:" + fallback_->name();
+}
+
+void EndgamePolicy::setCandidates(const AttackCandidates *candidates)
+{
+    Policy::setCandidates(candidates);
+    fallback_->setCandidates(candidates);
+}
+
+std::unique_ptr<Policy> createPolicy(const std::string &spec, std::shared_ptr<const MapTopology> map, std::uint64_t seed)
+{
+    if (spec == "greedy") return std::unique_ptr<Policy>(new GreedyPolicy(seed));
+
+    const std::string endgame = "endgame:";
+    if (spec.compare(0, endgame.size(), endgame) == 0)
+    {
+        auto fallback = createPolicy(spec.substr(endgame.size()), map, seed);
+        if (!fallback) return nullptr;
+        return std::unique_ptr<Policy>(new EndgamePolicy(std::move(map), std::move(fallback)));
+    }
+
+    const std::string search = "search";
+    if (spec.compare(0, search.size(), search) == 0)
+    {
+        auto depth = 2;
+        const std::string option = ":depth=";
+        if (spec.size() > search.size())
+        {
+            if (spec.compare(search.size(), option.size(), option) != 0) return nullptr;
+            char *end = nullptr;
+            depth = static_cast<int>(std::strtol(spec.c_str() + search.size() + option.size(), &end, 10));
+            if (*end) return nullptr;
+        }
+        if (depth < 1 || depth > 8) return nullptr;
+        return std::unique_ptr<Policy>(new SearchPolicy(std::move(map), depth));
+    }
+
+    const std::string model = "model";
+    if (spec.compare(0, model.size(), model) == 0)
+    {
+        std::unique_ptr<ModelPolicy> policy(new ModelPolicy(std::move(map)));
+        const std::string option = ":weights=";
+        if (spec.size() > model.size())
+        {
+            if (spec.compare(model.size(), option.size(), option) != 0) return nullptr;
+            if (!policy->load(spec.substr(model.size() + option.size()))) return nullptr;
+        }
+        return policy;
+    }
+
+    return nullptr;
+}
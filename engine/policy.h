@@ -0,0 +1,121 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "attackcandidates.h"
+#include "endgamesolver.h"
+#include "evaluationcache.h"
+#include "modelevaluation.h"
+#include "random.h"
+#include "turnsearch.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// This class decides the attacks of an AI player. It is asked again after every attack, until it
+/// decides to end the turn
+class Policy
+{
+public:
+    virtual ~Policy() = default;
+
+    /// Chooses the next attack for the player whose turn it is. Returns false to end the turn
+    virtual bool chooseAttack(const GameState &state, int &from, int &to) = 0;
+
+    /// Name used to identify the policy in logs and reports
+    virtual std::string name() const = 0;
+
+    /// Lets the policy take the legal attacks from candidates kept up to date by whoever plays the game,
+    /// instead of scanning the whole board on every call. They must describe every state passed to
+    /// chooseAttack from now on. With nullptr, the policy scans the board again
+    virtual void setCandidates(const AttackCandidates *candidates);
+
+protected:
+    const AttackCandidates *candidates_ = nullptr;
+};
+
+/// The AI of the game, played by GameEngine: starting from a random territory and a random neighbour, attack
+/// the first enemy that has fewer dice (or as many, if both have the maximum). With candidates, it starts
+/// from a random one of them instead
+class GreedyPolicy final : public Policy
+{
+    Random random_;
+
+    /// The territories of the current player, reused between calls
+    std::vector<int> territories_;
+
+public:
+    explicit GreedyPolicy(std::uint64_t seed);
+
+    bool chooseAttack(const GameState &state, int &from, int &to) override;
+    std::string name() const override;
+};
+
+/// Searches the attack sequences of the turn with TurnSearch, keeping an EvaluationCache for the whole game
+class SearchPolicy final : public Policy
+{
+    TurnSearch search_;
+    EvaluationCache cache_;
+    int depth_;
+
+public:
+    SearchPolicy(std::shared_ptr<const MapTopology> map, int depth);
+
+    bool chooseAttack(const GameState &state, int &from, int &to) override;
+    std::string name() const override;
+
+    /// Number of entries of the cache
+    static constexpr std::size_t CACHE_SIZE = 1 << 16;
+};
+
+/// Looks one attack ahead with ModelEvaluator: both outcomes of every attack are evaluated in a single batch,
+/// and the attack with the best expected value is chosen if it beats ending the turn
+class ModelPolicy final : public Policy
+{
+    ModelEvaluator evaluator_;
+    StateArena arena_;
+    std::string weights_;
+
+    /// The attacks considered, with their probability, and the state after winning or losing each of them
+    std::vector<int> from_;
+    std::vector<int> to_;
+    std::vector<float> probabilities_;
+    std::vector<GameState> states_;
+    std::vector<float> values_;
+
+public:
+    explicit ModelPolicy(std::shared_ptr<const MapTopology> map);
+
+    /// Uses the weights of the file instead of the hand-tuned ones. Returns false if it could not be loaded
+    bool load(const std::string &fileName);
+
+    bool chooseAttack(const GameState &state, int &from, int &to) override;
+    std::string name() const override;
+};
+
+/// Plays like another policy until the position is small enough for EndgameSolver, which then takes over as
+/// long as it finds a good enough chance of finishing the game in the current turn
+class EndgamePolicy final : public Policy
+{
+    std::unique_ptr<Policy> fallback_;
+    EndgameSolver solver_;
+
+public:
+    EndgamePolicy(std::shared_ptr<const MapTopology> map, std::unique_ptr<Policy> fallback,
+                  const EndgameSolver::Limits &limits = EndgameSolver::Limits());
+
+    bool chooseAttack(const GameState &state, int &from, int &to) override;
+    std::string name() const override;
+    void setCandidates(const AttackCandidates *candidates) override;
+
+    /// Below this, going all-in would leave the player too exposed, and the fallback decides instead
+    static constexpr double MIN_WIN_PROBABILITY = 0.25;
+};
+
+/// Creates a policy from a textual description such as "greedy", "search:depth=2" or "model:weights=file".
+/// Any of them can be prefixed with "endgame:" to let EndgameSolver finish the games. Returns nullptr if
+/// the description is not valid
+std::unique_ptr<Policy> createPolicy(const std::string &spec, std::shared_ptr<const MapTopology> map, std::uint64_t seed);
+
+#endif // POLICY_H
@@ -0,0 +1,383 @@
+#include "positionwriter.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr char MAGIC[8] = {'D', 'W', 'S', 'E', 'L', 'F', 'P', 'L'};
+
+    constexpr std::size_t align8(std::size_t size)
+    {
+        return (size + 7) & ~static_cast<std::size_t>(7);
+    }
+
+    /// Copies count values of a column, width values per record, from the batch into the block
+    template <typename T>
+    void copyColumn(std::uint8_t *block, std::size_t column, int blockRecord, const std::vector<T> &values,
+                    std::size_t first, std::size_t count, std::size_t width = 1)
+    {
+        std::memcpy(block + column + blockRecord * width * sizeof(T), values.data() + first * width, count * width * sizeof(T));
+    }
+
+    template <typename T>
+    void fillColumn(std::uint8_t *block, std::size_t column, int blockRecord, T value, std::size_t count)
+    {
+        std::fill_n(reinterpret_cast<T *>(block + column) + blockRecord, count, value);
+    }
+
+    template <typename T>
+    T readValue(const std::uint8_t *data)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+}
+
+PositionFile::BlockLayout::BlockLayout(std::size_t blockSize, std::size_t territoryStride)
+{
+    size = 0;
+    auto column = [this, blockSize](std::size_t bytes)
+    {
+        const auto offset = size;
+        size += align8(blockSize * bytes);
+        return offset;
+    };
+
+    game = column(sizeof(std::uint32_t));
+    map = column(sizeof(std::uint16_t));
+    turn = column(sizeof(std::uint16_t));
+    player = column(sizeof(std::int8_t));
+    winner = column(sizeof(std::int8_t));
+    from = column(sizeof(std::int16_t));
+    to = column(sizeof(std::int16_t));
+    owners = column(territoryStride * sizeof(std::int8_t));
+    dice = column(territoryStride * sizeof(std::uint8_t));
+    connected = column(MAX_PLAYERS * sizeof(std::uint16_t));
+}
+
+PositionFile::PositionFile(const void *data, std::size_t size)
+{
+    if (!data || size < sizeof(FileHeader)) return;
+
+    const auto header = static_cast<const FileHeader *>(data);
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION) return;
+    if (header->maxPlayers != MAX_PLAYERS || header->blockSize == 0 || header->territoryStride == 0) return;
+    if (header->recordCount > header->blockCount * header->blockSize) return;
+
+    // The blocks and the start of the map table must be inside the data
+    const BlockLayout layout(header->blockSize, header->territoryStride);
+    const auto blocksEnd = align8(sizeof(FileHeader)) + header->blockCount * layout.size;
+    if (blocksEnd > size || header->mapTableOffset < blocksEnd || header->mapTableOffset + sizeof(std::uint64_t) > size) return;
+    const auto mapCount = readValue<std::uint64_t>(static_cast<const std::uint8_t *>(data) + header->mapTableOffset);
+    if (mapCount > 0xffff || header->mapTableOffset + (mapCount + 1) * sizeof(std::uint64_t) > size) return;
+
+    data_ = static_cast<const std::uint8_t *>(data);
+    size_ = size;
+}
+
+bool PositionFile::isValid() const
+{
+    return data_ != nullptr;
+}
+
+std::uint64_t PositionFile::recordCount() const
+{
+    return data_ ? reinterpret_cast<const FileHeader *>(data_)->recordCount : 0;
+}
+
+int PositionFile::territoryStride() const
+{
+    return data_ ? static_cast<int>(reinterpret_cast<const FileHeader *>(data_)->territoryStride) : 0;
+}
+
+int PositionFile::mapCount() const
+{
+    if (!data_) return 0;
+    return static_cast<int>(readValue<std::uint64_t>(data_ + reinterpret_cast<const FileHeader *>(data_)->mapTableOffset));
+}
+
+PositionFile::Record PositionFile::record(std::uint64_t index) const
+{
+    Record record;
+    if (index >= recordCount()) return record;
+
+    const auto header = reinterpret_cast<const FileHeader *>(data_);
+    const BlockLayout layout(header->blockSize, header->territoryStride);
+    const auto block = data_ + align8(sizeof(FileHeader)) + index / header->blockSize * layout.size;
+    const auto i = static_cast<std::size_t>(index % header->blockSize);
+    const auto stride = static_cast<std::size_t>(header->territoryStride);
+
+    record.game = readValue<std::uint32_t>(block + layout.game + i * sizeof(std::uint32_t));
+    record.map = readValue<std::uint16_t>(block + layout.map + i * sizeof(std::uint16_t));
+    record.turn = readValue<std::uint16_t>(block + layout.turn + i * sizeof(std::uint16_t));
+    record.player = static_cast<std::int8_t>(block[layout.player + i]);
+    record.winner = static_cast<std::int8_t>(block[layout.winner + i]);
+    record.from = readValue<std::int16_t>(block + layout.from + i * sizeof(std::int16_t));
+    record.to = readValue<std::int16_t>(block + layout.to + i * sizeof(std::int16_t));
+    record.owners = reinterpret_cast<const std::int8_t *>(block + layout.owners + i * stride);
+    record.dice = block + layout.dice + i * stride;
+    record.connected = reinterpret_cast<const std::uint16_t *>(block + layout.connected + i * MAX_PLAYERS * sizeof(std::uint16_t));
+    return record;
+}
+
+PositionFile::Map PositionFile::map(int index) const
+{
+    Map map;
+    if (index < 0 || index >= mapCount()) return map;
+
+    const auto table = reinterpret_cast<const FileHeader *>(data_)->mapTableOffset;
+    const auto offset = readValue<std::uint64_t>(data_ + table + (index + 1) * sizeof(std::uint64_t));
+    if (offset % 8 != 0 || offset + 2 * sizeof(std::uint32_t) > size_) return map;
+
+    const auto territoryCount = readValue<std::uint32_t>(data_ + offset);
+    const auto neighbourCount = readValue<std::uint32_t>(data_ + offset + sizeof(std::uint32_t));
+    if (territoryCount > static_cast<std::uint32_t>(territoryStride())) return map;
+    const auto neighbours = offset + (territoryCount + 3) * sizeof(std::uint32_t);
+    if (neighbours + neighbourCount * sizeof(std::uint16_t) > size_) return map;
+
+    map.territoryCount = static_cast<int>(territoryCount);
+    map.neighbourOffsets = reinterpret_cast<const std::uint32_t *>(data_ + offset + 2 * sizeof(std::uint32_t));
+    map.neighbours = reinterpret_cast<const std::uint16_t *>(data_ + neighbours);
+    return map;
+}
+
+PositionBatch::PositionBatch(int territoryStride)
+    : territoryStride_(territoryStride)
+{
+}
+
+void PositionBatch::reset(std::uint32_t game, std::uint16_t map)
+{
+    game_ = game;
+    map_ = map;
+    winner_ = -1;
+    turns_.clear();
+    players_.clear();
+    from_.clear();
+    to_.clear();
+    owners_.clear();
+    dice_.clear();
+    connected_.clear();
+}
+
+void PositionBatch::add(const GameState &state, int turn, int from, int to)
+{
+    turns_.push_back(static_cast<std::uint16_t>(std::min(turn, 0xffff)));
+    players_.push_back(static_cast<std::int8_t>(state.playerTurn()));
+    from_.push_back(static_cast<std::int16_t>(from));
+    to_.push_back(static_cast<std::int16_t>(to));
+
+    // Territories beyond the ones of the map are left without owner, so every record has the same size
+    const auto count = std::min(state.territoryCount(), territoryStride_);
+    for (auto terr = 0; terr < count; terr++)
+    {
+        owners_.push_back(static_cast<std::int8_t>(state.owner(terr)));
+        dice_.push_back(static_cast<std::uint8_t>(state.numDice(terr)));
+    }
+    owners_.insert(owners_.end(), territoryStride_ - count, static_cast<std::int8_t>(GameState::NO_OWNER));
+    dice_.insert(dice_.end(), territoryStride_ - count, 0);
+
+    for (auto player = 0; player < PositionFile::MAX_PLAYERS; player++)
+    {
+        connected_.push_back(static_cast<std::uint16_t>(player < state.playerCount() ? state.connectedTerritories(player) : 0));
+    }
+}
+
+void PositionBatch::setWinner(int winner)
+{
+    winner_ = static_cast<std::int8_t>(winner);
+}
+
+std::size_t PositionBatch::size() const
+{
+    return turns_.size();
+}
+
+PositionWriter::~PositionWriter()
+{
+    close();
+}
+
+bool PositionWriter::open(const std::string &fileName, int territoryStride, int blockSize)
+{
+    close();
+    if (territoryStride < 1 || territoryStride > MapTopology::MAX_TERRITORIES || blockSize < 1) return false;
+
+    file_ = std::fopen(fileName.c_str(), "wb");
+    if (!file_) return false;
+
+    territoryStride_ = territoryStride;
+    blockSize_ = blockSize;
+    failed_ = false;
+    block_.assign(PositionFile::BlockLayout(blockSize, territoryStride).size, 0);
+    blockRecords_ = 0;
+    blockCount_ = 0;
+    mapOffsets_.clear();
+    mapNeighbours_.clear();
+    recordCount_ = 0;
+    closing_ = false;
+
+    // The header is written again with the final counts once the file is closed
+    const std::uint8_t header[align8(sizeof(PositionFile::FileHeader))] = {};
+    failed_ = std::fwrite(header, sizeof(header), 1, file_) != 1;
+
+    thread_ = std::thread(&PositionWriter::run, this);
+    return true;
+}
+
+int PositionWriter::addMap(const MapTopology &map)
+{
+    if (map.territoryCount() > territoryStride_) return -1;
+
+    std::vector<std::uint32_t> offsets(1, 0);
+    std::vector<std::uint16_t> neighbours;
+    for (auto terr = 0; terr < map.territoryCount(); terr++)
+    {
+        const auto list = map.neighbours(terr);
+        neighbours.insert(neighbours.end(), list.begin(), list.end());
+        offsets.push_back(static_cast<std::uint32_t>(neighbours.size()));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mapOffsets_.size() > 0xffff) return -1;
+    mapOffsets_.push_back(std::move(offsets));
+    mapNeighbours_.push_back(std::move(neighbours));
+    return static_cast<int>(mapOffsets_.size()) - 1;
+}
+
+void PositionWriter::submit(PositionBatch &&batch)
+{
+    if (batch.size() == 0 || batch.territoryStride_ != territoryStride_) return;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!file_ || closing_) return;
+    space_.wait(lock, [this]() { return pending_.size() < MAX_PENDING_BATCHES; });
+    recordCount_ += batch.size();
+    pending_.push_back(std::move(batch));
+    queued_.notify_one();
+}
+
+std::uint64_t PositionWriter::recordCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return recordCount_;
+}
+
+void PositionWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        queued_.wait(lock, [this]() { return closing_ || !pending_.empty(); });
+        if (pending_.empty()) return;
+
+        auto batch = std::move(pending_.front());
+        pending_.pop_front();
+        space_.notify_one();
+
+        // The games keep being queued while this one is copied and written
+        lock.unlock();
+        write(batch);
+        lock.lock();
+    }
+}
+
+void PositionWriter::write(const PositionBatch &batch)
+{
+    const PositionFile::BlockLayout layout(blockSize_, territoryStride_);
+    const auto stride = static_cast<std::size_t>(territoryStride_);
+    const auto block = block_.data();
+
+    // Each column of the batch is copied at once, for as many records as fit in the current block
+    std::size_t first = 0;
+    while (first < batch.size())
+    {
+        const auto count = std::min(batch.size() - first, static_cast<std::size_t>(blockSize_ - blockRecords_));
+        fillColumn<std::uint32_t>(block, layout.game, blockRecords_, batch.game_, count);
+        fillColumn<std::uint16_t>(block, layout.map, blockRecords_, batch.map_, count);
+        copyColumn(block, layout.turn, blockRecords_, batch.turns_, first, count);
+        copyColumn(block, layout.player, blockRecords_, batch.players_, first, count);
+        fillColumn<std::int8_t>(block, layout.winner, blockRecords_, batch.winner_, count);
+        copyColumn(block, layout.from, blockRecords_, batch.from_, first, count);
+        copyColumn(block, layout.to, blockRecords_, batch.to_, first, count);
+        copyColumn(block, layout.owners, blockRecords_, batch.owners_, first, count, stride);
+        copyColumn(block, layout.dice, blockRecords_, batch.dice_, first, count, stride);
+        copyColumn(block, layout.connected, blockRecords_, batch.connected_, first, count, PositionFile::MAX_PLAYERS);
+
+        first += count;
+        blockRecords_ += static_cast<int>(count);
+        if (blockRecords_ == blockSize_) flushBlock();
+    }
+}
+
+void PositionWriter::flushBlock()
+{
+    if (std::fwrite(block_.data(), 1, block_.size(), file_) != block_.size()) failed_ = true;
+    std::fill(block_.begin(), block_.end(), 0);
+    blockRecords_ = 0;
+    blockCount_++;
+}
+
+bool PositionWriter::writeMapTable(std::uint64_t offset)
+{
+    // Calculating where every map will be before writing anything
+    const auto mapCount = mapOffsets_.size();
+    std::vector<std::uint64_t> table(1, mapCount);
+    auto position = offset + (mapCount + 1) * sizeof(std::uint64_t);
+    for (std::size_t i = 0; i < mapCount; i++)
+    {
+        table.push_back(position);
+        position += align8((mapOffsets_[i].size() + 2) * sizeof(std::uint32_t)
+                           + mapNeighbours_[i].size() * sizeof(std::uint16_t));
+    }
+
+    const std::uint64_t padding = 0;
+    auto ok = std::fwrite(table.data(), sizeof(std::uint64_t), table.size(), file_) == table.size();
+    for (std::size_t i = 0; i < mapCount; i++)
+    {
+        const auto &offsets = mapOffsets_[i];
+        const auto &neighbours = mapNeighbours_[i];
+        const std::uint32_t counts[2] = {static_cast<std::uint32_t>(offsets.size() - 1), static_cast<std::uint32_t>(neighbours.size())};
+        const auto bytes = sizeof(counts) + offsets.size() * sizeof(std::uint32_t) + neighbours.size() * sizeof(std::uint16_t);
+
+        ok = ok && std::fwrite(counts, sizeof(counts), 1, file_) == 1;
+        ok = ok && std::fwrite(offsets.data(), sizeof(std::uint32_t), offsets.size(), file_) == offsets.size();
+        ok = ok && std::fwrite(neighbours.data(), sizeof(std::uint16_t), neighbours.size(), file_) == neighbours.size();
+        ok = ok && std::fwrite(&padding, 1, align8(bytes) - bytes, file_) == align8(bytes) - bytes;
+    }
+
+    return ok;
+}
+
+bool PositionWriter::close()
+{
+    if (!file_) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    queued_.notify_one();
+    thread_.join();
+
+    if (blockRecords_ > 0) flushBlock();
+
+    PositionFile::FileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = PositionFile::VERSION;
+    header.territoryStride = static_cast<std::uint32_t>(territoryStride_);
+    header.maxPlayers = PositionFile::MAX_PLAYERS;
+    header.blockSize = static_cast<std::uint32_t>(blockSize_);
+    header.recordCount = recordCount_;
+    header.blockCount = blockCount_;
+    header.mapTableOffset = align8(sizeof(header)) + blockCount_ * block_.size();
+
+    auto ok = !failed_ && writeMapTable(header.mapTableOffset);
+    ok = ok && std::fseek(file_, 0, SEEK_SET) == 0;
+    ok = ok && std::fwrite(&header, sizeof(header), 1, file_) == 1;
+    ok = std::fclose(file_) == 0 && ok;
+    file_ = nullptr;
+    return ok;
+}
@@ -0,0 +1,215 @@
+#ifndef POSITIONWRITER_H
+#define POSITIONWRITER_H
+
+#include "gamestate.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Positions of self-play games, stored for training evaluators offline. Every record is the state right
+/// before a move, the move chosen and the player that eventually won the game.
+///
+/// Layout (little endian, every section 8-byte aligned):
+///   header: magic, version, territory stride, players, records per block, record count, block count,
+///           position of the map table
+///   blocks: blockSize records each, stored column by column, so a column can be read without touching
+///           the others: game (u32), map (u16), turn (u16), player (i8), winner (i8, -1 for a draw),
+///           from (i16), to (i16, both -1 for ending the turn), then territoryStride owners (i8, -1 for
+///           none), territoryStride dice (u8) and the connected territories of MAX_PLAYERS players (u16)
+///           for each record. Only the last block may be partially filled
+///   map table: map count, the position of each map (64-bit), and for each map its territory count,
+///              neighbour count, neighbour offsets (territory count + 1, 32-bit) and neighbours (16-bit)
+///
+/// Every block has the same size, so record i is found in O(1) without any index
+class PositionFile
+{
+public:
+    /// Pointers to one record inside the file
+    struct Record
+    {
+        std::uint32_t game = 0;
+        std::uint16_t map = 0;
+        std::uint16_t turn = 0;
+        std::int8_t player = -1;
+        std::int8_t winner = -1;
+        std::int16_t from = -1;
+        std::int16_t to = -1;
+
+        /// territoryStride values each
+        const std::int8_t *owners = nullptr;
+        const std::uint8_t *dice = nullptr;
+
+        /// MAX_PLAYERS values
+        const std::uint16_t *connected = nullptr;
+
+        bool isValid() const { return owners != nullptr; }
+    };
+
+    /// The adjacency of the territories of a map, shared by all the records played on it
+    struct Map
+    {
+        int territoryCount = 0;
+
+        /// The neighbours of territory i go from neighbours[neighbourOffsets[i]] to neighbours[neighbourOffsets[i + 1]]
+        const std::uint32_t *neighbourOffsets = nullptr;
+        const std::uint16_t *neighbours = nullptr;
+
+        bool isValid() const { return neighbourOffsets != nullptr; }
+    };
+
+    PositionFile() = default;
+
+    /// The data must stay alive while the file is used, and is meant to be memory mapped. If it is not a
+    /// valid file, isValid() will return false
+    PositionFile(const void *data, std::size_t size);
+
+    bool isValid() const;
+
+    std::uint64_t recordCount() const;
+    int territoryStride() const;
+    int mapCount() const;
+
+    /// Returns an invalid record if the index is out of range
+    Record record(std::uint64_t index) const;
+
+    /// Returns an invalid map if the index is out of range or the data of the map is damaged
+    Map map(int index) const;
+
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr int MAX_PLAYERS = GameState::MAX_PLAYERS;
+
+private:
+    friend class PositionWriter;
+
+    struct FileHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t territoryStride;
+        std::uint32_t maxPlayers;
+        std::uint32_t blockSize;
+        std::uint64_t recordCount;
+        std::uint64_t blockCount;
+        std::uint64_t mapTableOffset;
+    };
+
+    /// Position of each column inside a block, and the size of the whole block
+    struct BlockLayout
+    {
+        std::size_t game, map, turn, player, winner, from, to, owners, dice, connected;
+        std::size_t size;
+
+        BlockLayout(std::size_t blockSize, std::size_t territoryStride);
+    };
+
+    const std::uint8_t *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+/// The positions of a single game, collected by the thread playing it. They are handed to PositionWriter
+/// once the game is over, as the winner is only known then
+class PositionBatch
+{
+public:
+    explicit PositionBatch(int territoryStride = 0);
+
+    /// Drops the positions collected, to start recording a new game
+    void reset(std::uint32_t game, std::uint16_t map);
+
+    /// Records the state right before the given move, with -1 as from and to for ending the turn
+    void add(const GameState &state, int turn, int from, int to);
+
+    void setWinner(int winner);
+
+    std::size_t size() const;
+
+private:
+    friend class PositionWriter;
+
+    int territoryStride_;
+    std::uint32_t game_ = 0;
+    std::uint16_t map_ = 0;
+    std::int8_t winner_ = -1;
+
+    std::vector<std::uint16_t> turns_;
+    std::vector<std::int8_t> players_;
+    std::vector<std::int16_t> from_;
+    std::vector<std::int16_t> to_;
+    std::vector<std::int8_t> owners_;
+    std::vector<std::uint8_t> dice_;
+    std::vector<std::uint16_t> connected_;
+};
+
+/// Writes a PositionFile from any number of threads playing games. The games are only queued by submit(),
+/// and a thread of the writer copies them into blocks and writes them, so recording a game never waits for
+/// the disk unless the writer falls far behind
+class PositionWriter
+{
+public:
+    PositionWriter() = default;
+    PositionWriter(const PositionWriter &) = delete;
+    PositionWriter &operator=(const PositionWriter &) = delete;
+
+    /// Closes the file if it was still open
+    ~PositionWriter();
+
+    /// Starts writing a new file. Every record holds territoryStride territories, so the largest map must
+    /// fit in it. Returns false if the file cannot be created
+    bool open(const std::string &fileName, int territoryStride, int blockSize = DEFAULT_BLOCK_SIZE);
+
+    /// Adds the adjacency of a map to the map table. Returns the index to give to PositionBatch::reset, or
+    /// -1 if the map has more territories than the stride. This can be called from any thread
+    int addMap(const MapTopology &map);
+
+    /// Queues the positions of a game for writing. This only waits if MAX_PENDING_BATCHES are already queued
+    void submit(PositionBatch &&batch);
+
+    /// Writes everything still queued, the map table and the final header. Returns false if any write failed
+    bool close();
+
+    /// Records written so far, including the ones still queued
+    std::uint64_t recordCount() const;
+
+    /// Enough records per block for the columns of a block to be a few disk pages each
+    static constexpr int DEFAULT_BLOCK_SIZE = 4096;
+
+    /// Games queued before submit() starts waiting for the writer thread
+    static constexpr std::size_t MAX_PENDING_BATCHES = 64;
+
+private:
+    std::FILE *file_ = nullptr;
+    int territoryStride_ = 0;
+    int blockSize_ = 0;
+    bool failed_ = false;
+
+    /// The block being filled by the writer thread
+    std::vector<std::uint8_t> block_;
+    int blockRecords_ = 0;
+    std::uint64_t blockCount_ = 0;
+
+    /// The adjacency of the maps added, in the layout of the map table
+    std::vector<std::vector<std::uint32_t>> mapOffsets_;
+    std::vector<std::vector<std::uint16_t>> mapNeighbours_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable queued_;
+    std::condition_variable space_;
+    std::deque<PositionBatch> pending_;
+    std::uint64_t recordCount_ = 0;
+    bool closing_ = false;
+    std::thread thread_;
+
+    void run();
+    void write(const PositionBatch &batch);
+    void flushBlock();
+    bool writeMapTable(std::uint64_t offset);
+};
+
+#endif // POSITIONWRITER_H
@@ -0,0 +1,62 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+/// Small deterministic random number generator (SplitMix64). Unlike qrand(), it has no global state:
+/// the whole generator is a single integer, so it can live inside a GameState and be copied with it
+class Random
+{
+    std::uint64_t state_;
+
+public:
+    Random() = default;
+    explicit constexpr Random(std::uint64_t seed) : state_(seed) {}
+
+    constexpr std::uint64_t state() const { return state_; }
+    constexpr void setState(std::uint64_t state) { state_ = state; }
+
+    constexpr std::uint64_t next()
+    {
+        auto z = (state_ += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    /// Returns a number between 0 and bound - 1
+    constexpr int bounded(int bound)
+    {
+        return static_cast<int>(((next() >> 32) * static_cast<std::uint64_t>(bound)) >> 32);
+    }
+
+    /// Rolls the given number of dice with the given number of sides and returns the total score.
+    /// If faces is not null, the value of each die is written there
+    constexpr int roll(int count, int sides = 6, int *faces = nullptr)
+    {
+        auto score = 0;
+        for (auto i = 0; i < count; i++)
+        {
+            const auto face = bounded(sides) + 1;
+            if (faces) faces[i] = face;
+            score += face;
+        }
+        return score;
+    }
+
+    /// Same as above with the number of sides known at compile time, so that bounded() multiplies by a constant
+    template <int Sides>
+    constexpr int roll(int count, int *faces = nullptr)
+    {
+        auto score = 0;
+        for (auto i = 0; i < count; i++)
+        {
+            const auto face = bounded(Sides) + 1;
+            if (faces) faces[i] = face;
+            score += face;
+        }
+        return score;
+    }
+};
+
+#endif // RANDOM_H
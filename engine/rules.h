@@ -0,0 +1,56 @@
+#ifndef RULES_H
+#define RULES_H
+
+/// Compile-time description of the rules a game is played with and of the capacity needed to play it. Code
+/// templated on it gets its limits as constants, so loops over players or dice have fixed bounds and the
+/// features that are disabled (e.g. cheat mode) are not even compiled in
+template <int MaxTerritories, int MaxPlayers, int MaxDice, int DiceSides, bool CheatMode>
+struct Rules
+{
+    static_assert(MaxPlayers >= 2 && MaxPlayers <= 127, "Owners are stored as signed bytes");
+    static_assert(MaxDice >= 1 && MaxDice <= 255, "Dice are stored as bytes");
+    static_assert(MaxTerritories >= 1 && MaxTerritories <= 0x7fff, "Territory indices are stored as 16-bit values");
+    static_assert(DiceSides >= 2, "A die needs at least 2 sides");
+
+    static constexpr int MAX_TERRITORIES = MaxTerritories;
+    static constexpr int MAX_PLAYERS = MaxPlayers;
+
+    /// Most dice a territory can hold
+    static constexpr int MAX_DICE = MaxDice;
+
+    static constexpr int DICE_SIDES = DiceSides;
+
+    /// Human players roll half as many dice again
+    static constexpr bool CHEAT_MODE = CheatMode;
+
+    /// Dice that can wait to be placed once all the territories of a player are full
+    static constexpr int MAX_REMAINING_DICE = 100;
+
+    /// Number of dice rolled by a territory holding the given dice
+    static constexpr int rollCount(int dice, [[maybe_unused]] bool human)
+    {
+        if constexpr (CheatMode)
+        {
+            if (human) return 1 + dice * 3 / 2;
+        }
+        return dice;
+    }
+
+    /// Largest number of dice a single roll can have
+    static constexpr int MAX_ROLL = rollCount(MaxDice, true);
+
+    /// The AI only attacks territories with fewer dice than the attacking one, except when that one is full:
+    /// then it also attacks full territories, which avoids stalemates between them
+    static constexpr int maxTargetDice(int dice)
+    {
+        return dice == MaxDice ? dice : dice - 1;
+    }
+};
+
+/// The rules of the game: up to 8 players, and territories holding up to 8 six-sided dice
+using StandardRules = Rules<0x7fff, 8, 8, 6, false>;
+
+/// Same as StandardRules, with the cheat mode of the game enabled
+using CheatRules = Rules<0x7fff, 8, 8, 6, true>;
+
+#endif // RULES_H
@@ -0,0 +1,112 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/// Fixed-size ring buffer for passing values from exactly one producer thread to exactly one consumer
+/// thread without locks. Both sides only touch their own index and read the other one with acquire
+/// semantics, so neither of them ever waits for the other: push fails when the buffer is full and pop
+/// fails when it is empty
+template <typename T>
+class SpscQueue
+{
+    std::vector<T> slots_;
+    std::size_t mask_;
+
+    /// Next slot to write, only changed by the producer. The producer keeps the last head it has seen
+    /// next to it, so it only reads the index of the consumer when the buffer looks full
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t cachedHead_ = 0;
+
+    /// Next slot to read, only changed by the consumer, with the last tail it has seen
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t cachedTail_ = 0;
+
+public:
+    /// The capacity is rounded up to a power of two
+    explicit SpscQueue(std::size_t capacity)
+    {
+        std::size_t size = 1;
+        while (size < capacity) size *= 2;
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    std::size_t capacity() const { return slots_.size(); }
+
+    /// Only an estimate when called while the other side is working
+    std::size_t size() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+
+    /// Producer side. Returns false, without copying the value, if the buffer is full
+    bool push(const T &value)
+    {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ == slots_.size())
+        {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ == slots_.size()) return false;
+        }
+
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side. Returns false if the buffer is empty
+    bool pop(T &value)
+    {
+        const auto head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_)
+        {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) return false;
+        }
+
+        value = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+/// SpscQueue for a consumer that only looks at it when it is woken up, e.g. by a queued signal. The producer
+/// is told to wake the consumer up after the first value pushed since the consumer last found the queue
+/// empty, so it does not send a wake-up for every value, and no value is ever left behind without one
+template <typename T>
+class WakeUpQueue
+{
+    SpscQueue<T> queue_;
+
+    /// Whether the consumer has been woken up and has not found the queue empty since then
+    std::atomic<bool> wakeUpPending_{false};
+
+public:
+    explicit WakeUpQueue(std::size_t capacity) : queue_(capacity) {}
+
+    std::size_t capacity() const { return queue_.capacity(); }
+    std::size_t size() const { return queue_.size(); }
+
+    /// Producer side. Returns false, without copying the value, if the buffer is full
+    bool push(const T &value) { return queue_.push(value); }
+
+    /// Producer side, after pushing some values: whether the consumer has to be woken up to take them
+    bool needsWakeUp() { return !wakeUpPending_.exchange(true); }
+
+    /// Consumer side. Once it returns false, the consumer can wait until it is woken up again
+    bool pop(T &value)
+    {
+        if (queue_.pop(value)) return true;
+
+        // The queue was empty: the next value pushed must wake the consumer up again. Checking once more closes
+        // the gap where a value is pushed right before the flag is cleared, and would otherwise wait for the next one.
+        // The flag is cleared with an exchange so that it also acquires the values pushed before it was set
+        wakeUpPending_.exchange(false);
+        return queue_.pop(value);
+    }
+};
+
+#endif // SPSCQUEUE_H
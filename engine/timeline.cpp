@@ -0,0 +1,117 @@
+#include "timeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+Timeline::Timeline(Clock clock)
+    : clock_(std::move(clock))
+{
+    if (!clock_)
+    {
+        clock_ = []()
+        {
+            return static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        };
+    }
+    lastReal_ = clock_();
+}
+
+void Timeline::schedule(std::int64_t delay, Step step, void *context)
+{
+    sync();
+    steps_.push({now_ + static_cast<double>(std::max<std::int64_t>(delay, 0)), sequence_++, step, context});
+}
+
+void Timeline::clear()
+{
+    steps_ = decltype(steps_)();
+}
+
+bool Timeline::empty() const
+{
+    return steps_.empty();
+}
+
+double Timeline::speed() const
+{
+    return speed_;
+}
+
+void Timeline::setSpeed(double speed)
+{
+    if (speed <= 0) return;
+    sync();
+    speed_ = speed;
+}
+
+bool Timeline::paused() const
+{
+    return paused_;
+}
+
+void Timeline::setPaused(bool paused)
+{
+    sync();
+    paused_ = paused;
+}
+
+bool Timeline::instant() const
+{
+    return instant_;
+}
+
+void Timeline::setInstant(bool instant)
+{
+    sync();
+    instant_ = instant;
+}
+
+std::int64_t Timeline::now() const
+{
+    return static_cast<std::int64_t>(now_);
+}
+
+std::int64_t Timeline::advance()
+{
+    if (advancing_) return timeUntilNext();
+
+    // Steps run at the time they were due, which may be earlier than the real time if the event loop was late
+    const auto before = now_;
+    sync();
+    const auto target = now_;
+    now_ = before;
+
+    advancing_ = true;
+    for (auto run = 0; run < MAX_STEPS && !paused_ && !steps_.empty() && (instant_ || steps_.top().due <= target); run++)
+    {
+        // The step may schedule others, so it is taken out of the queue before running it
+        const auto entry = steps_.top();
+        now_ = std::max(now_, entry.due);
+        steps_.pop();
+        entry.step(entry.context);
+    }
+    advancing_ = false;
+
+    now_ = std::max(now_, target);
+    return timeUntilNext();
+}
+
+std::int64_t Timeline::timeUntilNext()
+{
+    if (steps_.empty() || paused_) return -1;
+    if (instant_) return 0;
+
+    sync();
+    const auto remaining = steps_.top().due - now_;
+    return remaining > 0 ? static_cast<std::int64_t>(std::ceil(remaining / speed_)) : 0;
+}
+
+void Timeline::sync()
+{
+    const auto real = clock_();
+    if (!advancing_ && !paused_) now_ += static_cast<double>(real - lastReal_) * speed_;
+    if (!advancing_) lastReal_ = real;
+}
@@ -0,0 +1,105 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+/// The clock of a game shown on screen, which every delay of the game is measured on. It runs at a multiple of
+/// the real time that can be changed at any moment, can be paused, and can also run instantly, with every step
+/// run right after the previous one no matter its delay.
+///
+/// Steps are run in the order of their time, and a step scheduled from another one is timed from the time the
+/// first one was due rather than from when it actually ran, so the times of the game do not drift with the
+/// latency of the event loop. Whoever owns the timeline calls advance() when the next step is due (e.g. from a
+/// single-shot timer), and steps due at the same time run one after another within the same call
+class Timeline
+{
+public:
+    /// A step is a plain function called with the context it was scheduled with, so scheduling one never allocates
+    /// memory besides the queue itself, which keeps its capacity
+    using Step = void (*)(void *context);
+
+    /// Real time in milliseconds, from any fixed origin
+    using Clock = std::function<std::int64_t()>;
+
+    /// Without a clock, the time of std::chrono::steady_clock is used
+    explicit Timeline(Clock clock = nullptr);
+
+    /// Runs the step once the given time (in milliseconds of game time) has passed
+    void schedule(std::int64_t delay, Step step, void *context);
+
+    /// Same as above with an object callable without arguments, such as a lambda. Only its address is stored, so it
+    /// must outlive the step
+    template <typename F>
+    void schedule(std::int64_t delay, F *callable)
+    {
+        schedule(delay, [](void *context) { (*static_cast<F *>(context))(); }, callable);
+    }
+
+    /// Drops every step not run yet
+    void clear();
+
+    bool empty() const;
+
+    /// Game time elapsed for each millisecond of real time. Changing it does not change the game time at which the
+    /// steps already scheduled are due, only how soon that will be
+    double speed() const;
+    void setSpeed(double speed);
+
+    bool paused() const;
+    void setPaused(bool paused);
+
+    bool instant() const;
+    void setInstant(bool instant);
+
+    /// The current game time, in milliseconds since the timeline was created
+    std::int64_t now() const;
+
+    /// Runs the steps that are due, including the ones they schedule if they are due too, up to MAX_STEPS. Returns
+    /// the real time in milliseconds until the next step is due, or -1 if there is none or the timeline is paused
+    std::int64_t advance();
+
+    /// Real time until the next step is due, in the same way as advance() returns it
+    std::int64_t timeUntilNext();
+
+    /// Steps run by a single call to advance, so that an instant game still lets the event loop of its thread
+    /// process other events every now and then
+    static constexpr int MAX_STEPS = 1000;
+
+private:
+    struct Entry
+    {
+        double due;
+
+        /// Order in which the steps were scheduled, which breaks the ties between steps due at the same time
+        std::uint64_t sequence;
+
+        Step step;
+        void *context;
+
+        bool operator>(const Entry &other) const
+        {
+            return due != other.due ? due > other.due : sequence > other.sequence;
+        }
+    };
+
+    Clock clock_;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> steps_;
+    std::uint64_t sequence_ = 0;
+
+    double now_ = 0;
+    std::int64_t lastReal_ = 0;
+    double speed_ = 1;
+    bool paused_ = false;
+    bool instant_ = false;
+
+    /// Whether advance() is running steps, in which case the clock is the time the current step was due
+    bool advancing_ = false;
+
+    /// Moves the game time forward by the real time elapsed since the last call
+    void sync();
+};
+
+#endif // TIMELINE_H
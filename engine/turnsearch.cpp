@@ -0,0 +1,195 @@
+#include "turnsearch.h"
+
+#include "diceprobability.h"
+#include "evaluationcache.h"
+
+template <typename R>
+BasicTurnSearch<R>::BasicTurnSearch(std::shared_ptr<const MapTopology> map, int maxDepth, Mode mode)
+    // Copy mode needs two states per level (one for each outcome), plus the root
+    : arena_(std::move(map), static_cast<std::size_t>(maxDepth) * 2 + 1),
+      maxDepth_(maxDepth),
+      mode_(mode)
+{
+}
+
+template <typename R>
+void BasicTurnSearch<R>::setEvaluation(BasicEvaluationFunction<R> evaluation)
+{
+    evaluation_ = evaluation;
+}
+
+template <typename R>
+void BasicTurnSearch<R>::setCache(EvaluationCache *cache)
+{
+    cache_ = cache;
+}
+
+template <typename R>
+bool BasicTurnSearch<R>::findCached(const BasicGameState<R> &state, int depth, double &value, Result *result) const
+{
+    EvaluationCache::Entry entry;
+    if (!cache_ || !cache_->lookup(state.hash(), depth, entry)) return false;
+
+    value = entry.value;
+    if (result)
+    {
+        result->from = entry.from;
+        result->to = entry.to;
+    }
+    return true;
+}
+
+template <typename R>
+void BasicTurnSearch<R>::storeCached(const BasicGameState<R> &state, int depth, double value, int from, int to)
+{
+    if (!cache_) return;
+
+    EvaluationCache::Entry entry;
+    entry.hash = state.hash();
+    entry.value = static_cast<float>(value);
+    entry.from = static_cast<std::int16_t>(from);
+    entry.to = static_cast<std::int16_t>(to);
+    entry.depth = static_cast<std::uint8_t>(depth);
+    cache_->store(entry);
+}
+
+template <typename R>
+typename BasicTurnSearch<R>::Result BasicTurnSearch<R>::search(const BasicGameState<R> &state)
+{
+    Result result;
+    nodes_ = 0;
+
+    arena_.clear();
+    auto root = arena_.clone(state);
+    const auto player = state.playerTurn();
+
+    if (mode_ == Mode::MakeUnmake)
+        result.value = searchInPlace(root, player, maxDepth_, &result);
+    else
+        result.value = searchCopies(root, player, maxDepth_, &result);
+
+    result.nodes = nodes_;
+    return result;
+}
+
+template <typename R>
+double BasicTurnSearch<R>::searchInPlace(BasicGameState<R> &state, int player, int depth, Result *result)
+{
+    nodes_++;
+
+    auto best = 0.0;
+    if (findCached(state, depth, best, result)) return best;
+
+    // Stopping here is always an option
+    best = evaluation_(state, player);
+    auto bestFrom = -1, bestTo = -1;
+    if (depth == 0 || state.playersLeft() <= 1)
+    {
+        storeCached(state, 0, best, bestFrom, bestTo);
+        return best;
+    }
+
+    const auto &map = state.map();
+    for (auto from = 0; from < state.territoryCount(); from++)
+    {
+        if (state.owner(from) != player || state.numDice(from) < 2) continue;
+
+        for (auto to : map.neighbours(from))
+        {
+            const auto defender = state.owner(to);
+            if (defender == player || defender == BasicGameState<R>::NO_OWNER) continue;
+
+            const auto probability = RulesDiceProbability<R>::attackWins(state.rollCount(from), state.rollCount(to));
+            if (probability < MIN_PROBABILITY) continue;
+
+            AttackUndo undo;
+            state.makeAttackOutcome(from, to, true, undo);
+            const auto won = searchInPlace(state, player, depth - 1, nullptr);
+            state.unmakeAttack(undo);
+
+            state.makeAttackOutcome(from, to, false, undo);
+            const auto lost = searchInPlace(state, player, depth - 1, nullptr);
+            state.unmakeAttack(undo);
+
+            const auto value = probability * won + (1 - probability) * lost;
+            if (value > best)
+            {
+                best = value;
+                bestFrom = from;
+                bestTo = to;
+            }
+        }
+    }
+
+    storeCached(state, depth, best, bestFrom, bestTo);
+    if (result)
+    {
+        result->from = bestFrom;
+        result->to = bestTo;
+    }
+    return best;
+}
+
+template <typename R>
+double BasicTurnSearch<R>::searchCopies(const BasicGameState<R> &state, int player, int depth, Result *result)
+{
+    nodes_++;
+
+    auto best = 0.0;
+    if (findCached(state, depth, best, result)) return best;
+
+    best = evaluation_(state, player);
+    auto bestFrom = -1, bestTo = -1;
+    if (depth == 0 || state.playersLeft() <= 1)
+    {
+        storeCached(state, 0, best, bestFrom, bestTo);
+        return best;
+    }
+
+    const auto &map = state.map();
+    const auto mark = arena_.mark();
+    auto won = arena_.clone(state);
+    auto lost = arena_.clone(state);
+
+    for (auto from = 0; from < state.territoryCount(); from++)
+    {
+        if (state.owner(from) != player || state.numDice(from) < 2) continue;
+
+        for (auto to : map.neighbours(from))
+        {
+            const auto defender = state.owner(to);
+            if (defender == player || defender == BasicGameState<R>::NO_OWNER) continue;
+
+            const auto probability = RulesDiceProbability<R>::attackWins(state.rollCount(from), state.rollCount(to));
+            if (probability < MIN_PROBABILITY) continue;
+
+            AttackUndo undo;
+            won.copyFrom(state);
+            won.makeAttackOutcome(from, to, true, undo);
+            lost.copyFrom(state);
+            lost.makeAttackOutcome(from, to, false, undo);
+
+            const auto value = probability * searchCopies(won, player, depth - 1, nullptr)
+                    + (1 - probability) * searchCopies(lost, player, depth - 1, nullptr);
+            if (value > best)
+            {
+                best = value;
+                bestFrom = from;
+                bestTo = to;
+            }
+        }
+    }
+
+    arena_.rewind(mark);
+
+    storeCached(state, depth, best, bestFrom, bestTo);
+    if (result)
+    {
+        result->from = bestFrom;
+        result->to = bestTo;
+    }
+    return best;
+}
+
+template class BasicTurnSearch<StandardRules>;
+template class BasicTurnSearch<CheatRules>;
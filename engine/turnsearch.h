@@ -0,0 +1,76 @@
+#ifndef TURNSEARCH_H
+#define TURNSEARCH_H
+
+#include "evaluation.h"
+#include "gamestate.h"
+
+class EvaluationCache;
+
+#include <cstdint>
+#include <memory>
+
+/// Depth-first expectimax search over the attack sequences the current player can perform within their
+/// turn. Each attack is expanded into its two outcomes, weighted by their exact probabilities, and every
+/// node can also stop attacking. The search can either apply and revert moves in place (make/unmake) or
+/// clone the state for every child, which is only kept to benchmark both approaches against each other.
+/// The probabilities of the attacks follow the dice each territory rolls under the rules of the state
+template <typename R>
+class BasicTurnSearch
+{
+public:
+    enum class Mode
+    {
+        MakeUnmake,
+        Copy
+    };
+
+    struct Result
+    {
+        /// The best attack to perform now, or -1 if the best option is ending the turn
+        int from = -1;
+        int to = -1;
+
+        /// Expected evaluation after following the best sequence
+        double value = 0;
+
+        /// Number of positions visited
+        std::int64_t nodes = 0;
+    };
+
+    BasicTurnSearch(std::shared_ptr<const MapTopology> map, int maxDepth, Mode mode = Mode::MakeUnmake);
+
+    void setEvaluation(BasicEvaluationFunction<R> evaluation);
+
+    /// Positions already searched deep enough are taken from the cache instead. The cache is not owned by
+    /// the search, so it can be shared with other searches and kept between turns. It must only be shared
+    /// between searches using the same evaluation function
+    void setCache(EvaluationCache *cache);
+
+    /// Searches the best attack for the player whose turn it is. The state is left untouched
+    Result search(const BasicGameState<R> &state);
+
+    /// Attacks whose probability of success is below this are not explored, as they are rarely worth it
+    static constexpr double MIN_PROBABILITY = 0.2;
+
+private:
+    double searchInPlace(BasicGameState<R> &state, int player, int depth, Result *result);
+    double searchCopies(const BasicGameState<R> &state, int player, int depth, Result *result);
+
+    bool findCached(const BasicGameState<R> &state, int depth, double &value, Result *result) const;
+    void storeCached(const BasicGameState<R> &state, int depth, double value, int from, int to);
+
+    BasicStateArena<R> arena_;
+    int maxDepth_;
+    Mode mode_;
+    BasicEvaluationFunction<R> evaluation_ = heuristicEvaluation<R>;
+    EvaluationCache *cache_ = nullptr;
+    std::int64_t nodes_ = 0;
+};
+
+using TurnSearch = BasicTurnSearch<StandardRules>;
+
+// Both are instantiated once in turnsearch.cpp
+extern template class BasicTurnSearch<StandardRules>;
+extern template class BasicTurnSearch<CheatRules>;
+
+#endif // TURNSEARCH_H
@@ -0,0 +1,136 @@
+#include "workstealingpool.h"
+
+namespace
+{
+    /// The pool and the index of the worker running on this thread, so submit() knows which queue to use
+    thread_local const WorkStealingPool *currentPool = nullptr;
+    thread_local int currentWorker = -1;
+}
+
+WorkStealingPool::WorkStealingPool(int threadCount)
+{
+    if (threadCount < 1) threadCount = 1;
+
+    for (auto i = 0; i < threadCount; i++) workers_.emplace_back(new Worker());
+    for (auto i = 0; i < threadCount; i++) threads_.emplace_back(&WorkStealingPool::work, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wakeUp_.notify_all();
+
+    for (auto &thread : threads_) thread.join();
+}
+
+int WorkStealingPool::threadCount() const
+{
+    return static_cast<int>(workers_.size());
+}
+
+void WorkStealingPool::submit(Task *task)
+{
+    const auto count = workers_.size();
+    const auto index = currentPool == this ? static_cast<std::size_t>(currentWorker) : nextQueue_++ % count;
+
+    pending_++;
+    {
+        // Counted while holding the lock, so no worker can take the task before it is counted
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        queued_++;
+        workers_[index]->tasks.push_back(task);
+    }
+
+    // A worker going to sleep checks queued_ after increasing sleeping_, so either it sees the new task or
+    // this sees it sleeping
+    if (sleeping_ > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        wakeUp_.notify_one();
+    }
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    finished_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+std::size_t WorkStealingPool::queueDepth() const
+{
+    return queued_;
+}
+
+std::size_t WorkStealingPool::pending() const
+{
+    return pending_;
+}
+
+std::size_t WorkStealingPool::steals() const
+{
+    return steals_;
+}
+
+WorkStealingPool::Task *WorkStealingPool::take(int index)
+{
+    {
+        auto &own = *workers_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            const auto task = own.tasks.back();
+            own.tasks.pop_back();
+            return task;
+        }
+    }
+
+    const auto count = static_cast<int>(workers_.size());
+    for (auto offset = 1; offset < count; offset++)
+    {
+        auto &other = *workers_[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty())
+        {
+            const auto task = other.tasks.front();
+            other.tasks.pop_front();
+            steals_++;
+            return task;
+        }
+    }
+
+    return nullptr;
+}
+
+void WorkStealingPool::work(int index)
+{
+    currentPool = this;
+    currentWorker = index;
+
+    for (;;)
+    {
+        const auto task = queued_ > 0 ? take(index) : nullptr;
+        if (task)
+        {
+            queued_--;
+            task->run(index);
+
+            if (--pending_ == 0)
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex_);
+                finished_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleeping_++;
+        wakeUp_.wait(lock, [this]() { return stopping_ || queued_ > 0; });
+        sleeping_--;
+        if (stopping_ && queued_ == 0) return;
+    }
+}
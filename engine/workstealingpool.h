@@ -0,0 +1,79 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Thread pool where every worker has its own queue of tasks. Workers take the newest task of their own
+/// queue, which is usually the one that was just rescheduled and still in cache, and when it is empty
+/// they steal the oldest task of another worker. Tasks are not owned by the pool, and a task can
+/// reschedule itself from run() to continue later (e.g. a game playing one turn at a time)
+class WorkStealingPool
+{
+public:
+    class Task
+    {
+    public:
+        virtual ~Task() = default;
+
+        /// Called on one of the workers, whose index is given
+        virtual void run(int worker) = 0;
+    };
+
+    explicit WorkStealingPool(int threadCount);
+
+    /// Waits for the tasks still queued before stopping the workers
+    ~WorkStealingPool();
+
+    int threadCount() const;
+
+    /// Queues a task. From inside a worker it goes to the queue of that worker; from any other thread the
+    /// queues are used in turns
+    void submit(Task *task);
+
+    /// Blocks until every task has finished, including the ones they reschedule
+    void wait();
+
+    /// Number of tasks waiting in the queues
+    std::size_t queueDepth() const;
+
+    /// Number of tasks queued or running
+    std::size_t pending() const;
+
+    /// Number of tasks taken from the queue of another worker
+    std::size_t steals() const;
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task *> tasks;
+    };
+
+    void work(int index);
+    Task *take(int index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> steals_{0};
+    std::atomic<std::size_t> nextQueue_{0};
+
+    /// Idle workers sleep until there is something to do. Submitting only takes this lock when some
+    /// worker is actually sleeping
+    std::atomic<int> sleeping_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable wakeUp_;
+    std::condition_variable finished_;
+    bool stopping_ = false;
+};
+
+#endif // WORKSTEALINGPOOL_H
@@ -0,0 +1,45 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+// Minimal test harness for the engine, which does not depend on Qt and so cannot use QtTest. Every test is a
+// function registered in main.cpp; a failed check prints where it failed and the test goes on, so that a
+// single run shows every broken invariant
+
+#include <cstdio>
+
+/// Number of checks that failed since the start of the current test
+extern int checkFailures;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) \
+        { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            checkFailures++; \
+        } \
+    } while (false)
+
+/// Same as CHECK, but leaves the test at once, for conditions the rest of the test relies on
+#define REQUIRE(condition) \
+    do { \
+        if (!(condition)) \
+        { \
+            std::fprintf(stderr, "%s:%d: REQUIRE(%s) failed\n", __FILE__, __LINE__, #condition); \
+            checkFailures++; \
+            return; \
+        } \
+    } while (false)
+
+void testSpscQueue();
+void testWakeUpQueue();
+void testGameStateUndo();
+void testGameStateHash();
+void testGameStateCheatRules();
+void testAttackCandidates();
+void testEndgameSolver();
+void testMapGenerators();
+void testMapLibrary();
+void testModelEvaluation();
+void testTimeline();
+
+#endif // CHECK_H
@@ -0,0 +1,22 @@
+TEMPLATE = app
+
+TARGET = enginetests
+
+CONFIG += console testcase
+CONFIG -= qt app_bundle
+
+include(../../engine/engine.pri)
+
+HEADERS += \
+    check.h
+
+SOURCES += \
+    main.cpp \
+    tst_attackcandidates.cpp \
+    tst_endgamesolver.cpp \
+    tst_gamestate.cpp \
+    tst_mapgenerator.cpp \
+    tst_maplibrary.cpp \
+    tst_modelevaluation.cpp \
+    tst_spscqueue.cpp \
+    tst_timeline.cpp
@@ -0,0 +1,51 @@
+// Runs the tests of the engine, and exits with the number of tests that failed
+//
+//   enginetests [name]
+//
+// Only the tests whose name contains the given text are run
+
+#include "check.h"
+
+#include <cstring>
+
+int checkFailures = 0;
+
+namespace
+{
+    struct Test
+    {
+        const char *name;
+        void (*function)();
+    };
+
+    const Test TESTS[] = {
+        {"SpscQueue", testSpscQueue},
+        {"WakeUpQueue", testWakeUpQueue},
+        {"GameStateUndo", testGameStateUndo},
+        {"GameStateHash", testGameStateHash},
+        {"GameStateCheatRules", testGameStateCheatRules},
+        {"AttackCandidates", testAttackCandidates},
+        {"EndgameSolver", testEndgameSolver},
+        {"MapGenerators", testMapGenerators},
+        {"MapLibrary", testMapLibrary},
+        {"ModelEvaluation", testModelEvaluation},
+        {"Timeline", testTimeline},
+    };
+}
+
+int main(int argc, char *argv[])
+{
+    const char *filter = argc > 1 ? argv[1] : "";
+
+    auto failed = 0;
+    for (const auto &test : TESTS)
+    {
+        if (!std::strstr(test.name, filter)) continue;
+
+        checkFailures = 0;
+        test.function();
+        std::printf("%s %s\n", checkFailures ? "FAIL" : "PASS", test.name);
+        if (checkFailures) failed++;
+    }
+    return failed;
+}
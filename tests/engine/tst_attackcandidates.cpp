@@ -0,0 +1,102 @@
+#include "check.h"
+
+#include "attackcandidates.h"
+#include "mapgenerator.h"
+
+#include <vector>
+
+namespace
+{
+    /// Plays random attacks, with both outcomes, and turn ends on the state, updating the candidates after every
+    /// move and after undoing each of them, and returns whether they always matched the state
+    bool playRandomMoves(GameState state, AttackCandidates &candidates, std::uint64_t seed, int steps)
+    {
+        std::vector<AttackUndo> attacks;
+        std::vector<TurnUndo> turns;
+        std::vector<bool> isAttack;
+
+        Random random(seed);
+        auto matched = candidates.matches(state);
+        for (auto step = 0; step < steps && state.playersLeft() > 1; step++)
+        {
+            // Most of the time one of the attacks listed for the current player, so that the game goes on
+            const auto listed = candidates.attacks(state.playerTurn());
+            if (!listed.empty() && random.bounded(4) != 0)
+            {
+                const auto attack = listed[random.bounded(listed.size())];
+                attacks.emplace_back();
+                if (random.bounded(2)) state.makeAttack(attack.from, attack.to, attacks.back());
+                else state.makeAttackOutcome(attack.from, attack.to, random.bounded(2) != 0, attacks.back());
+                candidates.update(state, attacks.back());
+                isAttack.push_back(true);
+            }
+            else
+            {
+                turns.emplace_back();
+                state.makeEndTurn(turns.back());
+                candidates.update(state, turns.back());
+                isAttack.push_back(false);
+            }
+            matched = matched && candidates.matches(state);
+        }
+
+        for (auto i = isAttack.size(); i-- > 0;)
+        {
+            if (isAttack[i])
+            {
+                state.unmakeAttack(attacks.back());
+                candidates.update(state, attacks.back());
+                attacks.pop_back();
+            }
+            else
+            {
+                state.unmakeEndTurn(turns.back());
+                candidates.update(state, turns.back());
+                turns.pop_back();
+            }
+            matched = matched && candidates.matches(state);
+        }
+        return matched;
+    }
+}
+
+void testAttackCandidates()
+{
+    const auto map = generateGrowthMap(MapSettings(), 7);
+    REQUIRE(map);
+
+    StateArena arena(map, 2);
+    auto state = arena.allocate();
+    AttackCandidates candidates(map);
+
+    for (std::uint64_t seed = 1; seed <= 20; seed++)
+    {
+        state.setup(2 + static_cast<int>(seed % 7), seed);
+        candidates.reset(state);
+        CHECK(candidates.matches(state));
+        CHECK(playRandomMoves(state, candidates, seed, 300));
+        CHECK(candidates.matches(state));
+
+        // Every attack listed is legal and belongs to its player
+        for (auto player = 0; player < state.playerCount(); player++)
+        {
+            for (const auto &attack : candidates.attacks(player))
+            {
+                CHECK(state.owner(attack.from) == player);
+                CHECK(state.owner(attack.to) != player);
+                CHECK(state.numDice(attack.from) >= 2);
+            }
+        }
+    }
+
+    // Territories without an owner are never attacked, nor attack
+    std::vector<std::int8_t> owners(static_cast<std::size_t>(map->territoryCount()));
+    for (std::size_t terr = 0; terr < owners.size(); terr++)
+    {
+        owners[terr] = terr % 5 == 0 ? GameState::NO_OWNER : static_cast<std::int8_t>(terr % 3);
+    }
+    state.setup(3, owners.data(), 11);
+    candidates.reset(state);
+    CHECK(playRandomMoves(state, candidates, 11, 300));
+    CHECK(candidates.matches(state));
+}
@@ -0,0 +1,84 @@
+#include "check.h"
+
+#include "diceprobability.h"
+#include "endgamesolver.h"
+
+#include <cmath>
+
+namespace
+{
+    /// Sets the owner and the dice of every territory, and gives the turn to player 0
+    void setPosition(GameState &state, const std::int8_t *owners, const int *dice)
+    {
+        state.setup(2, owners, 1);
+        for (auto terr = 0; terr < state.territoryCount(); terr++) state.setNumDice(terr, dice[terr]);
+        state.setPlayerTurn(0);
+    }
+}
+
+void testEndgameSolver()
+{
+    // Two territories side by side: the only attack either eliminates the opponent or ends the game for the turn,
+    // since the attacker is left with a single die. Its probability is the whole answer
+    const auto pair = MapTopology::fromCells(2, 1, {0, 1});
+    REQUIRE(pair);
+
+    StateArena pairArena(pair, 1);
+    auto state = pairArena.allocate();
+    const std::int8_t pairOwners[] = {0, 1};
+    for (auto attack = 1; attack <= GameState::MAX_DICE; attack++)
+    {
+        for (auto defense = 1; defense <= GameState::MAX_DICE; defense++)
+        {
+            const int dice[] = {attack, defense};
+            setPosition(state, pairOwners, dice);
+
+            EndgameSolver solver(pair);
+            REQUIRE(solver.applies(state));
+            const auto result = solver.solve(state);
+            CHECK(result.solved);
+            CHECK(std::fabs(result.winProbability - (attack > 1 ? DiceProbability::attackWins(attack, defense) : 0)) < 1e-12);
+            CHECK(attack > 1 ? result.from == 0 && result.to == 1 : result.from == -1 && result.to == -1);
+        }
+    }
+
+    // Two rows of three, with several attacks to choose from and to chain
+    const auto grid = MapTopology::fromCells(3, 2, {0, 1, 2, 3, 4, 5});
+    REQUIRE(grid);
+
+    StateArena gridArena(grid, 1);
+    state = gridArena.allocate();
+    const std::int8_t gridOwners[] = {0, 0, 1, 0, 1, 1};
+    const int gridDice[] = {5, 7, 3, 6, 4, 2};
+    setPosition(state, gridOwners, gridDice);
+
+    EndgameSolver solver(grid);
+    const auto hash = state.hash();
+    const auto first = solver.solve(state);
+    REQUIRE(first.solved);
+    CHECK(first.nodes > 1);
+    CHECK(state.canAttack(first.from, first.to));
+    CHECK(state.hash() == hash);
+
+    // Solving again finds the root in the memo, and must give the same attack without visiting anything
+    const auto second = solver.solve(state);
+    CHECK(second.solved);
+    CHECK(second.nodes == 0);
+    CHECK(second.from == first.from && second.to == first.to);
+    CHECK(std::fabs(second.winProbability - first.winProbability) < 1e-6);
+
+    // A solver that has never seen the position agrees with both
+    EndgameSolver fresh(grid);
+    const auto third = fresh.solve(state);
+    CHECK(third.solved);
+    CHECK(third.from == first.from && third.to == first.to);
+    CHECK(third.winProbability == first.winProbability);
+
+    // Attacks are legal only from territories with two dice or more, so giving all of them one die leaves nothing
+    const int stuck[] = {1, 1, 3, 1, 4, 2};
+    setPosition(state, gridOwners, stuck);
+    const auto none = fresh.solve(state);
+    CHECK(none.solved);
+    CHECK(none.winProbability == 0);
+    CHECK(none.from == -1 && none.to == -1);
+}
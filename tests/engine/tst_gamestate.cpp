@@ -0,0 +1,277 @@
+#include "check.h"
+
+#include "diceprobability.h"
+#include "gamestate.h"
+#include "mapgenerator.h"
+#include "turnsearch.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    template <typename R>
+    bool samePosition(const BasicGameState<R> &first, const BasicGameState<R> &second)
+    {
+        return first.byteSize() == second.byteSize()
+                && std::memcmp(first.data(), second.data(), first.byteSize()) == 0;
+    }
+
+    /// Plays random attacks, with both rolled and forced outcomes, and turn ends, then undoes them one by one. Every
+    /// move is undone back to a copy of the state taken right before it, byte by byte, which includes the random
+    /// generator, the hash and the connected territories restored from the undo entries
+    template <typename R>
+    bool checkUndo(BasicGameState<R> state, BasicStateArena<R> &arena, std::uint64_t seed, int steps)
+    {
+        const auto mark = arena.mark();
+        std::vector<BasicGameState<R>> before;
+        std::vector<AttackUndo> attacks;
+        std::vector<TurnUndo> turns;
+        std::vector<bool> isAttack;
+
+        Random random(seed);
+        for (auto step = 0; step < steps && state.playersLeft() > 1; step++)
+        {
+            before.push_back(arena.clone(state));
+            if (!before.back().isValid()) return false;
+
+            // The first legal attack found from a random territory, or sometimes (and always if there is none) the end
+            // of the turn
+            const auto start = random.bounded(state.territoryCount());
+            auto done = random.bounded(5) == 0;
+            for (auto offset = 0; offset < state.territoryCount() && !done; offset++)
+            {
+                const auto terr = (start + offset) % state.territoryCount();
+                for (auto neighbour : state.map().neighbours(terr))
+                {
+                    if (!state.canAttack(terr, neighbour)) continue;
+                    attacks.emplace_back();
+                    if (random.bounded(2)) state.makeAttack(terr, neighbour, attacks.back());
+                    else state.makeAttackOutcome(terr, neighbour, random.bounded(2) != 0, attacks.back());
+                    isAttack.push_back(true);
+                    done = true;
+                    break;
+                }
+            }
+            if (isAttack.size() < before.size())
+            {
+                turns.emplace_back();
+                state.makeEndTurn(turns.back());
+                isAttack.push_back(false);
+            }
+        }
+
+        auto restored = true;
+        for (auto i = isAttack.size(); i-- > 0;)
+        {
+            if (isAttack[i])
+            {
+                state.unmakeAttack(attacks.back());
+                attacks.pop_back();
+            }
+            else
+            {
+                state.unmakeEndTurn(turns.back());
+                turns.pop_back();
+            }
+            restored = restored && samePosition(state, before[i]);
+        }
+
+        arena.rewind(mark);
+        return restored;
+    }
+}
+
+void testGameStateUndo()
+{
+    const auto map = generateGrowthMap(MapSettings(), 3);
+    REQUIRE(map);
+
+    StateArena arena(map, 400);
+    auto state = arena.allocate();
+    REQUIRE(state.isValid());
+
+    for (std::uint64_t seed = 1; seed <= 20; seed++)
+    {
+        state.setup(2 + static_cast<int>(seed % 7), seed);
+
+        // Copies are the same position, and stay so after the same moves
+        auto copy = arena.clone(state);
+        CHECK(samePosition(state, copy));
+        CHECK(checkUndo(state, arena, seed, 300));
+
+        // Turn ends alone, so that territories fill up with dice and some of them cannot be placed
+        auto turns = arena.clone(state);
+        for (auto turn = 0; turn < 40; turn++)
+        {
+            TurnUndo undo;
+            turns.makeEndTurn(undo);
+        }
+        CHECK(checkUndo(turns, arena, seed + 100, 300));
+
+        copy.copyFrom(state);
+        CHECK(samePosition(state, copy));
+        arena.rewind(1);
+    }
+}
+
+void testGameStateHash()
+{
+    const auto map = generateGrowthMap(MapSettings(), 5);
+    REQUIRE(map);
+
+    StateArena arena(map, 2);
+    auto state = arena.allocate();
+    Random random(5);
+
+    for (std::uint64_t seed = 1; seed <= 20; seed++)
+    {
+        state.setup(2 + static_cast<int>(seed % 7), seed);
+        CHECK(state.hash() == state.computeHash());
+        const auto initial = state.hash();
+
+        // The hash is kept up to date by every move and every undo, also when an attack is undone and played again
+        // with the other outcome
+        std::vector<AttackUndo> attacks;
+        std::vector<TurnUndo> turns;
+        std::vector<bool> isAttack;
+        auto consistent = true;
+        for (auto step = 0; step < 200 && state.playersLeft() > 1; step++)
+        {
+            const auto from = random.bounded(state.territoryCount());
+            const auto neighbours = state.map().neighbours(from);
+            const auto to = neighbours.size() ? neighbours[random.bounded(neighbours.size())] : from;
+            if (state.canAttack(from, to))
+            {
+                attacks.emplace_back();
+                const auto captured = state.makeAttack(from, to, attacks.back());
+                consistent = consistent && state.hash() == state.computeHash();
+                state.unmakeAttack(attacks.back());
+                consistent = consistent && state.hash() == state.computeHash();
+                state.makeAttackOutcome(from, to, !captured, attacks.back());
+                isAttack.push_back(true);
+            }
+            else
+            {
+                turns.emplace_back();
+                state.makeEndTurn(turns.back());
+                isAttack.push_back(false);
+            }
+            consistent = consistent && state.hash() == state.computeHash();
+        }
+
+        for (auto i = isAttack.size(); i-- > 0;)
+        {
+            if (isAttack[i])
+            {
+                state.unmakeAttack(attacks.back());
+                attacks.pop_back();
+            }
+            else
+            {
+                state.unmakeEndTurn(turns.back());
+                turns.pop_back();
+            }
+            consistent = consistent && state.hash() == state.computeHash();
+        }
+        CHECK(consistent);
+        CHECK(state.hash() == initial);
+
+        // Play some turns, so that the setters below start from a position in the middle of a game
+        for (auto turn = 0; turn < 10; turn++)
+        {
+            TurnUndo undo;
+            state.makeEndTurn(undo);
+        }
+
+        // And by the setters, so a position reached in any way has the same hash
+        auto copy = arena.clone(state);
+        const auto terr = random.bounded(state.territoryCount());
+        const auto previousOwner = copy.owner(terr);
+        const auto previousDice = copy.numDice(terr);
+        const auto previousTurn = copy.playerTurn();
+        copy.setOwner(terr, (previousOwner + 1) % copy.playerCount());
+        copy.setNumDice(terr, previousDice % GameState::MAX_DICE + 1);
+        copy.setPlayerTurn((previousTurn + 1) % copy.playerCount());
+        CHECK(copy.hash() == copy.computeHash());
+        CHECK(copy.hash() != state.hash());
+
+        copy.setOwner(terr, previousOwner);
+        copy.setNumDice(terr, previousDice);
+        copy.setPlayerTurn(previousTurn);
+        CHECK(copy.hash() == state.hash());
+        CHECK(copy.hash() == copy.computeHash());
+        arena.rewind(1);
+    }
+}
+
+void testGameStateCheatRules()
+{
+    const auto map = generateGrowthMap(MapSettings(), 7);
+    REQUIRE(map);
+
+    // The standard rules have no humans, so every territory rolls its own dice
+    StateArena standardArena(map, 1);
+    auto standard = standardArena.allocate();
+    standard.setup(2, 7);
+    standard.setHuman(0, true);
+    CHECK(!standard.isHuman(0));
+    for (auto terr = 0; terr < standard.territoryCount(); terr++) CHECK(standard.rollCount(terr) == standard.numDice(terr));
+
+    CheatStateArena arena(map, 400);
+    auto state = arena.allocate();
+    REQUIRE(state.isValid());
+
+    for (std::uint64_t seed = 1; seed <= 10; seed++)
+    {
+        state.setup(2 + static_cast<int>(seed % 3), seed);
+        CHECK(!state.isHuman(0));
+        state.setHuman(0, true);
+        CHECK(state.isHuman(0) && !state.isHuman(1));
+
+        for (auto terr = 0; terr < state.territoryCount(); terr++)
+        {
+            const auto dice = state.numDice(terr);
+            CHECK(state.rollCount(terr) == (state.owner(terr) == 0 ? 1 + dice * 3 / 2 : dice));
+        }
+
+        // Attacks roll the extra dice of the humans, in the same order as GameEngine
+        for (auto terr = 0; terr < state.territoryCount(); terr++)
+        {
+            if (state.owner(terr) != 0) continue;
+            for (auto neighbour : state.map().neighbours(terr))
+            {
+                state.setPlayerTurn(0);
+                if (!state.canAttack(terr, neighbour)) continue;
+
+                auto expected = state.random();
+                const auto attack = expected.roll<CheatRules::DICE_SIDES>(state.rollCount(terr));
+                const auto defense = expected.roll<CheatRules::DICE_SIDES>(state.rollCount(neighbour));
+
+                auto copy = arena.clone(state);
+                AttackUndo undo;
+                int attackScore = 0, defenseScore = 0;
+                CHECK(copy.makeAttack(terr, neighbour, undo, &attackScore, &defenseScore) == (attack > defense));
+                CHECK(attackScore == attack && defenseScore == defense);
+                CHECK(copy.random().state() == expected.state());
+                copy.unmakeAttack(undo);
+                CHECK(samePosition(copy, state));
+                arena.rewind(arena.size() - 1);
+            }
+        }
+
+        CHECK(checkUndo(state, arena, seed, 300));
+        arena.rewind(1);
+    }
+
+    // The search weighs the attacks of the human with the probabilities of their extra dice
+    state.setup(2, 3);
+    state.setHuman(state.playerTurn(), true);
+    const auto hash = state.hash();
+    BasicTurnSearch<CheatRules> search(map, 3);
+    const auto result = search.search(state);
+    CHECK(result.nodes > 0);
+    CHECK(result.from == -1 || state.canAttack(result.from, result.to));
+    CHECK(state.hash() == hash);
+    CHECK(RulesDiceProbability<CheatRules>::attackWins(13, 8) > DiceProbability::attackWins(8, 8));
+}
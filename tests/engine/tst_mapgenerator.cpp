@@ -0,0 +1,70 @@
+#include "check.h"
+
+#include "mapgenerator.h"
+
+#include <cstdint>
+#include <string>
+
+namespace
+{
+    /// FNV-1a over the territory of every cell, which identifies the board
+    std::uint64_t fingerprint(const MapTopology &map)
+    {
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for (auto y = 0; y < map.height(); y++)
+        {
+            for (auto x = 0; x < map.width(); x++)
+            {
+                hash ^= static_cast<std::uint16_t>(map.cellTerritory(x, y));
+                hash *= 0x100000001b3ull;
+            }
+        }
+        return hash;
+    }
+}
+
+void testMapGenerators()
+{
+    CHECK(createMapGenerator("voronoi"));
+    CHECK(createMapGenerator("voronoi:relax=0"));
+    CHECK(createMapGenerator("voronoi:relax=16"));
+    CHECK(!createMapGenerator("voronoi:relax="));
+    CHECK(!createMapGenerator("voronoi:relax=x"));
+    CHECK(!createMapGenerator("voronoi:relax=2x"));
+    CHECK(!createMapGenerator("voronoi:relax=17"));
+    CHECK(!createMapGenerator("voronoi:relax=-1"));
+    CHECK(!createMapGenerator("unknown"));
+
+    MapSettings settings;
+    CHECK(settings.isValid());
+    settings.width = MapSettings::MAX_SIDE + 1;
+    CHECK(!settings.isValid());
+    settings.width = MapSettings::MAX_SIDE;
+    settings.height = MapSettings::MAX_SIDE;
+    CHECK(!settings.isValid());
+
+    // The same seed must give the same board on every machine, as both peers of a network game generate it. The
+    // fingerprints were taken once; a different one means the generator changed, or rounds differently here
+    const struct
+    {
+        const char *generator;
+        std::uint64_t fingerprint;
+    } EXPECTED[] = {
+        {"growth", 0x76ddcff9a21d0159ull},
+        {"grid", 0xbe4392920f1e9c40ull},
+        {"voronoi", 0x7a390d9b5da2ebbeull},
+        {"flood", 0x01af2392071e35eaull},
+    };
+    for (const auto &expected : EXPECTED)
+    {
+        const auto generator = createMapGenerator(expected.generator);
+        REQUIRE(generator);
+        CHECK(generator->name() == expected.generator);
+
+        const auto first = generator->generate(MapSettings(), 12345);
+        const auto second = createMapGenerator(expected.generator)->generate(MapSettings(), 12345);
+        REQUIRE(first && second);
+        CHECK(fingerprint(*first) == fingerprint(*second));
+        CHECK(fingerprint(*first) == expected.fingerprint);
+    }
+}
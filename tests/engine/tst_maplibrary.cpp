@@ -0,0 +1,122 @@
+#include "check.h"
+
+#include "maplibrary.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    bool sameMap(const MapTopology &first, const MapTopology &second)
+    {
+        if (first.width() != second.width() || first.height() != second.height()
+                || first.territoryCount() != second.territoryCount() || first.cellTerritories() != second.cellTerritories())
+        {
+            return false;
+        }
+
+        for (auto terr = 0; terr < first.territoryCount(); terr++)
+        {
+            const auto a = first.neighbours(terr);
+            const auto b = second.neighbours(terr);
+            if (a.size() != b.size() || !std::equal(a.begin(), a.end(), b.begin())) return false;
+            if (first.cellCount(terr) != second.cellCount(terr)) return false;
+            if (first.center(terr).x != second.center(terr).x || first.center(terr).y != second.center(terr).y) return false;
+        }
+        return true;
+    }
+
+    /// The file read back into memory aligned like a mapped file
+    std::vector<std::uint64_t> readFile(const char *fileName, std::size_t &size)
+    {
+        std::vector<std::uint64_t> data;
+        size = 0;
+        auto file = std::fopen(fileName, "rb");
+        if (!file) return data;
+
+        std::fseek(file, 0, SEEK_END);
+        size = static_cast<std::size_t>(std::ftell(file));
+        std::fseek(file, 0, SEEK_SET);
+        data.resize(size / sizeof(std::uint64_t) + 1);
+        if (std::fread(data.data(), 1, size, file) != size) size = 0;
+        std::fclose(file);
+        return data;
+    }
+}
+
+void testMapLibrary()
+{
+    MapSettings settings;
+    settings.width = 30;
+    settings.height = 20;
+    settings.numTerritories = 20;
+
+    std::vector<std::shared_ptr<const MapTopology>> maps;
+    for (std::uint64_t seed = 1; seed <= 3; seed++) maps.push_back(generateGrowthMap(settings, seed));
+    REQUIRE(maps.back());
+
+    const auto fileName = "enginetests_maplibrary.tmp";
+    REQUIRE(MapLibrary::write(fileName, settings, maps));
+    std::size_t size;
+    auto data = readFile(fileName, size);
+    std::remove(fileName);
+    REQUIRE(size > 0);
+
+    // The maps are built from the stored adjacency and centers, and must be the ones written
+    const MapLibrary library(data.data(), size);
+    REQUIRE(library.isValid());
+    CHECK(library.mapCount() == 3);
+    for (auto i = 0; i < 3; i++)
+    {
+        const auto map = library.topology(i);
+        REQUIRE(map);
+        CHECK(sameMap(*map, *maps[static_cast<std::size_t>(i)]));
+    }
+    CHECK(!library.topology(-1));
+    CHECK(!library.topology(3));
+
+    // Damaging the data in place, following the layout described in MapLibrary: a 40-byte header, then the index
+    const auto bytes = reinterpret_cast<std::uint8_t *>(data.data());
+    const auto index = bytes + 40;
+    std::uint64_t offset;
+    std::memcpy(&offset, index, sizeof(offset));
+
+    // An offset that would wrap around when the size of the record is added to it
+    const std::uint64_t wrapping = ~static_cast<std::uint64_t>(3);
+    std::memcpy(index, &wrapping, sizeof(wrapping));
+    CHECK(!library.map(0).isValid());
+    CHECK(!library.topology(0));
+    std::memcpy(index, &offset, sizeof(offset));
+    CHECK(library.topology(0));
+
+    // A cell of a territory the record does not declare
+    const auto territoryCount = maps[0]->territoryCount();
+    const auto record = bytes + offset;
+    const auto cells = reinterpret_cast<std::int16_t *>(record + 8);
+    const auto cell = cells[0];
+    cells[0] = static_cast<std::int16_t>(territoryCount);
+    CHECK(!library.topology(0));
+    cells[0] = cell;
+
+    // Adjacency lists that are not symmetric: the first neighbour of the first territory is replaced by another one
+    const auto offsets = reinterpret_cast<const std::uint32_t *>(record + 8 + (settings.width * settings.height * 2 + 3) / 4 * 4);
+    const auto neighbours = reinterpret_cast<std::uint16_t *>(record + 8 + (settings.width * settings.height * 2 + 3) / 4 * 4
+                                                              + (territoryCount + 1) * 4 + territoryCount * 8);
+    REQUIRE(offsets[1] > 0);
+    const auto neighbour = neighbours[0];
+    auto other = 1;
+    while (maps[0]->adjacent(0, other)) other++;
+    neighbours[0] = static_cast<std::uint16_t>(other);
+    CHECK(!library.topology(0));
+    neighbours[0] = neighbour;
+    CHECK(library.topology(0));
+
+    // Neighbour lists reaching past the neighbours of the record
+    auto counts = reinterpret_cast<std::uint32_t *>(record);
+    counts[1] += 1000000;
+    CHECK(!library.map(0).isValid());
+    counts[1] -= 1000000;
+    CHECK(library.topology(0));
+}
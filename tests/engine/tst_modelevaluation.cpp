@@ -0,0 +1,99 @@
+#include "check.h"
+
+#include "mapgenerator.h"
+#include "modelevaluation.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    /// Writes a network with random weights of both signs, so that the ReLU of the hidden layer clips some of
+    /// the units, which the hand-tuned weights never do
+    bool writeRandomModel(const char *fileName, int hidden, std::uint64_t seed)
+    {
+        auto file = std::fopen(fileName, "w");
+        if (!file) return false;
+
+        Random random(seed);
+        const auto weight = [&random]() { return (random.bounded(2001) - 1000) / 1000.0; };
+
+        std::fprintf(file, "dicewars-model 1\nhidden %d\n", hidden);
+        for (auto h = 0; h < hidden; h++)
+        {
+            for (auto f = 0; f <= ModelEvaluator::FEATURES; f++) std::fprintf(file, "%.3f ", weight());
+            std::fprintf(file, "\n");
+        }
+        for (auto h = 0; h <= hidden; h++) std::fprintf(file, "%.3f ", weight());
+        std::fprintf(file, "\n");
+        return std::fclose(file) == 0;
+    }
+}
+
+void testModelEvaluation()
+{
+    const auto map = generateGrowthMap(MapSettings(), 11);
+    REQUIRE(map);
+
+    // A batch of positions from different games and moments, with a count that leaves padding rows
+    StateArena arena(map, 13);
+    std::vector<GameState> states;
+    for (std::uint64_t seed = 1; seed <= 13; seed++)
+    {
+        states.push_back(arena.allocate());
+        states.back().setup(2 + static_cast<int>(seed % 5), seed);
+        for (auto turn = 0; turn < static_cast<int>(seed); turn++)
+        {
+            TurnUndo undo;
+            states.back().makeEndTurn(undo);
+        }
+    }
+    const auto count = static_cast<int>(states.size());
+
+    const auto fileName = "tst_modelevaluation.model";
+    REQUIRE(writeRandomModel(fileName, 19, 11));
+    ModelEvaluator evaluator;
+    const auto loaded = evaluator.load(fileName);
+    std::remove(fileName);
+    REQUIRE(loaded);
+
+    // Nothing is cached by an evaluator that has not evaluated anything yet
+    const auto pristine = evaluator;
+
+    // Every kernel the processor supports gives the same values as the scalar one, up to rounding: the AVX2 one
+    // fuses the multiply-adds, so its values are not bit-identical
+    REQUIRE(evaluator.setKernel(ModelEvaluator::Kernel::Scalar));
+    std::vector<float> expected(count);
+    evaluator.evaluate(states.data(), count, 0, expected.data());
+
+    for (auto kernel : {ModelEvaluator::Kernel::Sse, ModelEvaluator::Kernel::Avx2})
+    {
+        if (!evaluator.setKernel(kernel)) continue;
+
+        std::vector<float> values(count);
+        evaluator.evaluate(states.data(), count, 0, values.data());
+        for (auto i = 0; i < count; i++) CHECK(std::fabs(values[i] - expected[i]) <= 1e-4f * (1 + std::fabs(expected[i])));
+
+        // A position alone is padded differently, but still gives its value in the batch
+        CHECK(std::fabs(evaluator.evaluate(states[5], 0) - values[5]) <= 1e-4f * (1 + std::fabs(values[5])));
+    }
+
+    // A map built after the previous one is gone gets its own adjacency, even if it is allocated at the same address
+    evaluator.setKernel(ModelEvaluator::bestKernel());
+    states.clear();
+    arena.clear();
+    for (std::uint64_t seed = 20; seed < 30; seed++)
+    {
+        const auto other = generateGrowthMap(MapSettings(), seed);
+        REQUIRE(other);
+
+        StateArena otherArena(other, 1);
+        auto state = otherArena.allocate();
+        state.setup(3, seed);
+
+        auto fresh = pristine;
+        fresh.setKernel(ModelEvaluator::bestKernel());
+        CHECK(evaluator.evaluate(state, 1) == fresh.evaluate(state, 1));
+    }
+}
@@ -0,0 +1,182 @@
+#include "check.h"
+
+#include "spscqueue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace
+{
+    /// Values sent from one thread to another, enough for the indices to wrap around the buffer many times
+    constexpr std::uint32_t THREADED_VALUES = 1000000;
+
+    void checkFullAndEmpty()
+    {
+        SpscQueue<int> queue(5);
+        REQUIRE(queue.capacity() == 8);
+
+        auto value = -1;
+        CHECK(!queue.pop(value));
+        CHECK(value == -1);
+
+        for (auto i = 0; i < 8; i++) CHECK(queue.push(i));
+        CHECK(queue.size() == 8);
+        CHECK(!queue.push(8));
+
+        // A value taken makes room for exactly one more
+        CHECK(queue.pop(value));
+        CHECK(value == 0);
+        CHECK(queue.push(8));
+        CHECK(!queue.push(9));
+
+        for (auto i = 1; i <= 8; i++)
+        {
+            CHECK(queue.pop(value));
+            CHECK(value == i);
+        }
+        CHECK(!queue.pop(value));
+        CHECK(queue.size() == 0);
+    }
+
+    void checkWrapAround()
+    {
+        SpscQueue<int> queue(4);
+
+        // Three values at a time never fill the buffer, and start at a different slot every round
+        auto next = 0, expected = 0;
+        for (auto round = 0; round < 50; round++)
+        {
+            for (auto i = 0; i < 3; i++) CHECK(queue.push(next++));
+            CHECK(queue.size() == 3);
+
+            auto value = -1;
+            for (auto i = 0; i < 3; i++)
+            {
+                CHECK(queue.pop(value));
+                CHECK(value == expected++);
+            }
+            CHECK(!queue.pop(value));
+        }
+
+        // Full buffers across the wrap-around too
+        for (auto round = 0; round < 10; round++)
+        {
+            for (auto i = 0; i < 4; i++) CHECK(queue.push(next++));
+            CHECK(!queue.push(next));
+
+            auto value = -1;
+            for (auto i = 0; i < 4; i++)
+            {
+                CHECK(queue.pop(value));
+                CHECK(value == expected++);
+            }
+            CHECK(!queue.pop(value));
+        }
+    }
+
+    void checkThreads()
+    {
+        SpscQueue<std::uint32_t> queue(64);
+
+        std::thread producer([&queue]()
+        {
+            for (std::uint32_t i = 0; i < THREADED_VALUES; i++)
+            {
+                while (!queue.push(i)) std::this_thread::yield();
+            }
+        });
+
+        // Every value must arrive exactly once and in order
+        auto inOrder = true;
+        for (std::uint32_t expected = 0; expected < THREADED_VALUES;)
+        {
+            std::uint32_t value;
+            if (!queue.pop(value))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            if (value != expected++) inOrder = false;
+        }
+        producer.join();
+
+        CHECK(inOrder);
+        CHECK(queue.size() == 0);
+    }
+}
+
+void testSpscQueue()
+{
+    checkFullAndEmpty();
+    checkWrapAround();
+    checkThreads();
+}
+
+void testWakeUpQueue()
+{
+    {
+        WakeUpQueue<int> queue(4);
+        auto value = -1;
+
+        // Only the first value pushed since the consumer found the queue empty needs a wake-up
+        CHECK(queue.push(1));
+        CHECK(queue.needsWakeUp());
+        CHECK(queue.push(2));
+        CHECK(!queue.needsWakeUp());
+
+        CHECK(queue.pop(value));
+        CHECK(value == 1);
+        CHECK(queue.push(3));
+        CHECK(!queue.needsWakeUp());
+
+        CHECK(queue.pop(value));
+        CHECK(queue.pop(value));
+        CHECK(value == 3);
+        CHECK(!queue.pop(value));
+
+        CHECK(queue.push(4));
+        CHECK(queue.needsWakeUp());
+    }
+
+    // A consumer that only pops after a wake-up, like the board with eventsPublished, must get every value
+    WakeUpQueue<std::uint32_t> queue(64);
+    std::atomic<std::uint32_t> wakeUps(0);
+    std::atomic<bool> finished(false);
+
+    std::thread producer([&]()
+    {
+        for (std::uint32_t i = 0; i < THREADED_VALUES; i++)
+        {
+            while (!queue.push(i)) std::this_thread::yield();
+            if (queue.needsWakeUp()) wakeUps++;
+        }
+        finished = true;
+    });
+
+    std::uint32_t received = 0, handled = 0;
+    auto inOrder = true;
+    for (;;)
+    {
+        const auto done = finished.load();
+        if (wakeUps.load() == handled)
+        {
+            // No wake-up left and the producer is done: anything still queued was stranded
+            if (done) break;
+            std::this_thread::yield();
+            continue;
+        }
+
+        handled++;
+        std::uint32_t value;
+        while (queue.pop(value))
+        {
+            if (value != received++) inOrder = false;
+        }
+    }
+    producer.join();
+
+    CHECK(inOrder);
+    CHECK(received == THREADED_VALUES);
+    CHECK(queue.size() == 0);
+}
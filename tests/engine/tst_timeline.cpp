@@ -0,0 +1,213 @@
+#include "check.h"
+
+#include "timeline.h"
+
+#include <functional>
+#include <vector>
+
+namespace
+{
+    /// Real time of the tests, only moved by hand
+    struct FakeClock
+    {
+        std::int64_t real = 1000;
+
+        Timeline::Clock clock() { return [this]() { return real; }; }
+    };
+
+    /// A step that records the game time it ran at
+    struct Record
+    {
+        int id;
+        std::int64_t time;
+    };
+
+    void checkOrder()
+    {
+        FakeClock clock;
+        Timeline timeline(clock.clock());
+        std::vector<Record> records;
+        auto record = [&](int id) { return [&records, &timeline, id]() { records.push_back({id, timeline.now()}); }; };
+
+        CHECK(timeline.empty());
+        CHECK(timeline.advance() == -1);
+
+        // Steps due at the same time run in the order they were scheduled
+        auto first = record(1), second = record(2), third = record(3), fourth = record(4);
+        timeline.schedule(200, &first);
+        timeline.schedule(100, &second);
+        timeline.schedule(200, &third);
+        timeline.schedule(-5, &fourth);
+        CHECK(timeline.timeUntilNext() == 0);
+
+        CHECK(timeline.advance() == 100);
+        REQUIRE(records.size() == 1);
+        CHECK(records[0].id == 4 && records[0].time == 0);
+
+        clock.real += 99;
+        CHECK(timeline.advance() == 1);
+        CHECK(records.size() == 1);
+
+        clock.real += 150;
+        CHECK(timeline.advance() == -1);
+        REQUIRE(records.size() == 4);
+        CHECK(records[1].id == 2 && records[1].time == 100);
+        CHECK(records[2].id == 1 && records[2].time == 200);
+        CHECK(records[3].id == 3 && records[3].time == 200);
+        CHECK(timeline.now() == 249);
+        CHECK(timeline.empty());
+    }
+
+    void checkNoDrift()
+    {
+        FakeClock clock;
+        Timeline timeline(clock.clock());
+        std::vector<std::int64_t> times;
+
+        // A step scheduling the next one from itself, like the animations of a game
+        std::function<void()> tick = [&]()
+        {
+            times.push_back(timeline.now());
+            if (times.size() < 5) timeline.schedule(30, &tick);
+        };
+        timeline.schedule(500, &tick);
+
+        // The event loop is always late by 10 ms, which must not add up
+        for (auto due : {500, 530, 560, 590, 620})
+        {
+            clock.real = 1000 + due + 10;
+            timeline.advance();
+        }
+
+        REQUIRE(times.size() == 5);
+        for (auto i = 0; i < 5; i++) CHECK(times[static_cast<std::size_t>(i)] == 500 + 30 * i);
+        CHECK(timeline.now() == 630);
+    }
+
+    void checkContext()
+    {
+        FakeClock clock;
+        Timeline timeline(clock.clock());
+        int counters[2] = {};
+
+        // A plain function gets back the context it was scheduled with
+        const auto increment = [](void *context) { ++*static_cast<int *>(context); };
+        timeline.schedule(10, increment, &counters[1]);
+        timeline.schedule(20, increment, &counters[0]);
+        timeline.schedule(20, increment, &counters[1]);
+
+        clock.real += 20;
+        timeline.advance();
+        CHECK(counters[0] == 1 && counters[1] == 2);
+        CHECK(timeline.empty());
+    }
+
+    void checkSpeed()
+    {
+        FakeClock clock;
+        Timeline timeline(clock.clock());
+        auto ran = 0;
+        auto step = [&ran]() { ran++; };
+
+        timeline.schedule(100, &step);
+        CHECK(timeline.timeUntilNext() == 100);
+
+        // Half the game time has passed, and the other half goes twice as fast
+        clock.real += 50;
+        timeline.setSpeed(2);
+        CHECK(timeline.speed() == 2);
+        CHECK(timeline.now() == 50);
+        CHECK(timeline.timeUntilNext() == 25);
+
+        // Speeds that are not positive are ignored
+        timeline.setSpeed(0);
+        timeline.setSpeed(-1);
+        CHECK(timeline.speed() == 2);
+
+        clock.real += 24;
+        CHECK(timeline.advance() == 1);
+        CHECK(ran == 0);
+
+        clock.real += 1;
+        CHECK(timeline.advance() == -1);
+        CHECK(ran == 1);
+        CHECK(timeline.now() == 100);
+    }
+
+    void checkPause()
+    {
+        FakeClock clock;
+        Timeline timeline(clock.clock());
+        auto ran = 0;
+        auto step = [&ran]() { ran++; };
+
+        timeline.schedule(100, &step);
+        clock.real += 40;
+        timeline.setPaused(true);
+        CHECK(timeline.paused());
+
+        // No game time passes while paused, and nothing runs
+        clock.real += 1000;
+        CHECK(timeline.advance() == -1);
+        CHECK(timeline.timeUntilNext() == -1);
+        CHECK(ran == 0);
+        CHECK(timeline.now() == 40);
+
+        timeline.setPaused(false);
+        CHECK(timeline.timeUntilNext() == 60);
+        clock.real += 60;
+        timeline.advance();
+        CHECK(ran == 1);
+        CHECK(timeline.now() == 100);
+
+        // Steps can be dropped before they run
+        timeline.schedule(10, &step);
+        timeline.clear();
+        CHECK(timeline.empty());
+        clock.real += 10;
+        CHECK(timeline.advance() == -1);
+        CHECK(ran == 1);
+    }
+
+    void checkInstant()
+    {
+        FakeClock clock;
+        Timeline timeline(clock.clock());
+        timeline.setInstant(true);
+        CHECK(timeline.instant());
+
+        // Every step runs without any real time passing, but the game time still follows their delays
+        std::vector<std::int64_t> times;
+        std::function<void()> step = [&]()
+        {
+            times.push_back(timeline.now());
+            timeline.schedule(1000, &step);
+        };
+        timeline.schedule(1000, &step);
+
+        // A single call never runs more than MAX_STEPS, so the owner can let other events through
+        CHECK(timeline.advance() == 0);
+        REQUIRE(times.size() == static_cast<std::size_t>(Timeline::MAX_STEPS));
+        CHECK(times.front() == 1000);
+        CHECK(times.back() == 1000 * static_cast<std::int64_t>(Timeline::MAX_STEPS));
+
+        timeline.advance();
+        CHECK(times.size() == static_cast<std::size_t>(2 * Timeline::MAX_STEPS));
+
+        // Back to real time, the next step is due a whole delay later
+        timeline.setInstant(false);
+        CHECK(timeline.timeUntilNext() == 1000);
+        timeline.setPaused(true);
+        CHECK(timeline.advance() == -1);
+    }
+}
+
+void testTimeline()
+{
+    checkOrder();
+    checkNoDrift();
+    checkContext();
+    checkSpeed();
+    checkPause();
+    checkInstant();
+}
@@ -0,0 +1,17 @@
+TEMPLATE = app
+
+TARGET = botserver
+
+CONFIG += console
+CONFIG -= qt app_bundle
+
+include(../../engine/engine.pri)
+
+HEADERS += \
+    linewriter.h \
+    botsession.h
+
+SOURCES += \
+    main.cpp \
+    linewriter.cpp \
+    botsession.cpp
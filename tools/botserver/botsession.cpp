@@ -0,0 +1,353 @@
+#include "botsession.h"
+
+#include "mapgenerator.h"
+#include "match.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace
+{
+    /// Finds "key": in a flat JSON object and returns a pointer to its value, or nullptr if it is not there.
+    /// Nested objects and escaped strings are not supported, as the commands never need them
+    const char *findValue(const char *line, const char *key)
+    {
+        const auto length = std::strlen(key);
+        for (auto quote = std::strchr(line, '"'); quote; quote = std::strchr(quote + 1, '"'))
+        {
+            if (std::strncmp(quote + 1, key, length) != 0 || quote[length + 1] != '"') continue;
+
+            auto value = quote + length + 2;
+            while (*value == ' ' || *value == '\t') value++;
+            if (*value != ':') continue;
+            value++;
+            while (*value == ' ' || *value == '\t') value++;
+            return value;
+        }
+        return nullptr;
+    }
+
+    bool readInt(const char *line, const char *key, int &value)
+    {
+        const auto text = findValue(line, key);
+        if (!text) return false;
+
+        char *end = nullptr;
+        const auto result = std::strtol(text, &end, 10);
+        if (end == text) return false;
+        value = static_cast<int>(result);
+        return true;
+    }
+
+    /// Reads a string starting at the opening quote, returning a pointer past the closing one
+    const char *readString(const char *text, std::string &value)
+    {
+        if (*text != '"') return nullptr;
+        const auto end = std::strchr(text + 1, '"');
+        if (!end) return nullptr;
+        value.assign(text + 1, end);
+        return end + 1;
+    }
+
+    bool readStringArray(const char *line, const char *key, std::vector<std::string> &values)
+    {
+        auto text = findValue(line, key);
+        if (!text || *text++ != '[') return false;
+
+        values.clear();
+        for (;;)
+        {
+            while (*text == ' ' || *text == '\t' || *text == ',') text++;
+            if (*text == ']') return true;
+
+            values.emplace_back();
+            text = readString(text, values.back());
+            if (!text) return false;
+        }
+    }
+}
+
+BotSession::BotSession(std::FILE *output) : output_(output)
+{
+}
+
+bool BotSession::processLine(const char *line)
+{
+    std::string command;
+    const auto value = findValue(line, "cmd");
+    if (!value || !readString(value, command))
+    {
+        writeError("missing command");
+    }
+    else if (command == "quit")
+    {
+        return false;
+    }
+    else if (command == "new")
+    {
+        newGame(line);
+    }
+    else if (!state_.isValid())
+    {
+        writeError("no game started");
+    }
+    else if (command == "attack")
+    {
+        attack(line);
+    }
+    else if (command == "end")
+    {
+        endTurn();
+    }
+    else if (command == "state")
+    {
+        writeState();
+    }
+    else
+    {
+        writeError("unknown command");
+    }
+
+    return writer_.flush(output_);
+}
+
+void BotSession::newGame(const char *line)
+{
+    int seed = 1;
+    readInt(line, "seed", seed);
+    auto mapSeed = seed;
+    readInt(line, "mapSeed", mapSeed);
+
+    MapSettings settings;
+    readInt(line, "width", settings.width);
+    readInt(line, "height", settings.height);
+    readInt(line, "territories", settings.numTerritories);
+    readInt(line, "size", settings.territorySize);
+
+    // The settings come from the client, so they are checked here too rather than trusting the generator with them
+    if (!settings.isValid())
+    {
+        writeError("invalid map settings");
+        return;
+    }
+
+    std::vector<std::string> seats;
+    if (!readStringArray(line, "seats", seats)) seats = {"bot", "greedy", "greedy", "greedy"};
+    const auto playerCount = static_cast<int>(seats.size());
+    if (playerCount < 2 || playerCount > GameState::MAX_PLAYERS)
+    {
+        writeError("invalid number of seats");
+        return;
+    }
+
+    auto map = generateGrowthMap(settings, static_cast<std::uint64_t>(mapSeed));
+    if (!map || map->territoryCount() < playerCount)
+    {
+        writeError("invalid map settings");
+        return;
+    }
+
+    std::vector<std::unique_ptr<Policy>> policies;
+    for (auto seat = 0; seat < playerCount; seat++)
+    {
+        if (seats[seat] == "bot")
+        {
+            policies.emplace_back();
+            continue;
+        }
+
+        policies.push_back(createPolicy(seats[seat], map, static_cast<std::uint64_t>(seed) + seat));
+        if (!policies.back())
+        {
+            writeError("invalid seat");
+            return;
+        }
+    }
+
+    map_ = std::move(map);
+    policies_ = std::move(policies);
+    arena_.reset(new StateArena(map_, 1));
+    state_ = arena_->allocate();
+    state_.setup(playerCount, static_cast<std::uint64_t>(seed));
+    turns_ = 0;
+
+    writeMap();
+    playPolicies();
+    writeState();
+}
+
+void BotSession::attack(const char *line)
+{
+    int from, to;
+    if (!readInt(line, "from", from) || !readInt(line, "to", to))
+    {
+        writeError("missing territories");
+        return;
+    }
+
+    // canAttack checks the territories are inside the map, so the indices can come straight from the client
+    if (gameOver() || !state_.canAttack(from, to))
+    {
+        writeError("illegal attack");
+        return;
+    }
+
+    AttackUndo undo;
+    int attackScore, defenseScore;
+    const auto captured = state_.makeAttack(from, to, undo, &attackScore, &defenseScore);
+    writeAttack(from, to, attackScore, defenseScore, captured);
+    writeState();
+}
+
+void BotSession::endTurn()
+{
+    if (gameOver())
+    {
+        writeError("game over");
+        return;
+    }
+
+    const auto player = state_.playerTurn();
+    TurnUndo undo;
+    state_.makeEndTurn(undo);
+    turns_++;
+
+    writer_.begin("endTurn");
+    writer_.field("player", player);
+    writer_.end();
+
+    playPolicies();
+    writeState();
+}
+
+void BotSession::playPolicies()
+{
+    while (!gameOver())
+    {
+        const auto player = state_.playerTurn();
+        auto policy = policies_[player].get();
+        if (!policy) return;
+
+        int from, to;
+        for (auto attack = 0; attack < Match::MAX_ATTACKS_PER_TURN && policy->chooseAttack(state_, from, to); attack++)
+        {
+            if (!state_.canAttack(from, to)) break;
+
+            AttackUndo undo;
+            int attackScore, defenseScore;
+            const auto captured = state_.makeAttack(from, to, undo, &attackScore, &defenseScore);
+            writeAttack(from, to, attackScore, defenseScore, captured);
+            if (gameOver()) return;
+        }
+
+        TurnUndo undo;
+        state_.makeEndTurn(undo);
+        turns_++;
+
+        writer_.begin("endTurn");
+        writer_.field("player", player);
+        writer_.end();
+    }
+}
+
+bool BotSession::gameOver() const
+{
+    return state_.playersLeft() <= 1 || turns_ >= Match::MAX_TURNS;
+}
+
+void BotSession::writeMap()
+{
+    const auto count = map_->territoryCount();
+
+    writer_.begin("map");
+    writer_.field("width", map_->width());
+    writer_.field("height", map_->height());
+    writer_.field("territories", count);
+    writer_.field("players", state_.playerCount());
+
+    writer_.beginArray("cellCounts");
+    for (auto terr = 0; terr < count; terr++) writer_.value(map_->cellCount(terr));
+    writer_.endArray();
+
+    writer_.beginArray("neighbours");
+    for (auto terr = 0; terr < count; terr++)
+    {
+        writer_.beginArray();
+        for (auto neighbour : map_->neighbours(terr)) writer_.value(static_cast<int>(neighbour));
+        writer_.endArray();
+    }
+    writer_.endArray();
+
+    writer_.beginArray("centers");
+    for (auto terr = 0; terr < count; terr++)
+    {
+        writer_.beginArray();
+        writer_.value(map_->center(terr).x);
+        writer_.value(map_->center(terr).y);
+        writer_.endArray();
+    }
+    writer_.endArray();
+
+    writer_.end();
+}
+
+void BotSession::writeState()
+{
+    const auto count = state_.territoryCount();
+    const auto players = state_.playerCount();
+
+    auto winner = -1;
+    if (state_.playersLeft() == 1)
+    {
+        for (auto player = 0; player < players; player++)
+        {
+            if (state_.ownedTerritories(player) > 0) winner = player;
+        }
+    }
+
+    writer_.begin("state");
+    writer_.field("turn", state_.playerTurn());
+    writer_.field("turns", turns_);
+    writer_.field("playersLeft", state_.playersLeft());
+    writer_.field("gameOver", gameOver());
+    writer_.field("winner", winner);
+
+    writer_.beginArray("owners");
+    for (auto terr = 0; terr < count; terr++) writer_.value(state_.owner(terr));
+    writer_.endArray();
+
+    writer_.beginArray("dice");
+    for (auto terr = 0; terr < count; terr++) writer_.value(state_.numDice(terr));
+    writer_.endArray();
+
+    writer_.beginArray("connectedTerritories");
+    for (auto player = 0; player < players; player++) writer_.value(state_.connectedTerritories(player));
+    writer_.endArray();
+
+    writer_.beginArray("remainingDice");
+    for (auto player = 0; player < players; player++) writer_.value(state_.remainingDice(player));
+    writer_.endArray();
+
+    writer_.end();
+}
+
+void BotSession::writeAttack(int from, int to, int attack, int defense, bool captured)
+{
+    writer_.begin("attack");
+    writer_.field("player", state_.owner(from));
+    writer_.field("from", from);
+    writer_.field("to", to);
+    writer_.field("attack", attack);
+    writer_.field("defense", defense);
+    writer_.field("captured", captured);
+    writer_.end();
+}
+
+void BotSession::writeError(const char *message)
+{
+    writer_.begin("error");
+    writer_.field("message", message);
+    writer_.end();
+}
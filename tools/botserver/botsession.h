@@ -0,0 +1,62 @@
+#ifndef BOTSESSION_H
+#define BOTSESSION_H
+
+#include "gamestate.h"
+#include "linewriter.h"
+#include "policy.h"
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+/// Plays games for an external bot speaking JSON lines. Every command is a flat JSON object in a single
+/// line, with its name in "cmd":
+///
+///   {"cmd":"new","seed":1,"seats":["bot","greedy","search:depth=1","bot"]}
+///       Starts a game with one player per seat. Optional: "mapSeed" (defaults to "seed"), "width",
+///       "height", "territories", "size". Seats other than "bot" are played by the engine policies
+///   {"cmd":"attack","from":3,"to":7}
+///   {"cmd":"end"}
+///   {"cmd":"state"}
+///   {"cmd":"quit"}
+///
+/// The server answers with "map" after a new game, "attack" and "endTurn" for every move (including the
+/// ones of the engine players), "state" whenever it is the turn of a bot or the game is over, and
+/// "error" for commands it cannot accept, which leave the game untouched
+class BotSession
+{
+    std::FILE *output_;
+    LineWriter writer_;
+
+    std::shared_ptr<const MapTopology> map_;
+    std::unique_ptr<StateArena> arena_;
+    GameState state_;
+
+    /// The policy playing each seat, or nullptr for the seats of the bot
+    std::vector<std::unique_ptr<Policy>> policies_;
+
+    int turns_ = 0;
+
+    void newGame(const char *line);
+    void attack(const char *line);
+    void endTurn();
+
+    /// Plays the turns of the engine players until it is the turn of the bot or the game is over
+    void playPolicies();
+
+    bool gameOver() const;
+
+    void writeMap();
+    void writeState();
+    void writeAttack(int from, int to, int attack, int defense, bool captured);
+    void writeError(const char *message);
+
+public:
+    explicit BotSession(std::FILE *output);
+
+    /// Processes one command and writes the answers. Returns false when the client asks to quit or the
+    /// output is closed
+    bool processLine(const char *line);
+};
+
+#endif // BOTSESSION_H
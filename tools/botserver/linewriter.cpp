@@ -0,0 +1,118 @@
+#include "linewriter.h"
+
+#include <cstring>
+
+LineWriter::LineWriter(std::size_t capacity)
+{
+    buffer_.reserve(capacity);
+}
+
+void LineWriter::separator()
+{
+    if (needComma_) buffer_.push_back(',');
+    needComma_ = true;
+}
+
+void LineWriter::append(const char *text)
+{
+    buffer_.insert(buffer_.end(), text, text + std::strlen(text));
+}
+
+void LineWriter::appendString(const char *text)
+{
+    // Only the names and messages of the server are written, which never need escaping
+    buffer_.push_back('"');
+    append(text);
+    buffer_.push_back('"');
+}
+
+void LineWriter::begin(const char *type)
+{
+    buffer_.push_back('{');
+    needComma_ = false;
+    field("type", type);
+}
+
+void LineWriter::end()
+{
+    buffer_.push_back('}');
+    buffer_.push_back('\n');
+    needComma_ = false;
+}
+
+void LineWriter::field(const char *key, int value)
+{
+    separator();
+    appendString(key);
+    buffer_.push_back(':');
+    needComma_ = false;
+    this->value(value);
+}
+
+void LineWriter::field(const char *key, bool value)
+{
+    separator();
+    appendString(key);
+    buffer_.push_back(':');
+    append(value ? "true" : "false");
+}
+
+void LineWriter::field(const char *key, const char *value)
+{
+    separator();
+    appendString(key);
+    buffer_.push_back(':');
+    appendString(value);
+}
+
+void LineWriter::beginArray(const char *key)
+{
+    separator();
+    if (key)
+    {
+        appendString(key);
+        buffer_.push_back(':');
+    }
+    buffer_.push_back('[');
+    needComma_ = false;
+}
+
+void LineWriter::endArray()
+{
+    buffer_.push_back(']');
+    needComma_ = true;
+}
+
+void LineWriter::value(int value)
+{
+    separator();
+
+    // Written by hand instead of with snprintf, as most of a message is made of small integers
+    char digits[12];
+    auto count = 0;
+    auto magnitude = value < 0 ? -static_cast<long long>(value) : static_cast<long long>(value);
+    do
+    {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (value < 0) buffer_.push_back('-');
+    while (count > 0) buffer_.push_back(digits[--count]);
+}
+
+void LineWriter::value(float value)
+{
+    separator();
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3f", static_cast<double>(value));
+    append(text);
+}
+
+bool LineWriter::flush(std::FILE *file)
+{
+    const auto size = buffer_.size();
+    const auto written = size == 0 || std::fwrite(buffer_.data(), 1, size, file) == size;
+    buffer_.clear();
+    return written && std::fflush(file) == 0;
+}
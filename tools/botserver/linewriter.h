@@ -0,0 +1,46 @@
+#ifndef LINEWRITER_H
+#define LINEWRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/// Builds JSON objects one line at a time in a buffer that is reused between messages, so once it has
+/// grown to the size of the largest message, writing does not allocate any memory
+class LineWriter
+{
+    std::vector<char> buffer_;
+
+    /// Whether the next value needs a comma before it
+    bool needComma_ = false;
+
+    void separator();
+    void append(const char *text);
+    void appendString(const char *text);
+
+public:
+    explicit LineWriter(std::size_t capacity = 1 << 16);
+
+    /// Starts a message with the given type, i.e. {"type":"<type>"
+    void begin(const char *type);
+
+    /// Finishes the message with a closing brace and a line break
+    void end();
+
+    void field(const char *key, int value);
+    void field(const char *key, bool value);
+    void field(const char *key, const char *value);
+
+    /// Starts an array, which is a field of the message if the key is not null, or an element of the
+    /// current array otherwise
+    void beginArray(const char *key = nullptr);
+    void endArray();
+
+    void value(int value);
+    void value(float value);
+
+    /// Writes all the finished messages to the file and empties the buffer
+    bool flush(std::FILE *file);
+};
+
+#endif // LINEWRITER_H
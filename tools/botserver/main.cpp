@@ -0,0 +1,90 @@
+// Lets bots written in any language play the game through a line-delimited JSON protocol (see
+// BotSession), either over stdin/stdout or over a local socket.
+//
+//   botserver                      reads commands from stdin and answers on stdout
+//   botserver --socket /tmp/dw     accepts one client at a time on a Unix domain socket
+
+#include "botsession.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    /// Longest command accepted. They are all flat objects with a few fields, so this is plenty
+    constexpr int MAX_LINE = 4096;
+
+    void serve(std::FILE *input, std::FILE *output)
+    {
+        BotSession session(output);
+        char line[MAX_LINE];
+        while (std::fgets(line, sizeof(line), input))
+        {
+            if (line[0] == '\n' || line[0] == '\r') continue;
+            if (!session.processLine(line)) break;
+        }
+    }
+
+#ifndef _WIN32
+    int serveSocket(const char *path)
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (std::strlen(path) >= sizeof(address.sun_path))
+        {
+            std::fprintf(stderr, "Socket path too long: %s\n", path);
+            return 1;
+        }
+        std::strcpy(address.sun_path, path);
+
+        const auto server = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(path);
+        if (server < 0 || bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(server, 1) != 0)
+        {
+            std::fprintf(stderr, "Could not listen on %s\n", path);
+            return 1;
+        }
+
+        for (;;)
+        {
+            const auto client = accept(server, nullptr, nullptr);
+            if (client < 0) continue;
+
+            // Separate streams for reading and writing, each of them owning its own descriptor
+            auto input = fdopen(client, "r");
+            auto output = fdopen(dup(client), "w");
+            if (input && output) serve(input, output);
+            if (input) std::fclose(input);
+            if (output) std::fclose(output);
+        }
+    }
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    const char *socketPath = nullptr;
+    for (auto i = 1; i + 1 < argc; i += 2)
+    {
+        if (!std::strcmp(argv[i], "--socket")) socketPath = argv[i + 1];
+    }
+
+    if (socketPath)
+    {
+#ifndef _WIN32
+        return serveSocket(socketPath);
+#else
+        std::fprintf(stderr, "Local sockets are not supported on this platform\n");
+        return 1;
+#endif
+    }
+
+    serve(stdin, stdout);
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Hosts many concurrent headless games on a work-stealing pool and reports the throughput, the queue
+// depth and the latency of every turn. With --scaling, the same games are played with 1, 2, 4... threads
+// up to --threads to check the throughput grows linearly with the cores.
+//
+//   gamehost [--games 2000] [--threads N] [--maps 50] [--seed 1] [--seats greedy,greedy,greedy,greedy]
+//            [--scaling 1]
+
+#include "gamehost.h"
+#include "mapgenerator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::vector<std::string> split(const char *text)
+    {
+        std::vector<std::string> parts(1);
+        for (; *text; text++)
+        {
+            if (*text == ',') parts.emplace_back();
+            else parts.back() += *text;
+        }
+        return parts;
+    }
+
+    /// Plays the games and prints a report line. Returns the number of games per second, or a negative
+    /// value if the games could not be created
+    double host(int threads, int games, const std::vector<std::shared_ptr<const MapTopology>> &maps,
+                const std::vector<std::string> &seats, std::uint64_t seed)
+    {
+        GameHost host(threads);
+        for (auto game = 0; game < games; game++)
+        {
+            if (host.addGame(maps[game % maps.size()], seats, seed + game) < 0) return -1;
+        }
+
+        const auto metrics = host.run();
+
+        auto finished = 0;
+        for (auto game = 0; game < games; game++) finished += host.result(game).winner >= 0;
+
+        const auto gamesPerSecond = metrics.games / metrics.seconds;
+        std::printf("%2d threads: %6zu games (%d won) in %6.2f s = %8.1f games/s, %9llu turns, "
+                    "turn p50 %6.1f us p99 %7.1f us max %8.1f us, queue depth mean %.1f max %zu, %zu steals\n",
+                    threads, metrics.games, finished, metrics.seconds, gamesPerSecond,
+                    static_cast<unsigned long long>(metrics.steps),
+                    metrics.stepLatency.percentile(0.5) / 1000, metrics.stepLatency.percentile(0.99) / 1000,
+                    metrics.stepLatency.max() / 1000.0, metrics.meanQueueDepth, metrics.maxQueueDepth, metrics.steals);
+        return gamesPerSecond;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    auto games = 2000;
+    auto threads = static_cast<int>(std::thread::hardware_concurrency());
+    auto mapCount = 50;
+    std::uint64_t seed = 1;
+    auto scaling = false;
+    std::vector<std::string> seats = {"greedy", "greedy", "greedy", "greedy"};
+
+    for (auto i = 1; i + 1 < argc; i += 2)
+    {
+        if (!std::strcmp(argv[i], "--games")) games = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--threads")) threads = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--maps")) mapCount = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--seed")) seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--seats")) seats = split(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--scaling")) scaling = std::atoi(argv[i + 1]) != 0;
+    }
+
+    if (threads < 1) threads = 1;
+    if (games < 1 || mapCount < 1)
+    {
+        std::fprintf(stderr, "At least 1 game and 1 map are needed\n");
+        return 1;
+    }
+
+    std::vector<std::shared_ptr<const MapTopology>> maps;
+    for (auto i = 0; i < mapCount; i++) maps.push_back(generateGrowthMap(MapSettings(), seed + i));
+
+    std::vector<int> threadCounts;
+    if (scaling)
+    {
+        for (auto count = 1; count < threads; count *= 2) threadCounts.push_back(count);
+    }
+    threadCounts.push_back(threads);
+
+    double baseline = 0;
+    for (auto count : threadCounts)
+    {
+        const auto gamesPerSecond = host(count, games, maps, seats, seed);
+        if (gamesPerSecond < 0)
+        {
+            std::fprintf(stderr, "Invalid seats\n");
+            return 1;
+        }
+
+        if (baseline == 0) baseline = gamesPerSecond;
+        else std::printf("%2d threads: speedup %.2fx\n", count, gamesPerSecond / baseline);
+    }
+
+    return 0;
+}
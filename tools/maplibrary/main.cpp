@@ -0,0 +1,130 @@
+// Generates maps with the same settings as Game.qml, keeps the ones passing the quality checks and writes
+// them into a map library that HexGrid can load instead of generating a new map for every game.
+//
+//   maplibrary --output maps.dwl [--count 5000] [--seed 1] [--width 60] [--height 40]
+//              [--territories 80] [--size 25]
+
+#include "maplibrary.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    enum Check
+    {
+        Passed,
+        TooFewTerritories,
+        Disconnected,
+        Unbalanced,
+        CheckCount
+    };
+
+    const char *CHECK_NAMES[CheckCount] = {"passed", "too few territories", "disconnected", "unbalanced"};
+
+    /// At least this share of the requested territories must survive the removal of the small ones
+    constexpr double MIN_TERRITORY_RATIO = 0.9;
+
+    /// Territories smaller than this share of the requested size are too easy to capture and hold
+    constexpr double MIN_AVERAGE_SIZE_RATIO = 0.8;
+
+    Check check(const MapTopology &map, const MapSettings &settings)
+    {
+        const auto count = map.territoryCount();
+        if (count < settings.numTerritories * MIN_TERRITORY_RATIO) return TooFewTerritories;
+
+        // Every territory must be reachable from any other one, or some players could never be defeated
+        std::vector<bool> visited(count);
+        std::vector<int> stack(1, 0);
+        visited[0] = true;
+        auto reached = 1;
+        while (!stack.empty())
+        {
+            const auto terr = stack.back();
+            stack.pop_back();
+            for (auto neighbour : map.neighbours(terr))
+            {
+                if (visited[neighbour]) continue;
+                visited[neighbour] = true;
+                reached++;
+                stack.push_back(neighbour);
+            }
+        }
+        if (reached != count) return Disconnected;
+
+        auto cells = 0;
+        for (auto terr = 0; terr < count; terr++) cells += map.cellCount(terr);
+        if (cells < count * settings.territorySize * MIN_AVERAGE_SIZE_RATIO) return Unbalanced;
+
+        return Passed;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    MapSettings settings;
+    auto count = 5000;
+    std::uint64_t seed = 1;
+    const char *output = nullptr;
+
+    for (auto i = 1; i + 1 < argc; i += 2)
+    {
+        if (!std::strcmp(argv[i], "--output")) output = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--count")) count = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--seed")) seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--width")) settings.width = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--height")) settings.height = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--territories")) settings.numTerritories = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--size")) settings.territorySize = std::atoi(argv[i + 1]);
+    }
+
+    if (!output || count <= 0)
+    {
+        std::fprintf(stderr, "An output file and a positive number of maps are needed\n");
+        return 1;
+    }
+
+    const auto start = Clock::now();
+    std::vector<std::shared_ptr<const MapTopology>> maps;
+    maps.reserve(count);
+    int results[CheckCount] = {};
+
+    // Giving up eventually, in case the settings can never produce a valid map
+    const auto maxAttempts = count * 20;
+    for (auto attempt = 0; attempt < maxAttempts && static_cast<int>(maps.size()) < count; attempt++)
+    {
+        auto map = generateGrowthMap(settings, seed + attempt);
+        if (!map) break;
+
+        const auto result = check(*map, settings);
+        results[result]++;
+        if (result == Passed) maps.push_back(std::move(map));
+    }
+
+    for (auto i = 0; i < CheckCount; i++) std::fprintf(stderr, "%s: %d\n", CHECK_NAMES[i], results[i]);
+
+    if (static_cast<int>(maps.size()) < count)
+    {
+        std::fprintf(stderr, "Only %zu maps passed the checks\n", maps.size());
+        return 1;
+    }
+
+    if (!MapLibrary::write(output, settings, maps))
+    {
+        std::fprintf(stderr, "Could not write %s\n", output);
+        return 1;
+    }
+
+    std::fprintf(stderr, "Wrote %d maps to %s in %.0f ms\n", count, output, elapsedMs(start));
+    return 0;
+}
@@ -0,0 +1,11 @@
+TEMPLATE = app
+
+TARGET = maplibrary
+
+CONFIG += console
+CONFIG -= qt app_bundle
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,169 @@
+#include "boardpainter.h"
+
+#include "hexcoord.h"
+#include "rules.h"
+
+#include <QPainter>
+#include <QtMath>
+
+#include <algorithm>
+
+namespace
+{
+    /// Distance between the centers of two cells of the same row, and between two rows, in the board of the game
+    constexpr auto HORIZONTAL_SPACING = HexCoord(1, 0).centerX<qreal>(BoardPainter::RADIUS);
+    constexpr auto VERTICAL_SPACING = HexCoord(0, 1).centerY<qreal>(BoardPainter::RADIUS);
+
+    /// Room above the center of a territory taken by its dice (see Territory)
+    constexpr qreal DICE_HEIGHT = BoardPainter::DICE_SIZE * 2.5;
+}
+
+BoardPainter::BoardPainter(std::shared_ptr<const MapTopology> map, const QVector<QImage> &dice, qreal radius)
+    : map_(std::move(map)), dice_(dice), scale_(radius / RADIUS),
+      origin_(HORIZONTAL_SPACING / 2, DICE_HEIGHT + RADIUS)
+{
+    // The territories at the bottom show their dice above the ones at the top, like in the game
+    order_.resize(static_cast<std::size_t>(map_->territoryCount()));
+    for (auto i = 0; i < map_->territoryCount(); i++) order_[static_cast<std::size_t>(i)] = i;
+    std::stable_sort(order_.begin(), order_.end(), [this](int first, int second)
+    {
+        return map_->center(first).y < map_->center(second).y;
+    });
+}
+
+QSize BoardPainter::imageSize() const
+{
+    const auto width = HORIZONTAL_SPACING * (map_->width() + 0.5);
+    const auto height = origin_.y() + VERTICAL_SPACING * (map_->height() - 1) + RADIUS;
+    return QSize(qCeil(width * scale_), qCeil(height * scale_));
+}
+
+QColor BoardPainter::playerColor(int player)
+{
+    switch (player)
+    {
+        case 0: return QColor::fromRgb(213, 2, 2);      // red
+        case 1: return QColor::fromRgb(2, 117, 2);      // dark green
+        case 2: return QColor::fromRgb(245, 245, 15);   // yellow
+        case 3: return QColor::fromRgb(2, 230, 230);    // cyan
+        case 4: return QColor::fromRgb(117, 2, 230);    // purple
+        case 5: return QColor::fromRgb(255, 35, 150);   // pink
+        case 6: return QColor::fromRgb(117, 230, 2);    // light green
+        case 7: return QColor::fromRgb(230, 127, 2);    // orange
+        default: return Qt::black;
+    }
+}
+
+void BoardPainter::paint(QImage &image, const std::int8_t *owners, const std::uint8_t *dice, int from, int to) const
+{
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.scale(scale_, scale_);
+    painter.translate(origin_);
+
+    paintCells(painter, owners, from, to);
+    paintDice(painter, owners, dice);
+}
+
+void BoardPainter::paintCells(QPainter &painter, const std::int8_t *owners, int from, int to) const
+{
+    // The vertices of a hexagon centered at the origin; 7 because the hexagon must be closed
+    QPointF corners[7];
+    for (auto i = 0; i < 7; i++)
+    {
+        const auto angle = (60.0*i - 30)*M_PI/180;
+        corners[i] = QPointF(RADIUS * qCos(angle), RADIUS * qSin(angle));
+    }
+
+    const auto width = map_->width();
+    const auto height = map_->height();
+    auto territoryAt = [this, owners](HexCoord cell)
+    {
+        const auto terr = map_->cellTerritory(cell.column(), cell.row());
+        return terr >= 0 && owners[terr] >= 0 ? terr : -1;
+    };
+
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    QPointF vertices[7];
+    for (auto y = 0; y < height; y++)
+    {
+        for (auto x = 0; x < width; x++)
+        {
+            const auto cell = HexCoord::fromOffset(x, y);
+            const auto terr = territoryAt(cell);
+            if (terr < 0) continue;
+
+            const auto selected = terr == from || terr == to;
+            const auto color = selected ? QColor(Qt::black) : playerColor(owners[terr]).lighter();
+            painter.setPen(QPen(color, 2)); // Same trick as the game, so that no gaps are shown between cells
+            painter.setBrush(color);
+
+            const QPointF center(cell.centerX(RADIUS), cell.centerY(RADIUS));
+            for (auto i = 0; i < 7; i++) vertices[i] = center + corners[i];
+            painter.drawPolygon(vertices, 7);
+        }
+    }
+
+    // As in the game, the borders of the selected territories go last so that they are shown above the rest
+    painter.setBrush(Qt::transparent);
+    for (auto selected : {false, true})
+    {
+        painter.setPen(QPen(selected ? Qt::red : Qt::black, 2));
+
+        for (auto y = 0; y < height; y++)
+        {
+            for (auto x = 0; x < width; x++)
+            {
+                const auto cell = HexCoord::fromOffset(x, y);
+                const auto terr = territoryAt(cell);
+                if (terr < 0 || (terr == from || terr == to) != selected) continue;
+
+                const QPointF center(cell.centerX(RADIUS), cell.centerY(RADIUS));
+                for (auto i = 0; i < HexCoord::DIRECTION_COUNT; i++)
+                {
+                    const auto neighbour = cell.neighbour(i);
+                    if (!neighbour.isInside(width, height) || territoryAt(neighbour) != terr)
+                    {
+                        painter.drawLine(center + corners[i], center + corners[i+1]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void BoardPainter::paintDice(QPainter &painter, const std::int8_t *owners, const std::uint8_t *dice) const
+{
+    // The same piles as Territory::paint, relative to the item of the territory
+    constexpr auto heightFactor = 0.54;
+    constexpr auto widthFactor = 0.55;
+    constexpr auto maxDice = StandardRules::MAX_DICE;
+
+    for (auto terr : order_)
+    {
+        const auto owner = owners[terr];
+        if (owner < 0 || owner >= dice_.size()) continue;
+
+        const auto &image = dice_.at(owner);
+        const auto count = qBound(1, static_cast<int>(dice[terr]), maxDice);
+        const auto center = map_->center(terr);
+        const QPointF item(center.x * RADIUS - DICE_SIZE * 0.9, center.y * RADIUS - DICE_HEIGHT);
+
+        auto startX = DICE_SIZE * 1.8 * 0.5 - DICE_SIZE * widthFactor;
+        const auto startY = DICE_SIZE * 2.0;
+        for (auto i = maxDice / 2; i < count; i++)
+        {
+            const auto y = static_cast<int>(startY - DICE_SIZE * 0.3 - (i - maxDice / 2.0) * DICE_SIZE * heightFactor);
+            painter.drawImage(QRectF(item + QPointF(static_cast<int>(startX), y), QSizeF(DICE_SIZE, DICE_SIZE)), image);
+        }
+        startX += DICE_SIZE * widthFactor;
+        for (auto i = 0; i < maxDice / 2 && i < count; i++)
+        {
+            const auto y = static_cast<int>(startY - i * DICE_SIZE * heightFactor);
+            painter.drawImage(QRectF(item + QPointF(static_cast<int>(startX), y), QSizeF(DICE_SIZE, DICE_SIZE)), image);
+        }
+    }
+}
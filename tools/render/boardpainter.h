@@ -0,0 +1,61 @@
+#ifndef BOARDPAINTER_H
+#define BOARDPAINTER_H
+
+#include "maptopology.h"
+
+#include <QColor>
+#include <QImage>
+#include <QPointF>
+#include <QSize>
+#include <QVector>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class QPainter;
+
+/// Paints positions of a map into images, looking like the board of the game: the cells in the light color of
+/// their owner, the borders of the territories and the piles of dice. Only QPainter on a QImage is used, so it
+/// needs no window, no GPU and not even a QGuiApplication.
+///
+/// Nothing is changed by paint(), so a single painter can be shared by any number of threads, each painting
+/// into its own image
+class BoardPainter
+{
+public:
+    /// The dice image of each player, in the order of their numbers. Cells are painted with the given radius,
+    /// and everything else is scaled along with them
+    BoardPainter(std::shared_ptr<const MapTopology> map, const QVector<QImage> &dice, qreal radius = RADIUS);
+
+    /// Size of the images painted for the map, which must be at least this big
+    QSize imageSize() const;
+
+    /// Paints the position, given as the owner (-1 for none) and the dice of every territory. The territories
+    /// of the move about to be made, if any, are shown selected like the game does
+    void paint(QImage &image, const std::int8_t *owners, const std::uint8_t *dice, int from = -1, int to = -1) const;
+
+    /// Sizes of the board of the game, in pixels
+    static constexpr qreal RADIUS = 10;
+    static constexpr int DICE_SIZE = 28;
+
+    /// The color of each player in the game (see Player). The cells use a lighter version of it
+    static QColor playerColor(int player);
+
+private:
+    std::shared_ptr<const MapTopology> map_;
+    QVector<QImage> dice_;
+    qreal scale_;
+
+    /// Where the center of the cell at column 0 and row 0 is painted, before scaling. The margin above the
+    /// board leaves room for the piles of dice of the top territories
+    QPointF origin_;
+
+    /// The territories from the top of the board to the bottom, the order in which their dice are painted
+    std::vector<int> order_;
+
+    void paintCells(QPainter &painter, const std::int8_t *owners, int from, int to) const;
+    void paintDice(QPainter &painter, const std::int8_t *owners, const std::uint8_t *dice) const;
+};
+
+#endif // BOARDPAINTER_H
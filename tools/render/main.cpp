@@ -0,0 +1,226 @@
+// Renders positions recorded by the selfplay tool into PNG images, using all the cores and without any window,
+// GPU or display server: either every position of a game, as a replay, or a range of the records, e.g. to
+// sample thousands of positions for QA.
+//
+//   render --positions positions.dwp --seed S [--game G | --first 0 --count 100 --every 1]
+//          [--frames dir] [--sheet sheet.png --columns 8 --thumb 320] [--radius 10] [--threads N]
+//
+// The file only stores the adjacency of the maps, so the maps are generated again from the seed given to
+// selfplay and checked against it. Frames are numbered in the order they were selected (frame_000000.png,
+// ...), so a replay can be encoded into a video as it is. No text is drawn, so the same records give the
+// same images on any machine
+
+#include "boardpainter.h"
+#include "mapgenerator.h"
+#include "positionwriter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    /// Whether the generated map is the one the positions were played on
+    bool matches(const MapTopology &map, const PositionFile::Map &stored)
+    {
+        if (!stored.isValid() || stored.territoryCount != map.territoryCount()) return false;
+
+        for (auto terr = 0; terr < map.territoryCount(); terr++)
+        {
+            const auto neighbours = map.neighbours(terr);
+            const auto first = stored.neighbourOffsets[terr];
+            if (stored.neighbourOffsets[terr + 1] - first != static_cast<std::uint32_t>(neighbours.size())) return false;
+            if (!std::equal(neighbours.begin(), neighbours.end(), stored.neighbours + first)) return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *positionsPath = nullptr;
+    const char *framesPath = nullptr;
+    const char *sheetPath = nullptr;
+    std::uint64_t seed = 1;
+    long long game = -1;
+    std::uint64_t first = 0;
+    std::uint64_t count = 100;
+    std::uint64_t every = 1;
+    auto columns = 8;
+    auto thumbWidth = 320;
+    qreal radius = BoardPainter::RADIUS;
+    auto threadCount = static_cast<int>(std::thread::hardware_concurrency());
+
+    for (auto i = 1; i + 1 < argc; i += 2)
+    {
+        if (!std::strcmp(argv[i], "--positions")) positionsPath = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--seed")) seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--game")) game = std::atoll(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--first")) first = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--count")) count = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--every")) every = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--frames")) framesPath = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--sheet")) sheetPath = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--columns")) columns = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--thumb")) thumbWidth = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--radius")) radius = std::atof(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--threads")) threadCount = std::atoi(argv[i + 1]);
+    }
+
+    if (threadCount < 1) threadCount = 1;
+    if (!positionsPath || (!framesPath && !sheetPath) || every < 1 || columns < 1 || thumbWidth < 1 || radius <= 0)
+    {
+        std::fprintf(stderr, "Usage: render --positions positions.dwp --seed S [--game G | --first 0 --count 100 --every 1]\n"
+                             "              [--frames dir] [--sheet sheet.png --columns 8 --thumb 320] [--radius 10] [--threads N]\n");
+        return 1;
+    }
+
+    // The file is mapped instead of read, so only the pages of the records rendered are loaded from disk
+    QFile file(QString::fromLocal8Bit(positionsPath));
+    const auto data = file.open(QIODevice::ReadOnly) ? file.map(0, file.size()) : nullptr;
+    const auto positions = data ? PositionFile(data, static_cast<std::size_t>(file.size())) : PositionFile();
+    if (!positions.isValid())
+    {
+        std::fprintf(stderr, "Could not read %s\n", positionsPath);
+        return 1;
+    }
+
+    // The records of a game are written one after another, but the games are not in order
+    std::vector<std::uint64_t> records;
+    if (game >= 0)
+    {
+        for (std::uint64_t i = 0; i < positions.recordCount(); i++)
+        {
+            if (positions.record(i).game == static_cast<std::uint64_t>(game)) records.push_back(i);
+        }
+    }
+    else
+    {
+        for (auto i = first; i < positions.recordCount() && i - first < count; i += every) records.push_back(i);
+    }
+    if (records.empty())
+    {
+        std::fprintf(stderr, "No positions to render\n");
+        return 1;
+    }
+
+    QVector<QImage> dice;
+    for (auto player = 0; player < PositionFile::MAX_PLAYERS; player++)
+    {
+        // The dice shown on the board are the same as in Player::dicePixmap
+        dice.append(QImage(QString(":/pixmaps/Player%1_Dice%2.png").arg(player).arg(player % 6 + 1))
+                    .convertToFormat(QImage::Format_ARGB32_Premultiplied));
+    }
+
+    auto start = Clock::now();
+    std::map<int, std::unique_ptr<BoardPainter>> painters;
+    for (auto index : records)
+    {
+        const auto mapIndex = positions.record(index).map;
+        if (painters.count(mapIndex)) continue;
+
+        // Same maps as selfplay
+        const auto map = generateGrowthMap(MapSettings(), seed + mapIndex);
+        if (!map || !matches(*map, positions.map(mapIndex)))
+        {
+            std::fprintf(stderr, "Map %d does not match the positions; use the seed given to selfplay\n", mapIndex);
+            return 1;
+        }
+        painters[mapIndex].reset(new BoardPainter(map, dice, radius));
+    }
+    std::fprintf(stderr, "Generated %d maps in %.0f ms\n", static_cast<int>(painters.size()), elapsedMs(start));
+
+    const auto frameSize = painters.begin()->second->imageSize();
+    if (framesPath && !QDir().mkpath(QString::fromLocal8Bit(framesPath)))
+    {
+        std::fprintf(stderr, "Could not create %s\n", framesPath);
+        return 1;
+    }
+
+    // Every thread copies its thumbnails straight into their own part of the sheet, so it needs no lock
+    QImage sheet;
+    uchar *sheetBits = nullptr;
+    const auto thumbSize = frameSize.scaled(thumbWidth, frameSize.height() * thumbWidth, Qt::KeepAspectRatio);
+    if (sheetPath)
+    {
+        const auto rows = static_cast<int>((records.size() + columns - 1) / columns);
+        sheet = QImage(thumbSize.width() * columns, thumbSize.height() * rows, QImage::Format_ARGB32_Premultiplied);
+        if (sheet.isNull())
+        {
+            std::fprintf(stderr, "The contact sheet would be too large; use fewer positions or a smaller --thumb\n");
+            return 1;
+        }
+        sheet.fill(Qt::white);
+        sheetBits = sheet.bits();
+    }
+
+    start = Clock::now();
+    std::atomic<std::size_t> next(0);
+    std::atomic<int> failed(0);
+    auto worker = [&]()
+    {
+        QImage frame;
+        for (auto i = next++; i < records.size(); i = next++)
+        {
+            const auto record = positions.record(records[i]);
+            const auto &painter = *painters.at(record.map);
+
+            const auto size = painter.imageSize();
+            if (frame.size() != size) frame = QImage(size, QImage::Format_ARGB32_Premultiplied);
+            painter.paint(frame, record.owners, record.dice, record.from, record.to);
+
+            if (framesPath)
+            {
+                const auto name = QString("%1/frame_%2.png").arg(QString::fromLocal8Bit(framesPath)).arg(i, 6, 10, QChar('0'));
+                if (!frame.save(name)) failed++;
+            }
+
+            if (sheetBits)
+            {
+                const auto thumb = frame.scaled(thumbSize, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                                        .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+                const auto left = static_cast<int>(i % columns) * thumbSize.width();
+                const auto top = static_cast<int>(i / columns) * thumbSize.height();
+                for (auto y = 0; y < thumb.height(); y++)
+                {
+                    std::memcpy(sheetBits + (top + y) * sheet.bytesPerLine() + left * 4, thumb.constScanLine(y),
+                                static_cast<std::size_t>(thumb.width()) * 4);
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (auto i = 1; i < threadCount; i++) threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads) thread.join();
+
+    if (sheetPath && !sheet.save(QString::fromLocal8Bit(sheetPath))) failed++;
+    std::fprintf(stderr, "Rendered %d positions (%dx%d) on %d threads in %.1f s\n", static_cast<int>(records.size()),
+                 frameSize.width(), frameSize.height(), threadCount, elapsedMs(start) / 1000);
+
+    if (failed > 0)
+    {
+        std::fprintf(stderr, "Could not write %d images\n", failed.load());
+        return 1;
+    }
+    return 0;
+}
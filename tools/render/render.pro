@@ -0,0 +1,22 @@
+TEMPLATE = app
+
+TARGET = render
+
+# Only QImage and QPainter are used, on the raster engine, so no window nor display server is needed
+QT = core gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+    main.cpp \
+    boardpainter.cpp
+
+HEADERS += \
+    boardpainter.h
+
+# The pictures of the dice of the game
+RESOURCES += \
+    ../../app/pixmaps/pixmaps.qrc
@@ -0,0 +1,145 @@
+// Plays AI configurations against each other on seeded maps, using all the cores, and records every position
+// of the games into a PositionFile for training evaluators offline.
+//
+//   selfplay --output positions.dwp [--games 1000] [--ai greedy --ai search:depth=1] [--players 4]
+//            [--maps 50] [--threads N] [--seed S] [--block 4096]
+//
+// The configurations take the seats in turns, shifting by one seat every game, so each of them plays every
+// seat equally often
+
+#include "mapgenerator.h"
+#include "match.h"
+#include "policy.h"
+#include "positionwriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> configs;
+    auto games = 1000;
+    auto players = 4;
+    auto mapCount = 50;
+    auto blockSize = PositionWriter::DEFAULT_BLOCK_SIZE;
+    auto threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    std::uint64_t seed = 1;
+    const char *output = nullptr;
+
+    for (auto i = 1; i + 1 < argc; i += 2)
+    {
+        if (!std::strcmp(argv[i], "--output")) output = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--games")) games = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--ai")) configs.push_back(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--players")) players = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--maps")) mapCount = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--threads")) threadCount = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--seed")) seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--block")) blockSize = std::atoi(argv[i + 1]);
+    }
+
+    if (configs.empty()) configs = {"greedy"};
+    if (threadCount < 1) threadCount = 1;
+    if (!output || games < 1 || blockSize < 1 || mapCount < 1 || mapCount > 0xffff || players < 2 || players > GameState::MAX_PLAYERS)
+    {
+        std::fprintf(stderr, "Usage: selfplay --output positions.dwp [--games 1000] [--ai greedy] [--players 4] [--maps 50]\n"
+                             "                [--threads N] [--seed S] [--block 4096]\n");
+        return 1;
+    }
+
+    for (const auto &config : configs)
+    {
+        if (!createPolicy(config, generateGrowthMap(MapSettings(), 1), 0))
+        {
+            std::fprintf(stderr, "Invalid AI configuration: %s\n", config.c_str());
+            return 1;
+        }
+    }
+
+    auto start = Clock::now();
+    std::vector<std::shared_ptr<const MapTopology>> maps;
+    auto territoryStride = 1;
+    for (auto i = 0; i < mapCount; i++)
+    {
+        maps.push_back(generateGrowthMap(MapSettings(), seed + i));
+        territoryStride = std::max(territoryStride, maps.back()->territoryCount());
+    }
+    std::fprintf(stderr, "Generated %d maps in %.0f ms\n", mapCount, elapsedMs(start));
+
+    PositionWriter writer;
+    if (!writer.open(output, territoryStride, blockSize))
+    {
+        std::fprintf(stderr, "Could not open %s\n", output);
+        return 1;
+    }
+    for (const auto &map : maps) writer.addMap(*map);
+
+    // Every thread records its games into its own batch, and only hands it to the writer once it is over
+    start = Clock::now();
+    std::atomic<int> next(0);
+    auto worker = [&]()
+    {
+        PositionBatch batch(territoryStride);
+        std::vector<std::unique_ptr<Policy>> owned;
+        std::vector<Policy *> policies;
+        for (auto game = next++; game < games; game = next++)
+        {
+            const auto mapIndex = game % mapCount;
+            const auto &map = maps[mapIndex];
+            const auto gameSeed = seed * 1000003 + static_cast<std::uint64_t>(game);
+
+            owned.clear();
+            policies.clear();
+            for (auto seat = 0; seat < players; seat++)
+            {
+                const auto &config = configs[(seat + game) % configs.size()];
+                owned.push_back(createPolicy(config, map, gameSeed + seat));
+                policies.push_back(owned.back().get());
+            }
+
+            Match match(map);
+            batch.reset(static_cast<std::uint32_t>(game), static_cast<std::uint16_t>(mapIndex));
+            match.setObserver([&batch, &match](const GameState &state, int from, int to)
+            {
+                batch.add(state, match.result().turns, from, to);
+            });
+
+            const auto result = match.play(policies, gameSeed);
+            batch.setWinner(result.winner);
+            writer.submit(std::move(batch));
+            batch = PositionBatch(territoryStride);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (auto i = 1; i < threadCount; i++) threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads) thread.join();
+
+    const auto records = writer.recordCount();
+    if (!writer.close())
+    {
+        std::fprintf(stderr, "Could not write %s\n", output);
+        return 1;
+    }
+    std::fprintf(stderr, "Recorded %llu positions of %d games on %d threads in %.1f s\n",
+                 static_cast<unsigned long long>(records), games, threadCount, elapsedMs(start) / 1000);
+    return 0;
+}
@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+SUBDIRS = tournament \
+    maplibrary \
+    botserver \
+    gamehost \
+    selfplay \
+    render
@@ -0,0 +1,344 @@
+// Plays AI configurations against each other on many seeded maps, using all the cores, and writes their
+// Elo ratings with confidence intervals as CSV.
+//
+//   tournament --ai greedy --ai search:depth=1 --ai search:depth=2 --players 4 --maps 20
+//              [--schedule round-robin|swiss] [--rounds 3] [--threads N] [--seed S]
+//              [--bootstrap 200] [--output ratings.csv] [--games games.csv] [--telemetry telemetry.json]
+//
+// Every pair of configurations plays each map once per rotation of the seats, with each configuration
+// holding half of them (with an odd number of players, twice per rotation, each holding the extra seat
+// once), so both hold as many seats and go first equally often (GameState::setup picks the first player
+// from the seed, like HexGrid::initializeGrid does)
+
+#include "gametelemetry.h"
+#include "mapgenerator.h"
+#include "match.h"
+#include "policy.h"
+#include "ratings.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    struct Game
+    {
+        int map = 0;
+        std::uint64_t seed = 0;
+
+        /// Configuration playing each seat
+        std::vector<int> seats;
+
+        MatchResult result;
+    };
+
+    struct Tournament
+    {
+        std::vector<std::string> configs;
+        std::vector<std::shared_ptr<const MapTopology>> maps;
+        int players = 4;
+        int threads = 1;
+        std::uint64_t seed = 1;
+        std::vector<Game> games;
+
+        /// Counters of all the games, only collected when requested
+        GameTelemetry *telemetry = nullptr;
+    };
+
+    /// Adds the games of a pairing: every map, with every rotation of the seats. With an odd number of
+    /// players, every rotation is played twice, with each configuration holding the extra seat once
+    void schedulePair(Tournament &tournament, int a, int b)
+    {
+        const auto players = tournament.players;
+        const auto rotations = players % 2 == 0 ? players : 2 * players;
+        for (auto map = 0; map < static_cast<int>(tournament.maps.size()); map++)
+        {
+            for (auto rotation = 0; rotation < rotations; rotation++)
+            {
+                const auto first = rotation < players ? a : b;
+                const auto second = rotation < players ? b : a;
+
+                Game game;
+                game.map = map;
+                game.seed = tournament.seed * 1000003 + static_cast<std::uint64_t>(map);
+                game.seats.resize(players);
+                for (auto seat = 0; seat < players; seat++) game.seats[seat] = (seat + rotation) % players < players / 2 ? first : second;
+                tournament.games.push_back(std::move(game));
+            }
+        }
+    }
+
+    /// Plays the games in [begin, end) on all the threads. Every game has its own policies and state, so
+    /// the threads only share the read-only maps. Each thread counts its own telemetry, which is added to the
+    /// tournament's once it has finished
+    void playGames(Tournament &tournament, std::size_t begin, std::size_t end)
+    {
+        std::atomic<std::size_t> next(begin);
+        std::vector<GameTelemetry> telemetry(tournament.telemetry ? tournament.threads : 0);
+        auto worker = [&tournament, &next, &telemetry, end](int thread)
+        {
+            std::vector<std::unique_ptr<Policy>> owned;
+            std::vector<Policy *> policies;
+            for (auto index = next++; index < end; index = next++)
+            {
+                auto &game = tournament.games[index];
+                const auto &map = tournament.maps[game.map];
+
+                owned.clear();
+                policies.clear();
+                for (auto seat = 0; seat < static_cast<int>(game.seats.size()); seat++)
+                {
+                    owned.push_back(createPolicy(tournament.configs[game.seats[seat]], map, game.seed + seat));
+                    policies.push_back(owned.back().get());
+                }
+
+                Match match(map);
+                if (!telemetry.empty()) match.setTelemetry(&telemetry[thread]);
+                game.result = match.play(policies, game.seed);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (auto i = 1; i < tournament.threads; i++) threads.emplace_back(worker, i);
+        worker(0);
+        for (auto &thread : threads) thread.join();
+
+        for (const auto &counters : telemetry) tournament.telemetry->merge(counters);
+    }
+
+    /// Share of the opponents each configuration outlasted, over all its games
+    std::vector<double> scores(const Tournament &tournament, std::vector<int> *gameCounts = nullptr)
+    {
+        const auto count = tournament.configs.size();
+        std::vector<double> total(count);
+        std::vector<int> seats(count);
+        for (const auto &game : tournament.games)
+        {
+            for (auto seat = 0; seat < tournament.players; seat++)
+            {
+                total[game.seats[seat]] += double(tournament.players - 1 - game.result.placements[seat]) / (tournament.players - 1);
+                seats[game.seats[seat]]++;
+            }
+        }
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (seats[i] > 0) total[i] /= seats[i];
+        }
+
+        if (gameCounts)
+        {
+            gameCounts->assign(count, 0);
+            for (const auto &game : tournament.games)
+            {
+                std::vector<bool> counted(count);
+                for (auto config : game.seats)
+                {
+                    if (!counted[config]) (*gameCounts)[config]++;
+                    counted[config] = true;
+                }
+            }
+        }
+        return total;
+    }
+
+    void roundRobin(Tournament &tournament)
+    {
+        const auto count = static_cast<int>(tournament.configs.size());
+        for (auto a = 0; a < count; a++)
+        {
+            for (auto b = a + 1; b < count; b++) schedulePair(tournament, a, b);
+        }
+        playGames(tournament, 0, tournament.games.size());
+    }
+
+    /// Each round pairs the configurations with the closest scores that have not met yet
+    void swiss(Tournament &tournament, int rounds)
+    {
+        const auto count = static_cast<int>(tournament.configs.size());
+        std::vector<bool> played(count * count);
+
+        for (auto round = 0; round < rounds; round++)
+        {
+            const auto current = scores(tournament);
+            std::vector<int> order(count);
+            for (auto i = 0; i < count; i++) order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&current](int a, int b) { return current[a] > current[b]; });
+
+            const auto begin = tournament.games.size();
+            std::vector<bool> paired(count);
+            for (auto i = 0; i < count; i++)
+            {
+                const auto a = order[i];
+                if (paired[a]) continue;
+
+                // Preferring an opponent not met yet, but repeating one is better than a bye
+                auto opponent = -1;
+                for (auto j = i + 1; j < count; j++)
+                {
+                    const auto b = order[j];
+                    if (paired[b]) continue;
+                    if (opponent < 0) opponent = b;
+                    if (!played[a * count + b])
+                    {
+                        opponent = b;
+                        break;
+                    }
+                }
+                if (opponent < 0) continue;
+
+                paired[a] = paired[opponent] = true;
+                played[a * count + opponent] = played[opponent * count + a] = true;
+                schedulePair(tournament, a, opponent);
+            }
+
+            playGames(tournament, begin, tournament.games.size());
+            std::fprintf(stderr, "Round %d: %zu games\n", round + 1, tournament.games.size() - begin);
+        }
+    }
+
+    void writeGames(const Tournament &tournament, std::FILE *file)
+    {
+        std::fprintf(file, "map,seed,turns,attacks,winner");
+        for (auto seat = 0; seat < tournament.players; seat++) std::fprintf(file, ",seat%d,placement%d", seat, seat);
+        std::fprintf(file, "\n");
+
+        for (const auto &game : tournament.games)
+        {
+            const auto winner = game.result.winner >= 0 ? tournament.configs[game.seats[game.result.winner]] : std::string();
+            std::fprintf(file, "%d,%llu,%d,%d,%s", game.map, static_cast<unsigned long long>(game.seed),
+                         game.result.turns, game.result.attacks, winner.c_str());
+            for (auto seat = 0; seat < tournament.players; seat++)
+            {
+                std::fprintf(file, ",%s,%d", tournament.configs[game.seats[seat]].c_str(), game.result.placements[seat]);
+            }
+            std::fprintf(file, "\n");
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Tournament tournament;
+    auto mapCount = 20;
+    auto rounds = 3;
+    auto bootstrap = 200;
+    auto isSwiss = false;
+    const char *output = nullptr;
+    const char *gamesOutput = nullptr;
+    const char *telemetryOutput = nullptr;
+    GameTelemetry telemetry;
+    tournament.threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    for (auto i = 1; i + 1 < argc; i += 2)
+    {
+        if (!std::strcmp(argv[i], "--ai")) tournament.configs.push_back(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--players")) tournament.players = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--maps")) mapCount = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--schedule")) isSwiss = !std::strcmp(argv[i + 1], "swiss");
+        else if (!std::strcmp(argv[i], "--rounds")) rounds = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--threads")) tournament.threads = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--seed")) tournament.seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--bootstrap")) bootstrap = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--output")) output = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--games")) gamesOutput = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--telemetry")) telemetryOutput = argv[i + 1];
+    }
+    if (telemetryOutput) tournament.telemetry = &telemetry;
+
+    if (tournament.configs.empty()) tournament.configs = {"greedy", "search:depth=1", "search:depth=2"};
+    if (tournament.threads < 1) tournament.threads = 1;
+    if (tournament.players < 2 || tournament.players > GameState::MAX_PLAYERS || mapCount < 1 || tournament.configs.size() < 2)
+    {
+        std::fprintf(stderr, "At least 2 configurations, between 2 and %d players and 1 map are needed\n", GameState::MAX_PLAYERS);
+        return 1;
+    }
+
+    for (std::size_t i = 0; i < tournament.configs.size(); i++)
+    {
+        const auto &config = tournament.configs[i];
+        if (std::find(tournament.configs.begin(), tournament.configs.begin() + i, config) != tournament.configs.begin() + i
+                || !createPolicy(config, generateGrowthMap(MapSettings(), 1), 0))
+        {
+            std::fprintf(stderr, "Invalid or repeated AI configuration: %s\n", config.c_str());
+            return 1;
+        }
+    }
+
+    auto start = Clock::now();
+    for (auto i = 0; i < mapCount; i++) tournament.maps.push_back(generateGrowthMap(MapSettings(), tournament.seed + i));
+    std::fprintf(stderr, "Generated %d maps in %.0f ms\n", mapCount, elapsedMs(start));
+
+    start = Clock::now();
+    if (isSwiss) swiss(tournament, rounds);
+    else roundRobin(tournament);
+    std::fprintf(stderr, "Played %zu games on %d threads in %.1f s\n", tournament.games.size(), tournament.threads, elapsedMs(start) / 1000);
+
+    std::vector<GameOutcome> outcomes;
+    outcomes.reserve(tournament.games.size());
+    for (const auto &game : tournament.games) outcomes.push_back({game.seats, game.result.placements});
+
+    const auto configCount = static_cast<int>(tournament.configs.size());
+    const auto ratings = calculateRatings(outcomes, configCount, bootstrap, tournament.seed);
+    std::vector<int> gameCounts;
+    const auto score = scores(tournament, &gameCounts);
+
+    std::vector<int> wins(configCount);
+    for (const auto &game : tournament.games)
+    {
+        if (game.result.winner >= 0) wins[game.seats[game.result.winner]]++;
+    }
+
+    auto file = output ? std::fopen(output, "w") : stdout;
+    if (!file)
+    {
+        std::fprintf(stderr, "Could not open %s\n", output);
+        return 1;
+    }
+
+    std::vector<int> order(configCount);
+    for (auto i = 0; i < configCount; i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&ratings](int a, int b) { return ratings[a].elo > ratings[b].elo; });
+
+    std::fprintf(file, "config,elo,elo_low,elo_high,games,wins,score\n");
+    for (auto i : order)
+    {
+        std::fprintf(file, "%s,%.1f,%.1f,%.1f,%d,%d,%.3f\n", tournament.configs[i].c_str(), ratings[i].elo,
+                     ratings[i].low, ratings[i].high, gameCounts[i], wins[i], score[i]);
+    }
+    if (file != stdout) std::fclose(file);
+
+    if (gamesOutput)
+    {
+        file = std::fopen(gamesOutput, "w");
+        if (!file)
+        {
+            std::fprintf(stderr, "Could not open %s\n", gamesOutput);
+            return 1;
+        }
+        writeGames(tournament, file);
+        std::fclose(file);
+    }
+
+    if (telemetryOutput && !telemetry.save(telemetryOutput))
+    {
+        std::fprintf(stderr, "Could not write %s\n", telemetryOutput);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "ratings.h"
+
+#include "random.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /// Virtual wins added to both sides of every pair that played, so that a configuration that never lost
+    /// does not get an infinite rating
+    constexpr double PRIOR_WINS = 0.5;
+
+    constexpr int ITERATIONS = 500;
+
+    /// Fits the Bradley-Terry strengths with the MM algorithm and converts them into Elo points
+    std::vector<double> fitElo(const std::vector<double> &wins, int configCount)
+    {
+        std::vector<double> strength(configCount, 1.0);
+        std::vector<double> next(configCount);
+
+        for (auto iteration = 0; iteration < ITERATIONS; iteration++)
+        {
+            for (auto i = 0; i < configCount; i++)
+            {
+                auto totalWins = 0.0;
+                auto denominator = 0.0;
+                for (auto j = 0; j < configCount; j++)
+                {
+                    const auto games = wins[i * configCount + j] + wins[j * configCount + i];
+                    if (i == j || games == 0) continue;
+                    totalWins += wins[i * configCount + j] + PRIOR_WINS;
+                    denominator += (games + 2 * PRIOR_WINS) / (strength[i] + strength[j]);
+                }
+                next[i] = denominator > 0 ? totalWins / denominator : strength[i];
+            }
+
+            // Normalizing to a geometric mean of 1 keeps the ratings centered around 0
+            auto logSum = 0.0;
+            for (auto value : next) logSum += std::log(value);
+            const auto scale = std::exp(-logSum / configCount);
+            for (auto i = 0; i < configCount; i++) strength[i] = next[i] * scale;
+        }
+
+        std::vector<double> elo(configCount);
+        for (auto i = 0; i < configCount; i++) elo[i] = 400 * std::log10(strength[i]);
+        return elo;
+    }
+
+    /// Adds the pairwise results of one game to the win matrix
+    void addGame(const GameOutcome &game, int configCount, std::vector<double> &wins)
+    {
+        const auto seats = static_cast<int>(game.configs.size());
+        for (auto a = 0; a < seats; a++)
+        {
+            for (auto b = 0; b < seats; b++)
+            {
+                if (game.configs[a] == game.configs[b] || game.placements[a] >= game.placements[b]) continue;
+                wins[game.configs[a] * configCount + game.configs[b]] += 1;
+            }
+        }
+    }
+}
+
+std::vector<Rating> calculateRatings(const std::vector<GameOutcome> &games, int configCount, int bootstrapSamples, std::uint64_t seed)
+{
+    std::vector<Rating> ratings(configCount);
+    if (configCount == 0) return ratings;
+
+    std::vector<double> wins(configCount * configCount);
+    for (const auto &game : games) addGame(game, configCount, wins);
+
+    const auto elo = fitElo(wins, configCount);
+    for (auto i = 0; i < configCount; i++) ratings[i].elo = ratings[i].low = ratings[i].high = elo[i];
+    if (games.empty() || bootstrapSamples <= 0) return ratings;
+
+    Random random(seed);
+    const auto gameCount = static_cast<int>(games.size());
+    std::vector<std::vector<double>> samples(configCount);
+    for (auto sample = 0; sample < bootstrapSamples; sample++)
+    {
+        std::fill(wins.begin(), wins.end(), 0.0);
+        for (auto i = 0; i < gameCount; i++) addGame(games[random.bounded(gameCount)], configCount, wins);
+
+        const auto sampleElo = fitElo(wins, configCount);
+        for (auto i = 0; i < configCount; i++) samples[i].push_back(sampleElo[i]);
+    }
+
+    for (auto i = 0; i < configCount; i++)
+    {
+        auto &list = samples[i];
+        std::sort(list.begin(), list.end());
+        ratings[i].low = list[static_cast<std::size_t>(0.025 * (list.size() - 1))];
+        ratings[i].high = list[static_cast<std::size_t>(0.975 * (list.size() - 1))];
+    }
+
+    return ratings;
+}
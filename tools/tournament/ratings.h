@@ -0,0 +1,30 @@
+#ifndef RATINGS_H
+#define RATINGS_H
+
+#include <cstdint>
+#include <vector>
+
+/// Result of one game from the point of view of the ratings: the configuration playing each seat and
+/// the placement it got (0 for the winner)
+struct GameOutcome
+{
+    std::vector<int> configs;
+    std::vector<int> placements;
+};
+
+struct Rating
+{
+    double elo = 0;
+
+    /// Bounds of the 95% confidence interval
+    double low = 0;
+    double high = 0;
+};
+
+/// Calculates Elo ratings with a Bradley-Terry model fitted to the pairwise results inside each game: every
+/// configuration beats the ones it outlasted. The ratings are centered so their average is 0. The confidence
+/// intervals are obtained by resampling whole games with replacement, which keeps the pairs coming from the
+/// same game together
+std::vector<Rating> calculateRatings(const std::vector<GameOutcome> &games, int configCount, int bootstrapSamples, std::uint64_t seed);
+
+#endif // RATINGS_H
@@ -0,0 +1,15 @@
+TEMPLATE = app
+
+TARGET = tournament
+
+CONFIG += console
+CONFIG -= qt app_bundle
+
+include(../../engine/engine.pri)
+
+HEADERS += \
+    ratings.h
+
+SOURCES += \
+    main.cpp \
+    ratings.cpp